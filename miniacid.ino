@@ -1,5 +1,6 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include <M5Cardputer.h>
 #include <SD.h>
 #include <SPI.h>
@@ -8,7 +9,9 @@
 #include <cstdarg>
 #include <cstdio>
 #include "src/ui/miniacid_display.h"
+#include "src/audio/audio_buffer_ring.h"
 #include "src/audio/cardputer_audio_recorder.h"
+#include "src/audio/freertos_render_split.h"
 #include "miniacid_encoder8.h"
 #include "scene_storage_cardputer.h"
 
@@ -19,33 +22,87 @@ MiniAcidDisplay* g_miniDisplay = nullptr;
 SceneStorageCardputer g_sceneStorage;
 CardputerAudioRecorder* g_audioRecorder = nullptr;
 
-int16_t g_audioBuffer[AUDIO_BUFFER_SAMPLES];
+// The speaker plays from these buffers in place and queues one behind the
+// one playing, so a third lets the next block render meanwhile.
+AudioBufferRing<AUDIO_BUFFER_SAMPLES, 3> g_audioRing;
+static constexpr int kSpeakerChannel = 0;
 
 TaskHandle_t g_audioTaskHandle = nullptr;
+// Held by the audio task while it touches the engine, and by the UI for
+// what cannot go through MiniAcid::post(): transport, scene loads and saves,
+// and the recorder. Either side waits for the other to finish its turn.
+SemaphoreHandle_t g_audioMutex = nullptr;
+
+// Renders the drum bus on core 0 while the audio task renders the 303s on
+// core 1. Set to 0 to render everything on core 1.
+#ifndef MINIACID_DUAL_CORE
+#define MINIACID_DUAL_CORE 1
+#endif
+#if MINIACID_DUAL_CORE
+FreeRtosRenderSplit g_renderSplit;
+#endif
 
 MiniAcid g_miniAcid(SAMPLE_RATE, &g_sceneStorage);
 Encoder8Miniacid g_encoder8(g_miniAcid);
 
+void withAudioTaskHeld(const std::function<void()>& fn) {
+  xSemaphoreTake(g_audioMutex, portMAX_DELAY);
+  fn();
+  xSemaphoreGive(g_audioMutex);
+}
+
+void toggleTransport() {
+  withAudioTaskHeld([]() {
+    if (g_miniAcid.isPlaying()) {
+      g_miniAcid.stop();
+    } else {
+      g_miniAcid.start();
+    }
+  });
+}
+
 void audioTask(void *param) {
   while (true) {
     if (!g_miniAcid.isPlaying()) {
+      // Edits made while stopped still need applying.
+      withAudioTaskHeld([]() { g_miniAcid.processCommands(); });
       vTaskDelay(10 / portTICK_PERIOD_MS);
       continue;
     }
 
-    while (M5Cardputer.Speaker.isPlaying()) {
-      vTaskDelay(1 / portTICK_PERIOD_MS);
+    // isPlaying(channel) counts the buffers the speaker still holds: 2 for
+    // one playing and one queued, 1 for just the playing one.
+    g_audioRing.retire(M5Cardputer.Speaker.isPlaying(kSpeakerChannel));
+    int16_t* buffer = g_audioRing.acquire();
+    if (!buffer) {
+      vTaskDelay(1);
+      continue;
     }
 
-    g_miniAcid.generateAudioBuffer(g_audioBuffer, AUDIO_BUFFER_SAMPLES);
+    xSemaphoreTake(g_audioMutex, portMAX_DELAY);
+    // Stopped while this task waited for the lock: nothing to render.
+    if (!g_miniAcid.isPlaying()) {
+      xSemaphoreGive(g_audioMutex);
+      continue;
+    }
+    g_miniAcid.generateAudioBuffer(buffer, AUDIO_BUFFER_SAMPLES);
 
     // Write to recorder if recording
     if (g_audioRecorder) {
-      g_audioRecorder->writeSamples(g_audioBuffer, AUDIO_BUFFER_SAMPLES);
+      g_audioRecorder->writeSamples(buffer, AUDIO_BUFFER_SAMPLES);
     }
-
-    M5Cardputer.Speaker.playRaw(g_audioBuffer, AUDIO_BUFFER_SAMPLES,
-                                SAMPLE_RATE, false);
+    xSemaphoreGive(g_audioMutex);
+
+    // A queued buffer still has a whole block of playing time ahead of it,
+    // so wait for the slot a quarter block at a time rather than every tick.
+    uint32_t sampleRate = static_cast<uint32_t>(g_miniAcid.sampleRate());
+    TickType_t waitTicks = pdMS_TO_TICKS(AUDIO_BUFFER_SAMPLES * 250 / sampleRate);
+    if (waitTicks < 1) waitTicks = 1;
+    while (M5Cardputer.Speaker.isPlaying(kSpeakerChannel) >= 2) {
+      vTaskDelay(waitTicks);
+    }
+    M5Cardputer.Speaker.playRaw(buffer, AUDIO_BUFFER_SAMPLES, sampleRate, false, 1, kSpeakerChannel, false);
+    g_audioRing.submit();
   }
 }
 
@@ -67,20 +124,28 @@ void setup() {
   M5Cardputer.Speaker.begin();
   M5Cardputer.Speaker.setVolume(200); // 0-255
 
+  g_audioMutex = xSemaphoreCreateMutex();
   g_miniAcid.init();
+  // 64 KB of 16-bit hits covers the short 808 voices (hats, rim, snare);
+  // longer hits, and everything if the heap is short, stay synthesized.
+  g_miniAcid.enableDrumHitCache(32768);
   g_miniDisplay = new MiniAcidDisplay(g_display, g_miniAcid);
   
-  // Set audio guard to protect audio task from concurrent access
-  g_miniDisplay->setAudioGuard([](const std::function<void()>& fn) {
-    // On Cardputer, we need to suspend/resume the audio task or use a mutex
-    // For now, just call the function directly since FreeRTOS handles this
-    fn();
-  });
+  // Pattern, mute and parameter edits reach the audio task through
+  // MiniAcid::post(); the guard covers scene loads and saves and the
+  // recorder, which the audio task must not see half done.
+  g_miniDisplay->setAudioGuard(withAudioTaskHeld);
   
   // Initialize audio recorder (done after other initialization to avoid boot issues)
   g_audioRecorder = new CardputerAudioRecorder();
   g_miniDisplay->setAudioRecorder(g_audioRecorder);
 
+#if MINIACID_DUAL_CORE
+  if (g_renderSplit.begin(0, 3, 4096)) {
+    g_miniAcid.setRenderSplit(&g_renderSplit);
+  }
+#endif
+
   xTaskCreatePinnedToCore(audioTask, "AudioTask",
                           4096, // stack
                           nullptr,
@@ -100,11 +165,7 @@ void loop() {
   g_encoder8.update();
 
   if (M5Cardputer.BtnA.wasClicked()) {
-    if (g_miniAcid.isPlaying()) {
-      g_miniAcid.stop();
-    } else {
-      g_miniAcid.start();
-    }
+    toggleTransport();
     drawUI();
   }
 
@@ -133,56 +194,52 @@ void loop() {
       if (g_miniDisplay) g_miniDisplay->nextPage();
       drawUI();
     } else if (c == 'i' || c == 'I') {
-      g_miniAcid.randomize303Pattern(0);
+      g_miniAcid.post(EngineCommand::randomize303Pattern(0));
       drawUI();
     } else if (c == 'o' || c == 'O') {
-      g_miniAcid.randomize303Pattern(1);
+      g_miniAcid.post(EngineCommand::randomize303Pattern(1));
       drawUI();
     } else if (c == 'p' || c == 'P') {
-      g_miniAcid.randomizeDrumPattern();
+      g_miniAcid.post(EngineCommand::randomizeDrumPattern());
       drawUI();
     } else if (c == '1') {
-      g_miniAcid.toggleMute303(0);
+      g_miniAcid.post(EngineCommand::toggleMute303(0));
       drawUI();
     } else if (c == '2') {
-      g_miniAcid.toggleMute303(1);
+      g_miniAcid.post(EngineCommand::toggleMute303(1));
       drawUI();
     } else if (c == '3') {
-      g_miniAcid.toggleMuteKick();
+      g_miniAcid.post(EngineCommand::toggleMuteDrum(DrumVoiceId::Kick));
       drawUI();
     } else if (c == '4') {
-      g_miniAcid.toggleMuteSnare();
+      g_miniAcid.post(EngineCommand::toggleMuteDrum(DrumVoiceId::Snare));
       drawUI();
     } else if (c == '5') {
-      g_miniAcid.toggleMuteHat();
+      g_miniAcid.post(EngineCommand::toggleMuteDrum(DrumVoiceId::Hat));
       drawUI();
     } else if (c == '6') {
-      g_miniAcid.toggleMuteOpenHat();
+      g_miniAcid.post(EngineCommand::toggleMuteDrum(DrumVoiceId::OpenHat));
       drawUI();
     } else if (c == '7') {
-      g_miniAcid.toggleMuteMidTom();
+      g_miniAcid.post(EngineCommand::toggleMuteDrum(DrumVoiceId::MidTom));
       drawUI();
     } else if (c == '8') {
-      g_miniAcid.toggleMuteHighTom();
+      g_miniAcid.post(EngineCommand::toggleMuteDrum(DrumVoiceId::HighTom));
       drawUI();
     } else if (c == '9') {
-      g_miniAcid.toggleMuteRim();
+      g_miniAcid.post(EngineCommand::toggleMuteDrum(DrumVoiceId::Rim));
       drawUI();
     } else if (c == '0') {
-      g_miniAcid.toggleMuteClap();
+      g_miniAcid.post(EngineCommand::toggleMuteDrum(DrumVoiceId::Clap));
       drawUI();
     } else if (c == 'k' || c == 'K') {
-      g_miniAcid.setBpm(g_miniAcid.bpm() - 5.0f);
+      g_miniAcid.post(EngineCommand::setBpm(g_miniAcid.bpm() - 5.0f));
       drawUI();
     } else if (c == 'l' || c == 'L') {
-      g_miniAcid.setBpm(g_miniAcid.bpm() + 5.0f);
+      g_miniAcid.post(EngineCommand::setBpm(g_miniAcid.bpm() + 5.0f));
       drawUI();
     } else if (c == ' ') {
-      if (g_miniAcid.isPlaying()) {
-        g_miniAcid.stop();
-      } else {
-        g_miniAcid.start();
-      }
+      toggleTransport();
       drawUI();
     }
   };
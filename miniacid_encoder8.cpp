@@ -49,7 +49,7 @@ void Encoder8Miniacid::update() {
     int inc_value = sensor_.getIncrementValue(i);
     if (inc_value != 0) {
       const EncoderParam& enc = kEncoderParams[i];
-      miniAcid_.adjust303Parameter(enc.param, inc_value, enc.voice);
+      miniAcid_.post(EngineCommand::adjust303Parameter(enc.param, inc_value, enc.voice));
       setLedFromParam(i);
     }
   }
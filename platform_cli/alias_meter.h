@@ -0,0 +1,71 @@
+#pragma once
+
+// Alias measurement shared by the oscillator, shaper and oversampling
+// benches. A test tone is tuned so a whole number of cycles fits the
+// analysis window; every harmonic then lands exactly on a multiple of its
+// bin, and anything between them can only be energy that folded back from
+// above Nyquist. No window is needed, so nothing leaks between bins.
+#include <math.h>
+#include <stddef.h>
+#include <complex>
+#include <vector>
+
+namespace alias_meter {
+
+constexpr size_t kPoints = 8192;
+
+// The bin nearest hz. Odd, so no harmonic's alias can fold onto another
+// harmonic's bin.
+inline int toneBin(double hz, int rate) {
+  int bin = static_cast<int>(hz * kPoints / rate + 0.5);
+  if (bin % 2 == 0) ++bin;
+  return bin;
+}
+
+inline double binHz(int bin, int rate) {
+  return static_cast<double>(bin) * rate / kPoints;
+}
+
+// In-place radix-2 FFT; x.size() must be a power of two.
+inline void fft(std::vector<std::complex<double>>& x) {
+  const size_t n = x.size();
+  for (size_t i = 1, j = 0; i < n; ++i) {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+    if (i < j) std::swap(x[i], x[j]);
+  }
+  for (size_t len = 2; len <= n; len <<= 1) {
+    double angle = -2.0 * 3.14159265358979323846 / static_cast<double>(len);
+    std::complex<double> step(cos(angle), sin(angle));
+    for (size_t i = 0; i < n; i += len) {
+      std::complex<double> w(1.0, 0.0);
+      for (size_t k = 0; k < len / 2; ++k) {
+        std::complex<double> a = x[i + k];
+        std::complex<double> b = x[i + k + len / 2] * w;
+        x[i + k] = a + b;
+        x[i + k + len / 2] = a - b;
+        w *= step;
+      }
+    }
+  }
+}
+
+// Energy off the harmonics of bin, relative to the total, in dB. Reads
+// kPoints samples from x; DC is left out of both.
+inline double aliasDb(const float* x, int bin) {
+  std::vector<std::complex<double>> spectrum(kPoints);
+  for (size_t i = 0; i < kPoints; ++i) spectrum[i] = x[i];
+  fft(spectrum);
+  double alias = 0.0;
+  double total = 0.0;
+  for (size_t k = 1; k <= kPoints / 2; ++k) {
+    double e = std::norm(spectrum[k]);
+    total += e;
+    if (k % static_cast<size_t>(bin) != 0) alias += e;
+  }
+  if (total <= 0.0) return 0.0;
+  return 10.0 * log10(alias > total * 1e-15 ? alias / total : 1e-15);
+}
+
+} // namespace alias_meter
@@ -0,0 +1,151 @@
+// Bounces every scene in a directory to WAV, one engine per worker thread,
+// and reports throughput.
+//
+//   miniacid-batch scenes/ out/ [--jobs N] [--loops N] [--tail SECONDS]
+//                  [--rate HZ]
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "../src/dsp/miniacid_engine.h"
+#include "song_bounce.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+void printUsage(const char* argv0) {
+  fprintf(stderr,
+          "usage: %s scene-dir out-dir [--jobs N] [--loops N] [--tail SECONDS] [--rate HZ]\n"
+          "  --jobs     scenes rendered at once (default: one per core)\n"
+          "  --loops    times through each song (default 1)\n"
+          "  --tail     seconds to keep rendering after the last step (default 2)\n"
+          "  --rate     engine sample rate: 22050, 32000, 44100 or 48000 (default %d)\n",
+          argv0, SAMPLE_RATE);
+}
+
+struct SceneJob {
+  std::string path;
+  std::string name;
+  BounceResult result;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+  std::string sceneDir;
+  std::string outDir;
+  int jobs = static_cast<int>(std::thread::hardware_concurrency());
+  if (jobs < 1) jobs = 1;
+  BounceOptions options;
+  options.sampleRate = SAMPLE_RATE;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--jobs" && i + 1 < argc) {
+      jobs = atoi(argv[++i]);
+    } else if (arg == "--loops" && i + 1 < argc) {
+      options.loops = atoi(argv[++i]);
+    } else if (arg == "--tail" && i + 1 < argc) {
+      options.tailSeconds = static_cast<float>(atof(argv[++i]));
+    } else if (arg == "--rate" && i + 1 < argc) {
+      options.sampleRate = atoi(argv[++i]);
+    } else if (!arg.empty() && arg[0] != '-' && sceneDir.empty()) {
+      sceneDir = arg;
+    } else if (!arg.empty() && arg[0] != '-' && outDir.empty()) {
+      outDir = arg;
+    } else {
+      printUsage(argv[0]);
+      return 2;
+    }
+  }
+  if (sceneDir.empty() || outDir.empty() || jobs < 1 || options.loops < 1 ||
+      options.tailSeconds < 0.0f) {
+    printUsage(argv[0]);
+    return 2;
+  }
+  if (!MiniAcid::isSupportedSampleRate(options.sampleRate)) {
+    fprintf(stderr, "Unsupported sample rate %d\n", options.sampleRate);
+    return 2;
+  }
+
+  std::error_code ec;
+  std::vector<SceneJob> scenes;
+  for (fs::directory_iterator it(sceneDir, ec), end; !ec && it != end; it.increment(ec)) {
+    if (!it->is_regular_file() || it->path().extension() != ".json") continue;
+    SceneJob job;
+    job.path = it->path().string();
+    job.name = sceneBaseName(job.path);
+    scenes.push_back(job);
+  }
+  if (ec) {
+    fprintf(stderr, "Cannot list %s: %s\n", sceneDir.c_str(), ec.message().c_str());
+    return 1;
+  }
+  if (scenes.empty()) {
+    fprintf(stderr, "No .json scenes in %s\n", sceneDir.c_str());
+    return 1;
+  }
+  std::sort(scenes.begin(), scenes.end(),
+            [](const SceneJob& a, const SceneJob& b) { return a.path < b.path; });
+  fs::create_directories(outDir, ec);
+  if (ec) {
+    fprintf(stderr, "Cannot create %s: %s\n", outDir.c_str(), ec.message().c_str());
+    return 1;
+  }
+  if (jobs > static_cast<int>(scenes.size())) jobs = static_cast<int>(scenes.size());
+
+  // Workers take the next scene off a shared index; each bounce builds its
+  // own engine, so nothing else is shared. Each result stays with its scene
+  // and is printed after the join, so the report comes out in scene order
+  // whatever order the bounces finish in.
+  std::atomic<size_t> next(0);
+  auto worker = [&]() {
+    for (size_t i = next.fetch_add(1); i < scenes.size(); i = next.fetch_add(1)) {
+      SceneJob& job = scenes[i];
+      std::string json;
+      if (!readSceneFile(job.path, json)) {
+        job.result.error = "cannot read";
+      } else {
+        std::string wavPath = (fs::path(outDir) / (job.name + ".wav")).string();
+        job.result = bounceScene(json, job.name, wavPath, options);
+      }
+    }
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int t = 1; t < jobs; ++t) threads.emplace_back(worker);
+  worker();
+  for (std::thread& thread : threads) thread.join();
+  double wallSeconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  int rendered = 0;
+  double audioSeconds = 0.0;
+  for (const SceneJob& job : scenes) {
+    if (!job.result.ok) {
+      fflush(stdout); // keep the failure in its place when both go to one file
+      fprintf(stderr, "%s: %s\n", job.path.c_str(), job.result.error.c_str());
+      continue;
+    }
+    printf("%s: %.1f s in %.3f s\n", job.name.c_str(), job.result.audioSeconds,
+           job.result.renderSeconds);
+    ++rendered;
+    audioSeconds += job.result.audioSeconds;
+  }
+  int failed = static_cast<int>(scenes.size()) - rendered;
+  printf("%d scenes (%d failed), %.1f s of audio in %.3f s on %d jobs\n", rendered, failed,
+         audioSeconds, wallSeconds, jobs);
+  if (wallSeconds > 0.0) {
+    printf("%.2f scenes/s, %.1f realtime-seconds/s\n", rendered / wallSeconds,
+           audioSeconds / wallSeconds);
+  }
+  return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,156 @@
+// Posts edits and reads every UI getter on one thread while another renders,
+// the way the SDL host and the Cardputer use the engine. Meant to run under
+// ThreadSanitizer (`make check`); it also checks the UI ends up seeing the
+// state the edits should have left behind.
+//
+//   engine_race_check [--edits N]
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "../src/dsp/miniacid_engine.h"
+#include "memory_scene_storage.h"
+
+namespace {
+
+int failures = 0;
+
+void expect(bool ok, const char* what) {
+  if (ok) return;
+  printf("FAIL: %s\n", what);
+  ++failures;
+}
+
+// Touches everything the pages and the mute bar read.
+int readUiState(const MiniAcid& synth) {
+  int sum = synth.currentStep() + synth.songLength() + synth.currentSongPosition() +
+            synth.songPlayheadPosition() + synth.loopStartRow() + synth.loopEndRow() +
+            synth.currentDrumPatternIndex() + synth.currentDrumBankIndex() +
+            synth.displayDrumPatternIndex();
+  sum += synth.songModeEnabled() + synth.loopModeEnabled() + synth.isPlaying();
+  for (int v = 0; v < NUM_303_VOICES; ++v) {
+    sum += synth.current303PatternIndex(v) + synth.current303BankIndex(v) +
+           synth.display303PatternIndex(v) + synth.is303Muted(v);
+    sum += synth.pattern303Steps(v)[0] + synth.pattern303AccentSteps(v)[1] +
+           synth.pattern303SlideSteps(v)[2];
+    sum += static_cast<int>(synth.parameter303(TB303ParamId::Cutoff, v).value());
+  }
+  sum += synth.patternKickSteps()[0] + synth.patternSnareSteps()[4] + synth.patternHatSteps()[2] +
+         synth.patternClapAccentSteps()[3] + synth.patternDrumAccentSteps()[0];
+  sum += synth.isKickMuted() + synth.isClapMuted() + synth.songPatternAt(0, SongTrack::Drums);
+  sum += synth.song().length + static_cast<int>(synth.currentDrumEngineName().size());
+  int16_t scope[64];
+  sum += static_cast<int>(synth.copyLastAudio(scope, 64));
+  return sum;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  int edits = 20000;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--edits" && i + 1 < argc) {
+      edits = atoi(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: %s [--edits N]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  MemorySceneStorage storage; // the built-in scene
+  std::unique_ptr<MiniAcid> synth(new MiniAcid(static_cast<float>(SAMPLE_RATE), &storage));
+  synth->init();
+  synth->start();
+
+  // The audio guard: held by the audio thread for each block, and by the
+  // UI around transport and scene saves, as on both hosts. While stopped
+  // the audio thread only applies edits, like the Cardputer task.
+  std::mutex guard;
+  std::atomic<bool> stop(false);
+  std::thread audio([&]() {
+    int16_t block[AUDIO_BUFFER_SAMPLES];
+    while (!stop.load(std::memory_order_relaxed)) {
+      bool rendered;
+      {
+        std::lock_guard<std::mutex> lock(guard);
+        rendered = synth->isPlaying();
+        if (rendered)
+          synth->generateAudioBuffer(block, AUDIO_BUFFER_SAMPLES);
+        else
+          synth->processCommands();
+      }
+      if (!rendered) std::this_thread::yield();
+    }
+  });
+
+  // A full queue is retried here rather than dropped, so the end state is
+  // known: song mode toggled once per eight edits, and the cell and loop
+  // set last.
+  int posted = 0;
+  int dropped = 0;
+  long readSum = 0;
+  auto post = [&](const EngineCommand& cmd) {
+    while (!synth->post(cmd)) {
+      ++dropped;
+      std::this_thread::yield();
+    }
+    ++posted;
+  };
+  for (int i = 0; i < edits; ++i) {
+    int step = i % SEQ_STEPS;
+    switch (i % 8) {
+      case 0: post(EngineCommand::toggleSongMode()); break;
+      case 1: post(EngineCommand::toggleMute303(i % NUM_303_VOICES)); break;
+      case 2: post(EngineCommand::toggleDrumStep(i % NUM_DRUM_VOICES, step)); break;
+      case 3:
+        if ((i / 8) % 2)
+          post(EngineCommand::toggle303AccentStep(0, step));
+        else
+          post(EngineCommand::set303StepNote(0, step, 36 + (i / 8) % 24));
+        break;
+      case 4: post(EngineCommand::setLoopMode((i / 8) % 2 == 0)); break;
+      case 5: post(EngineCommand::setLoopRange(0, 1 + (i / 8) % 3)); break;
+      case 6: post(EngineCommand::setSongPattern(i % 4, SongTrack::Drums, i % 8)); break;
+      case 7: post(EngineCommand::adjust303Parameter(TB303ParamId::Cutoff, (i / 8) % 2 ? 1 : -1)); break;
+    }
+    // Kit switches land mid-fade, and the fade length changes under them.
+    if (i % 256 == 0) post(EngineCommand::setDrumEngine((i / 256 + 1) % 3));
+    if (i % 1024 == 512) post(EngineCommand::setDrumEngineCrossfadeMs((i / 1024) % 2 ? 0.0f : 120.0f));
+    if (i % 2048 == 1024) {
+      std::lock_guard<std::mutex> lock(guard);
+      if (synth->isPlaying())
+        synth->stop(); // saves the scene
+      else
+        synth->start();
+      synth->saveSceneAs("race");
+    }
+    readSum += readUiState(*synth);
+  }
+  post(EngineCommand::setSongPattern(3, SongTrack::SynthA, 5));
+  post(EngineCommand::setLoopMode(true));
+  post(EngineCommand::setLoopRange(1, 2));
+
+  // Wait for the audio thread to apply and publish everything.
+  uint32_t last = synth->lastPostedCommand();
+  for (int tries = 0; tries < 2000 && !synth->commandApplied(last); ++tries)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  expect(synth->commandApplied(last), "the audio thread applied every edit");
+  stop.store(true, std::memory_order_relaxed);
+  audio.join();
+
+  expect(synth->songPatternAt(3, SongTrack::SynthA) == 5, "the last song cell reached the UI");
+  expect(synth->loopModeEnabled() && synth->loopStartRow() == 1 && synth->loopEndRow() == 2,
+         "the last loop range reached the UI");
+  expect(synth->droppedCommandCount() == static_cast<uint32_t>(dropped), "every full queue was counted");
+  expect(synth->songModeEnabled() == ((edits + 7) / 8 % 2 == 1), "song mode matches the toggles");
+  printf("%d edits posted (%d retries on a full queue), UI read sum %ld\n", posted, dropped,
+         readSum);
+  printf("checks: %s\n", failures == 0 ? "ok" : "FAILED");
+  return failures == 0 ? 0 : 1;
+}
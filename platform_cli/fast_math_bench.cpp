@@ -0,0 +1,138 @@
+// Sweeps each fast_math.h approximation against double-precision libm,
+// checks the worst error stays inside the bound its header documents, and
+// times it against the single-precision libm call it replaces.
+//
+//   fast_math_bench [--check]
+//
+// --check runs only the sweeps.
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../src/dsp/fast_math.h"
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr int kSweepPoints = 1 << 21;
+
+enum class ErrorKind { Absolute, Relative };
+
+struct Range {
+  const char* name;
+  float lo;
+  float hi;
+  bool logSpaced;
+  ErrorKind kind;
+  double bound; // from the table at the top of fast_math.h
+};
+
+int failures = 0;
+
+template <typename Fast, typename Exact>
+void sweep(const Range& range, Fast fast, Exact exact) {
+  double worst = 0.0;
+  float worstAt = range.lo;
+  for (int i = 0; i <= kSweepPoints; ++i) {
+    double t = static_cast<double>(i) / kSweepPoints;
+    float x = range.logSpaced
+                ? static_cast<float>(range.lo * pow(static_cast<double>(range.hi) / range.lo, t))
+                : static_cast<float>(range.lo + (static_cast<double>(range.hi) - range.lo) * t);
+    double want = exact(static_cast<double>(x));
+    double err = fabs(static_cast<double>(fast(x)) - want);
+    if (range.kind == ErrorKind::Relative && want != 0.0) err /= fabs(want);
+    if (err > worst) {
+      worst = err;
+      worstAt = x;
+    }
+  }
+  bool ok = worst < range.bound;
+  if (!ok) ++failures;
+  printf("%-26s %-8s %9.2e  at %-12g  bound %.1e  %s\n", range.name,
+         range.kind == ErrorKind::Absolute ? "abs" : "rel", worst, worstAt, range.bound,
+         ok ? "ok" : "FAIL");
+}
+
+void sweepAll() {
+  printf("function                   error    worst       at            documented\n");
+  sweep({"fastSin2Pi [-4, 4]", -4.0f, 4.0f, false, ErrorKind::Absolute, 5e-6}, fastSin2Pi,
+        [](double p) { return sin(2.0 * kPi * p); });
+  auto tanPi = [](double x) { return tan(kPi * x); };
+  sweep({"fastTanPi [0, 0.45]", 0.0f, 0.45f, false, ErrorKind::Relative, 2.5e-5}, fastTanPi, tanPi);
+  sweep({"fastTanPi [0.45, 0.49]", 0.45f, 0.49f, false, ErrorKind::Relative, 6e-4}, fastTanPi, tanPi);
+  auto tanhExact = [](double x) { return tanh(x); };
+  sweep({"fastTanh [-3, 3]", -3.0f, 3.0f, false, ErrorKind::Absolute, 1.1e-6}, fastTanh, tanhExact);
+  sweep({"fastTanh [-20, 20]", -20.0f, 20.0f, false, ErrorKind::Absolute, 1e-4}, fastTanh, tanhExact);
+  sweep({"fastExp [-87, 88]", -87.0f, 88.0f, false, ErrorKind::Relative, 1e-5}, fastExp,
+        [](double x) { return exp(x); });
+  sweep({"fastLog [1e-6, 1e6]", 1e-6f, 1e6f, true, ErrorKind::Absolute, 1.1e-6}, fastLog,
+        [](double x) { return log(x); });
+}
+
+// Best of 5 passes over inputs, in ns per call. The sum is printed so the
+// calls cannot be optimised away.
+template <typename F>
+double nsPerCall(const std::vector<float>& inputs, F f, float& sum) {
+  double best = 0.0;
+  for (int run = 0; run < 5; ++run) {
+    float acc = 0.0f;
+    auto start = std::chrono::steady_clock::now();
+    for (float x : inputs) acc += f(x);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+                  .count() / static_cast<double>(inputs.size());
+    if (run == 0 || ns < best) best = ns;
+    sum += acc;
+  }
+  return best;
+}
+
+// Inputs spread over the range the DSP code feeds each function.
+std::vector<float> inputs(float lo, float hi) {
+  std::vector<float> x(1 << 20);
+  uint32_t seed = 12345;
+  for (float& v : x) {
+    seed = seed * 1664525u + 1013904223u;
+    v = lo + (hi - lo) * static_cast<float>(seed >> 8) * (1.0f / 16777216.0f);
+  }
+  return x;
+}
+
+template <typename Fast, typename Libm>
+void compare(const char* name, const std::vector<float>& x, Fast fast, Libm libm) {
+  float sum = 0.0f;
+  double libmNs = nsPerCall(x, libm, sum);
+  double fastNs = nsPerCall(x, fast, sum);
+  printf("%-10s  %6.2f  %6.2f  %5.2fx   (%g)\n", name, libmNs, fastNs, libmNs / fastNs, sum);
+}
+
+void timeAll() {
+  printf("\nns per call, best of 5\n");
+  printf("function      libm    fast  speedup\n");
+  compare("sin2Pi", inputs(0.0f, 1.0f), fastSin2Pi, [](float p) { return sinf(6.28318531f * p); });
+  compare("tanPi", inputs(0.0f, 0.45f), fastTanPi, [](float x) { return tanf(3.14159265f * x); });
+  compare("tanh", inputs(-5.0f, 5.0f), fastTanh, [](float x) { return tanhf(x); });
+  compare("exp", inputs(-20.0f, 0.0f), fastExp, [](float x) { return expf(x); });
+  compare("log", inputs(1.0f, 10.0f), fastLog, [](float x) { return logf(x); });
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  bool checkOnly = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--check") {
+      checkOnly = true;
+    } else {
+      fprintf(stderr, "usage: %s [--check]\n", argv[0]);
+      return 2;
+    }
+  }
+  sweepAll();
+  printf("checks: %s\n", failures == 0 ? "ok" : "FAILED");
+  if (!checkOnly) timeAll();
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+// Null test for the MINIACID_FIXED_POINT profile. The same source is built
+// once per profile; each build renders the same seeded song, and --compare
+// reports how far one render strays from another.
+//
+//   fixed_point_null OUT.raw [--seconds S] [--drone]
+//   fixed_point_null --compare REFERENCE.raw TEST.raw
+//
+// Renders are raw 16-bit mono at the engine rate. `make fixed-point-null`
+// builds the float reference with ADAA off, to match the fixed shaper,
+// then the whole fixed profile and each of its kernels on its own.
+//
+// --drone holds one note on every 303 step. The oscillators then sound
+// throughout, and the float phase accumulator drifts furthest from the
+// 32-bit one.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../src/dsp/miniacid_engine.h"
+#include "memory_scene_storage.h"
+
+namespace {
+
+// Both 303 voices play, voice 1 on the supersaw through its delay and
+// distortion, and the drum kit changes every four seconds.
+std::vector<int16_t> renderSong(int seconds, bool drone) {
+  MemorySceneStorage storage; // the built-in scene
+  std::unique_ptr<MiniAcid> synth(new MiniAcid(SAMPLE_RATE, &storage));
+  synth->init();
+  for (int v = 0; v < NUM_303_VOICES; ++v) {
+    synth->randomize303Pattern(v);
+    if (!drone) continue;
+    for (int step = 0; step < SynthPattern::kSteps; ++step) {
+      synth->set303StepNote(v, step, 33);
+      synth->set303AccentStep(v, step, false);
+      synth->set303SlideStep(v, step, false);
+    }
+  }
+  synth->randomizeDrumPattern();
+  synth->setDelay303Enabled(1, true);
+  synth->setDistortion303Enabled(1, true);
+  synth->set303Parameter(TB303ParamId::Oscillator, 2, 1);
+  synth->setBpm(128.0f);
+  synth->start();
+
+  std::vector<std::string> kits = synth->getAvailableDrumEngines();
+  const size_t kitSamples = static_cast<size_t>(SAMPLE_RATE) * 4;
+  std::vector<int16_t> out(static_cast<size_t>(SAMPLE_RATE) * seconds);
+  size_t kit = 0;
+  for (size_t done = 0; done < out.size();) {
+    size_t n = out.size() - done < AUDIO_BUFFER_SAMPLES ? out.size() - done : AUDIO_BUFFER_SAMPLES;
+    synth->generateAudioBuffer(&out[done], n);
+    if ((done + n) / kitSamples != done / kitSamples) {
+      kit = (kit + 1) % kits.size();
+      synth->setDrumEngine(kits[kit]);
+    }
+    done += n;
+  }
+  return out;
+}
+
+bool readRaw(const char* path, std::vector<int16_t>& samples) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return false;
+  int16_t block[4096];
+  size_t got;
+  while ((got = fread(block, sizeof(int16_t), 4096, f)) > 0) samples.insert(samples.end(), block, block + got);
+  fclose(f);
+  return true;
+}
+
+int compare(const char* referencePath, const char* testPath) {
+  std::vector<int16_t> reference;
+  std::vector<int16_t> test;
+  if (!readRaw(referencePath, reference) || !readRaw(testPath, test)) {
+    fprintf(stderr, "cannot read %s or %s\n", referencePath, testPath);
+    return 2;
+  }
+  if (reference.size() != test.size() || reference.empty()) {
+    fprintf(stderr, "%s and %s differ in length\n", referencePath, testPath);
+    return 2;
+  }
+  double signal = 0.0;
+  double noise = 0.0;
+  int maxDiff = 0;
+  for (size_t i = 0; i < reference.size(); ++i) {
+    int diff = abs(static_cast<int>(test[i]) - static_cast<int>(reference[i]));
+    if (diff > maxDiff) maxDiff = diff;
+    signal += static_cast<double>(reference[i]) * reference[i];
+    noise += static_cast<double>(diff) * diff;
+  }
+  if (noise == 0.0)
+    printf("%-32s identical\n", testPath);
+  else
+    printf("%-32s %6.1f dB SNR, max diff %d LSB\n", testPath, 10.0 * log10(signal / noise), maxDiff);
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  if (argc == 4 && std::string(argv[1]) == "--compare") return compare(argv[2], argv[3]);
+
+  const char* outPath = nullptr;
+  int seconds = 20;
+  bool drone = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--seconds" && i + 1 < argc) {
+      seconds = atoi(argv[++i]);
+    } else if (arg == "--drone") {
+      drone = true;
+    } else if (!outPath && arg[0] != '-') {
+      outPath = argv[i];
+    } else {
+      outPath = nullptr;
+      break;
+    }
+  }
+  if (!outPath || seconds < 1) {
+    fprintf(stderr, "usage: %s OUT.raw [--seconds S] [--drone]\n       %s --compare REFERENCE.raw TEST.raw\n",
+            argv[0], argv[0]);
+    return 2;
+  }
+
+  std::vector<int16_t> samples = renderSong(seconds, drone);
+  FILE* f = fopen(outPath, "wb");
+  if (!f || fwrite(samples.data(), sizeof(int16_t), samples.size(), f) != samples.size()) {
+    fprintf(stderr, "cannot write %s\n", outPath);
+    if (f) fclose(f);
+    return 1;
+  }
+  fclose(f);
+  return 0;
+}
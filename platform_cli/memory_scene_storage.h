@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../scene_storage.h"
+#include "../scenes.h"
+
+// Serves one scene held in memory and drops saves, so headless renders
+// never write back to the scene files they read. Empty JSON leaves the
+// engine on its built-in scene.
+class MemorySceneStorage : public SceneStorage {
+public:
+  explicit MemorySceneStorage(std::string json = std::string(), std::string name = "scene")
+    : json_(std::move(json)), name_(std::move(name)) {}
+
+  void initializeStorage() override {}
+  bool readScene(std::string& out) override {
+    if (json_.empty()) return false;
+    out = json_;
+    return true;
+  }
+  bool writeScene(const std::string&) override { return true; }
+  bool readScene(SceneManager& manager) override {
+    return !json_.empty() && manager.loadScene(json_);
+  }
+  bool writeScene(const SceneManager&) override { return true; }
+  std::vector<std::string> getAvailableSceneNames() const override { return {name_}; }
+  std::string getCurrentSceneName() const override { return name_; }
+  bool setCurrentSceneName(const std::string& name) override {
+    name_ = name;
+    return true;
+  }
+
+private:
+  std::string json_;
+  std::string name_;
+};
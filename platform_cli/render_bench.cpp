@@ -0,0 +1,256 @@
+// Times the engine rendering a fixed random song with the bus pool at 1..N
+// threads and checks every thread count produces the same samples.
+//
+//   render_bench [--threads N] [--seconds S] [--rate HZ] [--oversample 1|2|4]
+//   render_bench --paths [--seconds S]
+//
+// --paths instead times each voice and effect both ways the engine has
+// driven it: one sample per call, as generateAudioBuffer() did before
+// block rendering, and one block per call, as renderBlock() does now.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/dsp/denormal_guard.h"
+#include "../src/dsp/miniacid_engine.h"
+#include "../src/audio/thread_render_pool.h"
+#include "memory_scene_storage.h"
+
+namespace {
+
+struct Result {
+  double seconds;
+  uint64_t hash;
+};
+
+Result renderSong(int threads, int rate, int oversample, int songSeconds) {
+  MemorySceneStorage storage; // the built-in scene
+  std::unique_ptr<MiniAcid> synth(new MiniAcid(static_cast<float>(rate), &storage));
+  synth->init();
+  // Same hit cache as the SDL build, so the drum bus costs what it does there.
+  synth->enableDrumHitCache(1 << 20, 2);
+  synth->set303Oversampling(oversample);
+  std::unique_ptr<ThreadRenderPool> pool;
+  if (threads > 1) {
+    pool.reset(new ThreadRenderPool(threads));
+    synth->setRenderPool(pool.get());
+  }
+
+  // Every voice busy, with its distortion and delay on.
+  for (int v = 0; v < NUM_303_VOICES; ++v) {
+    synth->randomize303Pattern(v);
+    synth->toggleDistortion303(v);
+    synth->toggleDelay303(v);
+  }
+  synth->randomizeDrumPattern();
+  synth->setBpm(130.0f);
+  synth->start();
+
+  int16_t block[AUDIO_BUFFER_SAMPLES];
+  uint64_t hash = 1469598103934665603ull;
+  size_t remaining = static_cast<size_t>(rate) * songSeconds;
+  auto start = std::chrono::steady_clock::now();
+  while (remaining > 0) {
+    size_t n = remaining < AUDIO_BUFFER_SAMPLES ? remaining : AUDIO_BUFFER_SAMPLES;
+    synth->generateAudioBuffer(block, n);
+    for (size_t i = 0; i < n; ++i)
+      hash = (hash ^ static_cast<uint16_t>(block[i])) * 1099511628211ull;
+    remaining -= n;
+  }
+  auto end = std::chrono::steady_clock::now();
+  return {std::chrono::duration<double>(end - start).count(), hash};
+}
+
+// Events land on block boundaries so both paths see the same ones.
+constexpr size_t kEventBlocks = 2;
+
+// A saw with a gate, so the effects have something to chew on.
+float testInput(size_t i) {
+  float t = static_cast<float>(i % 101) / 101.0f;
+  return (i / 2048) % 3 == 2 ? 0.0f : 0.8f * (2.0f * t - 1.0f);
+}
+
+struct Voice303 {
+  TB303Voice voice{static_cast<float>(SAMPLE_RATE)};
+  void event(size_t block) {
+    static const float kNotes[] = {55.0f, 110.0f, 82.4f, 65.4f, 98.0f, 73.4f};
+    size_t step = block / kEventBlocks;
+    if (step % 4 == 3)
+      voice.release();
+    else
+      voice.startNote(kNotes[step % 6], step % 3 == 0, step % 5 == 1);
+  }
+  float sample(size_t) { return voice.process(); }
+  void block(float* out, size_t, size_t n) { voice.process(out, n); }
+};
+
+template <typename Kit>
+struct DrumKit {
+  Kit kit{static_cast<float>(SAMPLE_RATE)};
+  void event(size_t block) {
+    size_t step = block / kEventBlocks;
+    for (int v = 0; v < static_cast<int>(DrumVoiceId::Count); ++v) {
+      if ((step * 7 + static_cast<size_t>(v) * 3) % 5 == 0)
+        kit.trigger(static_cast<DrumVoiceId>(v), step % 4 == 0);
+    }
+  }
+  // The per-sample mix the engine used to make, in lane order.
+  float sample(size_t) {
+    return kit.processKick() + kit.processSnare() + kit.processHat() + kit.processOpenHat() +
+           kit.processMidTom() + kit.processHighTom() + kit.processRim() + kit.processClap();
+  }
+  void block(float* out, size_t, size_t n) { kit.process(out, n, 0xff); }
+};
+
+struct Distortion {
+  TubeDistortion tube;
+  Distortion() { tube.setEnabled(true); }
+  void event(size_t) {}
+  float sample(size_t i) { return tube.process(testInput(i)); }
+  void block(float* out, size_t first, size_t n) {
+    for (size_t i = 0; i < n; ++i) out[i] = testInput(first + i);
+    tube.process(out, n);
+  }
+};
+
+struct Delay {
+  TempoDelay delay{static_cast<float>(SAMPLE_RATE)};
+  Delay() {
+    delay.setBpm(128.0f);
+    delay.setEnabled(true);
+  }
+  void event(size_t) {}
+  float sample(size_t i) { return delay.process(testInput(i)); }
+  void block(float* out, size_t first, size_t n) {
+    for (size_t i = 0; i < n; ++i) out[i] = testInput(first + i);
+    delay.process(out, n);
+  }
+};
+
+struct PathResult {
+  double perSampleNs;
+  double blockNs;
+  float maxDiff;
+};
+
+// Best of 5 renders each way, with a fresh unit for every render.
+template <typename Unit>
+PathResult comparePaths(int seconds) {
+  size_t blocks = static_cast<size_t>(SAMPLE_RATE) * seconds / AUDIO_BUFFER_SAMPLES;
+  std::vector<float> perSample(blocks * AUDIO_BUFFER_SAMPLES);
+  std::vector<float> block(perSample.size());
+  PathResult result{0.0, 0.0, 0.0f};
+  for (int run = 0; run < 5; ++run) {
+    std::unique_ptr<Unit> a(new Unit);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t b = 0; b < blocks; ++b) {
+      if (b % kEventBlocks == 0) a->event(b);
+      size_t first = b * AUDIO_BUFFER_SAMPLES;
+      for (size_t i = first; i < first + AUDIO_BUFFER_SAMPLES; ++i) perSample[i] = a->sample(i);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+                  .count() / static_cast<double>(perSample.size());
+    if (run == 0 || ns < result.perSampleNs) result.perSampleNs = ns;
+
+    std::unique_ptr<Unit> u(new Unit);
+    start = std::chrono::steady_clock::now();
+    for (size_t b = 0; b < blocks; ++b) {
+      if (b % kEventBlocks == 0) u->event(b);
+      size_t first = b * AUDIO_BUFFER_SAMPLES;
+      u->block(&block[first], first, AUDIO_BUFFER_SAMPLES);
+    }
+    ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+           .count() / static_cast<double>(block.size());
+    if (run == 0 || ns < result.blockNs) result.blockNs = ns;
+  }
+  for (size_t i = 0; i < block.size(); ++i)
+    result.maxDiff = std::max(result.maxDiff, fabsf(block[i] - perSample[i]));
+  return result;
+}
+
+template <typename Unit>
+double printPaths(const char* name, int seconds) {
+  PathResult r = comparePaths<Unit>(seconds);
+  printf("%-12s  %10.1f  %8.1f  %7.2fx  %9.2g\n", name, r.perSampleNs, r.blockNs,
+         r.perSampleNs / r.blockNs, static_cast<double>(r.maxDiff));
+  return r.perSampleNs - r.blockNs;
+}
+
+void runPaths(int seconds) {
+  DenormalGuard denormalGuard; // as generateAudioBuffer() has
+  printf("%d s at %d Hz in %d-sample blocks, ns per sample, best of 5\n", seconds, SAMPLE_RATE,
+         AUDIO_BUFFER_SAMPLES);
+  printf("unit          per-sample     block  speedup   max diff\n");
+  double saved = 0.0;
+  saved += printPaths<Voice303>("303 voice", seconds);
+  saved += printPaths<DrumKit<TR808DrumSynthVoice>>("808 kit", seconds);
+  saved += printPaths<DrumKit<TR909DrumSynthVoice>>("909 kit", seconds);
+  saved += printPaths<DrumKit<TR606DrumSynthVoice>>("606 kit", seconds);
+  saved += printPaths<Distortion>("distortion", seconds);
+  saved += printPaths<Delay>("delay", seconds);
+  printf("one of each: the block path saves %.1f ns per sample\n", saved);
+  printf("The block path glides the 303 filter over 16-sample segments, and the 808 and 909\n"
+         "noise voices draw one generator per kit in a different order, so those outputs differ.\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  int maxThreads = static_cast<int>(std::thread::hardware_concurrency());
+  if (maxThreads < 1) maxThreads = 1;
+  int songSeconds = 30;
+  int rate = SAMPLE_RATE;
+  int oversample = 2;
+  bool paths = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--threads" && i + 1 < argc) {
+      maxThreads = atoi(argv[++i]);
+    } else if (arg == "--seconds" && i + 1 < argc) {
+      songSeconds = atoi(argv[++i]);
+    } else if (arg == "--rate" && i + 1 < argc) {
+      rate = atoi(argv[++i]);
+    } else if (arg == "--oversample" && i + 1 < argc) {
+      oversample = atoi(argv[++i]);
+    } else if (arg == "--paths") {
+      paths = true;
+    } else {
+      fprintf(stderr, "usage: %s [--threads N] [--seconds S] [--rate HZ] [--oversample 1|2|4]\n"
+                      "       %s --paths [--seconds S]\n", argv[0], argv[0]);
+      return 2;
+    }
+  }
+  if (!MiniAcid::isSupportedSampleRate(rate)) {
+    fprintf(stderr, "Unsupported sample rate %d\n", rate);
+    return 2;
+  }
+  if (maxThreads < 1 || songSeconds < 1) {
+    fprintf(stderr, "--threads and --seconds must be at least 1\n");
+    return 2;
+  }
+  if (paths) {
+    runPaths(songSeconds);
+    return 0;
+  }
+
+  printf("%d 303 voices + drums, %d s at %d Hz, %dx oversampling, %u cores\n", NUM_303_VOICES,
+         songSeconds, rate, oversample, std::thread::hardware_concurrency());
+  printf("threads  render s  x realtime  speedup  output\n");
+  Result single{};
+  bool allMatch = true;
+  for (int threads = 1; threads <= maxThreads; ++threads) {
+    Result r = renderSong(threads, rate, oversample, songSeconds);
+    if (threads == 1) single = r;
+    bool match = r.hash == single.hash;
+    allMatch = allMatch && match;
+    printf("%7d  %8.3f  %10.1f  %7.2f  %s\n", threads, r.seconds, songSeconds / r.seconds,
+           single.seconds / r.seconds, match ? "same" : "DIFFERS");
+  }
+  return allMatch ? 0 : 1;
+}
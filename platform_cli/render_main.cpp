@@ -0,0 +1,94 @@
+// Bounces a scene's song arrangement to a WAV file, as fast as the CPU
+// allows and without any audio device or display.
+//
+//   miniacid-render scene.json [-o out.wav] [--loops N] [--tail SECONDS]
+//                  [--rate HZ] [--threads N]
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory>
+#include <string>
+
+#include "../src/dsp/miniacid_engine.h"
+#include "../src/audio/thread_render_pool.h"
+#include "song_bounce.h"
+
+namespace {
+
+void printUsage(const char* argv0) {
+  fprintf(stderr,
+          "usage: %s scene.json [-o out.wav] [--loops N] [--tail SECONDS] [--rate HZ] [--threads N]\n"
+          "  --loops    times through the song (default 1)\n"
+          "  --tail     seconds to keep rendering after the last step, for releases\n"
+          "             and delay tails (default 2)\n"
+          "  --rate     engine sample rate: 22050, 32000, 44100 or 48000 (default %d)\n"
+          "  --threads  render threads for the bus pool (default 1)\n",
+          argv0, SAMPLE_RATE);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  std::string scenePath;
+  std::string outPath;
+  int loops = 1;
+  float tailSeconds = 2.0f;
+  int rate = SAMPLE_RATE;
+  int threads = 1;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if ((arg == "-o" || arg == "--output") && i + 1 < argc) {
+      outPath = argv[++i];
+    } else if (arg == "--loops" && i + 1 < argc) {
+      loops = atoi(argv[++i]);
+    } else if (arg == "--tail" && i + 1 < argc) {
+      tailSeconds = static_cast<float>(atof(argv[++i]));
+    } else if (arg == "--rate" && i + 1 < argc) {
+      rate = atoi(argv[++i]);
+    } else if (arg == "--threads" && i + 1 < argc) {
+      threads = atoi(argv[++i]);
+    } else if (!arg.empty() && arg[0] != '-' && scenePath.empty()) {
+      scenePath = arg;
+    } else {
+      printUsage(argv[0]);
+      return 2;
+    }
+  }
+  if (scenePath.empty() || loops < 1 || tailSeconds < 0.0f || threads < 1) {
+    printUsage(argv[0]);
+    return 2;
+  }
+  if (!MiniAcid::isSupportedSampleRate(rate)) {
+    fprintf(stderr, "Unsupported sample rate %d\n", rate);
+    return 2;
+  }
+
+  std::string json;
+  if (!readSceneFile(scenePath, json)) {
+    fprintf(stderr, "Cannot read %s\n", scenePath.c_str());
+    return 1;
+  }
+
+  std::string name = sceneBaseName(scenePath);
+  if (outPath.empty()) outPath = name + ".wav";
+
+  BounceOptions options;
+  options.loops = loops;
+  options.tailSeconds = tailSeconds;
+  options.sampleRate = rate;
+  std::unique_ptr<ThreadRenderPool> pool;
+  if (threads > 1) {
+    pool.reset(new ThreadRenderPool(threads));
+    options.pool = pool.get();
+  }
+
+  BounceResult result = bounceScene(json, name, outPath, options);
+  if (!result.ok) {
+    fprintf(stderr, "%s: %s\n", scenePath.c_str(), result.error.c_str());
+    return 1;
+  }
+  printf("%s: %d positions x %d at %.0f BPM, %.1f s at %d Hz -> %s\n", name.c_str(),
+         result.positions, loops, result.bpm, result.audioSeconds, rate, outPath.c_str());
+  printf("rendered in %.3f s, %.1fx realtime\n", result.renderSeconds,
+         result.renderSeconds > 0.0 ? result.audioSeconds / result.renderSeconds : 0.0);
+  return 0;
+}
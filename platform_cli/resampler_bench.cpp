@@ -0,0 +1,225 @@
+// Checks the resampler's phase-table edge and times each quality tier on
+// the rate pairs the SDL host meets, with their passband edge and the level
+// of the image or alias a near-Nyquist tone leaves behind.
+//
+//   resampler_bench [--seconds S] [--check]
+//
+// --check runs only the correctness part; `make check` builds it with
+// AddressSanitizer so a read past the coefficient table fails loudly.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../src/dsp/resampler.h"
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+struct RatePair {
+  int in;
+  int out;
+};
+
+// The engine rates against the usual device rates, including the pairs
+// whose step lands the read position a rounding error short of a whole
+// sample.
+const RatePair kRatePairs[] = {
+  {22050, 48000}, {22050, 44100}, {32000, 48000}, {32000, 44100},
+  {44100, 48000}, {48000, 44100},
+};
+
+const PolyphaseResampler::Quality kQualities[] = {
+  PolyphaseResampler::Quality::Low,
+  PolyphaseResampler::Quality::Medium,
+  PolyphaseResampler::Quality::High,
+};
+const char* const kQualityNames[] = {"low", "medium", "high"};
+const int kQualityPhases[] = {32, 64, 128};
+
+// Drives the resampler the way the SDL callback does: fixed engine blocks
+// in, device-sized reads out. Returns the output.
+std::vector<float> convert(PolyphaseResampler& r, const std::vector<float>& input) {
+  const size_t kBlock = 256;
+  const size_t kChunk = 512;
+  std::vector<float> output;
+  output.reserve(input.size() * 3);
+  float chunk[kChunk];
+  size_t fed = 0;
+  while (true) {
+    size_t got = r.read(chunk, kChunk);
+    output.insert(output.end(), chunk, chunk + got);
+    if (got < kChunk) {
+      if (fed >= input.size()) break;
+      size_t n = std::min(kBlock, input.size() - fed);
+      r.write(&input[fed], n);
+      fed += n;
+    }
+  }
+  return output;
+}
+
+std::vector<float> tone(double freq, int rate, size_t samples) {
+  std::vector<float> x(samples);
+  for (size_t i = 0; i < samples; ++i)
+    x[i] = static_cast<float>(sin(2.0 * kPi * freq * static_cast<double>(i) / rate));
+  return x;
+}
+
+// Amplitude of the component at freq, Hann-windowed to keep a strong tone
+// elsewhere from leaking into it. Skips the filter's start-up.
+double levelAt(const std::vector<float>& x, double freq, int rate) {
+  size_t skip = x.size() / 8;
+  size_t n = x.size() - skip;
+  double coeff = 2.0 * cos(2.0 * kPi * freq / rate);
+  double s1 = 0.0;
+  double s2 = 0.0;
+  double windowSum = 0.0;
+  for (size_t i = 0; i < n; ++i) {
+    double w = 0.5 - 0.5 * cos(2.0 * kPi * static_cast<double>(i) / static_cast<double>(n - 1));
+    windowSum += w;
+    double s = w * x[skip + i] + coeff * s1 - s2;
+    s2 = s1;
+    s1 = s;
+  }
+  double power = s1 * s1 + s2 * s2 - coeff * s1 * s2;
+  return 2.0 * sqrt(power > 0.0 ? power : 0.0) / windowSum;
+}
+
+double toDb(double amplitude) { return 20.0 * log10(amplitude > 1e-9 ? amplitude : 1e-9); }
+
+int failures = 0;
+
+void expect(bool ok, const char* what, int a, int b) {
+  if (ok) return;
+  printf("FAIL: %s (%d, %d)\n", what, a, b);
+  ++failures;
+}
+
+void checkPhaseRows() {
+  for (int phases : kQualityPhases) {
+    float blend = -1.0f;
+    int row = PolyphaseResampler::phaseRow(0.0, phases, blend);
+    expect(row == 0 && blend == 0.0f, "phase 0 maps to row 0", phases, row);
+    // The largest fraction short of a whole sample, and a whole sample
+    // itself, must still leave a row above the one returned.
+    row = PolyphaseResampler::phaseRow(nextafter(1.0, 0.0), phases, blend);
+    expect(row <= phases - 1 && blend >= 0.0f && blend <= 1.0f, "phase just under 1 stays in the table",
+           phases, row);
+    row = PolyphaseResampler::phaseRow(1.0, phases, blend);
+    expect(row == phases - 1 && blend == 1.0f, "phase 1 clamps to the last row", phases, row);
+    for (int i = 0; i < phases * 4; ++i) {
+      double frac = static_cast<double>(i) / (phases * 4);
+      row = PolyphaseResampler::phaseRow(frac, phases, blend);
+      expect(row >= 0 && row < phases && blend >= 0.0f && blend < 1.0f, "phase stays in the table",
+             phases, row);
+    }
+  }
+}
+
+// A full-scale tone through every pair and tier must come out bounded,
+// finite and at the right length. Under AddressSanitizer this is also the
+// check that no read leaves the coefficient table.
+void checkStreams(int seconds) {
+  for (const RatePair& pair : kRatePairs) {
+    std::vector<float> input = tone(pair.in * 0.1, pair.in, static_cast<size_t>(pair.in) * seconds);
+    for (int q = 0; q < 3; ++q) {
+      PolyphaseResampler r;
+      r.configure(static_cast<float>(pair.in), static_cast<float>(pair.out), kQualities[q], 256);
+      std::vector<float> output = convert(r, input);
+      bool bounded = true;
+      for (float v : output) bounded = bounded && std::isfinite(v) && fabsf(v) < 1.2f;
+      expect(bounded, "output bounded and finite", pair.in, pair.out);
+      double expected = static_cast<double>(input.size()) * pair.out / pair.in;
+      expect(fabs(static_cast<double>(output.size()) - expected) < 64.0, "output length", pair.in,
+             static_cast<int>(output.size()));
+    }
+  }
+}
+
+// Highest tone frequency, in 100 Hz steps, that loses under 1 dB.
+double passbandEdge(const RatePair& pair, PolyphaseResampler::Quality quality) {
+  double edge = 0.0;
+  double nyquist = 0.5 * std::min(pair.in, pair.out);
+  for (double f = 1000.0; f < nyquist; f += 100.0) {
+    PolyphaseResampler r;
+    r.configure(static_cast<float>(pair.in), static_cast<float>(pair.out), quality, 256);
+    std::vector<float> output = convert(r, tone(f, pair.in, static_cast<size_t>(pair.in) / 4));
+    if (toDb(levelAt(output, f, pair.out)) < -1.0) break;
+    edge = f;
+  }
+  return edge;
+}
+
+// Going up, a tone at 0.45 of the input rate leaves an image at in - f.
+// Going down, a tone between the two Nyquists should vanish; whatever
+// folds back to out - f is alias.
+double spuriousDb(const RatePair& pair, PolyphaseResampler::Quality quality) {
+  double f = pair.out > pair.in ? 0.45 * pair.in : 0.25 * (pair.in + pair.out);
+  double spur = pair.out > pair.in ? pair.in - f : pair.out - f;
+  PolyphaseResampler r;
+  r.configure(static_cast<float>(pair.in), static_cast<float>(pair.out), quality, 256);
+  std::vector<float> output = convert(r, tone(f, pair.in, static_cast<size_t>(pair.in)));
+  return toDb(levelAt(output, spur, pair.out));
+}
+
+double nsPerOutput(const RatePair& pair, PolyphaseResampler::Quality quality, int seconds,
+                   size_t& taps) {
+  std::vector<float> input = tone(440.0, pair.in, static_cast<size_t>(pair.in) * seconds);
+  double best = 0.0;
+  for (int run = 0; run < 5; ++run) {
+    PolyphaseResampler r;
+    r.configure(static_cast<float>(pair.in), static_cast<float>(pair.out), quality, 256);
+    taps = r.latency() * 2;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<float> output = convert(r, input);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+                  .count() / static_cast<double>(output.size());
+    if (run == 0 || ns < best) best = ns;
+  }
+  return best;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  int seconds = 5;
+  bool checkOnly = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--seconds" && i + 1 < argc) {
+      seconds = atoi(argv[++i]);
+    } else if (arg == "--check") {
+      checkOnly = true;
+    } else {
+      fprintf(stderr, "usage: %s [--seconds S] [--check]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (seconds < 1) {
+    fprintf(stderr, "--seconds must be at least 1\n");
+    return 2;
+  }
+
+  checkPhaseRows();
+  checkStreams(checkOnly ? seconds : 1);
+  printf("checks: %s\n", failures == 0 ? "ok" : "FAILED");
+  if (checkOnly || failures > 0) return failures == 0 ? 0 : 1;
+
+  printf("\n%d s of input per run, best of 5\n", seconds);
+  printf("pair          quality  taps  ns/out  x realtime  -1 dB at  image/alias\n");
+  for (const RatePair& pair : kRatePairs) {
+    for (int q = 0; q < 3; ++q) {
+      size_t taps = 0;
+      double ns = nsPerOutput(pair, kQualities[q], seconds, taps);
+      printf("%5d->%-5d  %-7s  %4zu  %6.1f  %10.0f  %5.1f kHz  %6.1f dB\n", pair.in, pair.out,
+             kQualityNames[q], taps, ns, 1e9 / (ns * pair.out), passbandEdge(pair, kQualities[q]) / 1000.0,
+             spuriousDb(pair, kQualities[q]));
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,239 @@
+// Times the Cardputer audio task's output loop against a simulated speaker,
+// with the AudioBufferRing the task uses and with the single buffer it had
+// before, and checks the ring never hands out a buffer the speaker holds.
+//
+//   ring_bench [--blocks N] [--render-ms MS]... [--check]
+//
+// The speaker plays each buffer for one block's worth of time and holds at
+// most two, one playing and one queued, like M5Unified's speaker channel.
+// Render time is simulated by spinning. --check runs a short pass and only
+// reports the ring's checks, which do not depend on timing.
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/audio/audio_buffer_ring.h"
+#include "../src/dsp/miniacid_engine.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kSpeakerSlots = 2;
+
+struct Held {
+  const int16_t* data;
+  int16_t tag; // what every frame held when it was queued
+};
+
+class SimulatedSpeaker {
+public:
+  explicit SimulatedSpeaker(Clock::duration blockTime) : blockTime_(blockTime) {
+    thread_ = std::thread([this]() { run(); });
+  }
+  ~SimulatedSpeaker() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      running_ = false;
+    }
+    wake_.notify_all();
+    thread_.join();
+  }
+
+  // Buffers the speaker still holds, the one playing included.
+  size_t isPlaying() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+  }
+  // Queues a buffer that must stay untouched until the speaker drops it.
+  void playRaw(const int16_t* data) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (queue_.size() >= kSpeakerSlots) ++overruns_;
+      queue_.push_back(Held{data, data[0]});
+    }
+    wake_.notify_all();
+  }
+  // Waits for everything queued to finish playing.
+  void drain() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    wake_.wait(lock, [this]() { return queue_.empty(); });
+  }
+
+  int played() const { return played_; }
+  double starvedSeconds() const { return std::chrono::duration<double>(starved_).count(); }
+  int overruns() const { return overruns_; }
+  int corrupted() const { return corrupted_; }
+
+private:
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    Clock::time_point freeAt;
+    while (true) {
+      wake_.wait(lock, [this]() { return !queue_.empty() || !running_; });
+      if (queue_.empty()) return;
+      Clock::time_point start = Clock::now();
+      // Any gap after the first buffer is time the speaker had nothing.
+      if (played_ > 0 && start > freeAt) starved_ += start - freeAt;
+      Held held = queue_.front();
+      lock.unlock();
+      std::this_thread::sleep_until(start + blockTime_);
+      lock.lock();
+      // The task must not have rendered into the buffer while it played.
+      for (size_t i = 0; i < AUDIO_BUFFER_SAMPLES; ++i) {
+        if (held.data[i] != held.tag) {
+          ++corrupted_;
+          break;
+        }
+      }
+      queue_.pop_front();
+      ++played_;
+      freeAt = start + blockTime_;
+      wake_.notify_all();
+    }
+  }
+
+  Clock::duration blockTime_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::deque<Held> queue_;
+  bool running_ = true;
+  int played_ = 0;
+  int overruns_ = 0;
+  int corrupted_ = 0;
+  Clock::duration starved_{};
+  std::thread thread_;
+};
+
+struct RunResult {
+  double starvedPercent;
+  long wakeups;
+  int overruns;
+  int corrupted;
+};
+
+// Stands in for generateAudioBuffer(): stamps the block and spins.
+void render(int16_t* buffer, int16_t tag, Clock::duration renderTime) {
+  for (size_t i = 0; i < AUDIO_BUFFER_SAMPLES; ++i) buffer[i] = tag;
+  Clock::time_point until = Clock::now() + renderTime;
+  while (Clock::now() < until) {
+  }
+}
+
+// vTaskDelay(1) at the Cardputer's 1 kHz tick.
+void delayTicks(long ticks, long& wakeups) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+  ++wakeups;
+}
+
+// The loop before the ring: wait for the speaker to go idle a tick at a
+// time, then render and queue the one buffer.
+RunResult runSingle(int blocks, Clock::duration blockTime, Clock::duration renderTime) {
+  static int16_t buffer[AUDIO_BUFFER_SAMPLES];
+  long wakeups = 0;
+  SimulatedSpeaker speaker(blockTime);
+  Clock::time_point start = Clock::now();
+  for (int b = 0; b < blocks; ++b) {
+    while (speaker.isPlaying() > 0) delayTicks(1, wakeups);
+    render(buffer, static_cast<int16_t>(b), renderTime);
+    speaker.playRaw(buffer);
+  }
+  speaker.drain();
+  double wall = std::chrono::duration<double>(Clock::now() - start).count();
+  return {100.0 * speaker.starvedSeconds() / wall, wakeups, speaker.overruns(), speaker.corrupted()};
+}
+
+// The audio task in miniacid.ino.
+RunResult runRing(int blocks, Clock::duration blockTime, Clock::duration renderTime) {
+  static AudioBufferRing<AUDIO_BUFFER_SAMPLES, 3> ring;
+  ring.reset();
+  long wakeups = 0;
+  long waitTicks = std::max(1L, static_cast<long>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(blockTime).count() / 4));
+  SimulatedSpeaker speaker(blockTime);
+  Clock::time_point start = Clock::now();
+  for (int b = 0; b < blocks;) {
+    ring.retire(speaker.isPlaying());
+    int16_t* buffer = ring.acquire();
+    if (!buffer) {
+      delayTicks(1, wakeups);
+      continue;
+    }
+    render(buffer, static_cast<int16_t>(b), renderTime);
+    while (speaker.isPlaying() >= kSpeakerSlots) delayTicks(waitTicks, wakeups);
+    speaker.playRaw(buffer);
+    ring.submit();
+    ++b;
+  }
+  speaker.drain();
+  double wall = std::chrono::duration<double>(Clock::now() - start).count();
+  return {100.0 * speaker.starvedSeconds() / wall, wakeups, speaker.overruns(), speaker.corrupted()};
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  int blocks = 300;
+  bool checkOnly = false;
+  std::vector<double> renderMs;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--blocks" && i + 1 < argc) {
+      blocks = atoi(argv[++i]);
+    } else if (arg == "--render-ms" && i + 1 < argc) {
+      renderMs.push_back(atof(argv[++i]));
+    } else if (arg == "--check") {
+      checkOnly = true;
+    } else {
+      fprintf(stderr, "usage: %s [--blocks N] [--render-ms MS]... [--check]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (checkOnly) {
+    if (renderMs.empty()) renderMs.push_back(2.0);
+    blocks = std::min(blocks, 100);
+  }
+  if (renderMs.empty()) renderMs = {2.0, 6.0, 10.0};
+  if (blocks < 1) {
+    fprintf(stderr, "--blocks must be at least 1\n");
+    return 2;
+  }
+
+  auto blockTime = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(static_cast<double>(AUDIO_BUFFER_SAMPLES) / SAMPLE_RATE));
+  double blockMs = 1000.0 * AUDIO_BUFFER_SAMPLES / SAMPLE_RATE;
+
+  int failures = 0;
+  if (!checkOnly) {
+    printf("%d blocks of %d frames at %d Hz (%.1f ms each)\n", blocks, AUDIO_BUFFER_SAMPLES,
+           SAMPLE_RATE, blockMs);
+    printf("render/block   single: starved  wakeups   ring: starved  wakeups\n");
+  }
+  for (double ms : renderMs) {
+    auto renderTime = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::milli>(ms));
+    RunResult ring = runRing(blocks, blockTime, renderTime);
+    if (ring.overruns > 0) {
+      printf("FAIL: %d buffers queued past the speaker's two slots\n", ring.overruns);
+      ++failures;
+    }
+    if (ring.corrupted > 0) {
+      printf("FAIL: %d buffers rendered into while the speaker held them\n", ring.corrupted);
+      ++failures;
+    }
+    if (checkOnly) continue;
+    RunResult single = runSingle(blocks, blockTime, renderTime);
+    printf("%5.1f ms              %5.1f%%  %7ld          %5.1f%%  %7ld\n", ms,
+           single.starvedPercent, single.wakeups, ring.starvedPercent, ring.wakeups);
+  }
+  printf("checks: %s\n", failures == 0 ? "ok" : "FAILED");
+  return failures == 0 ? 0 : 1;
+}
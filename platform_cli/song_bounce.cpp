@@ -0,0 +1,95 @@
+#include "song_bounce.h"
+
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <memory>
+
+#include "../src/dsp/miniacid_engine.h"
+#include "../src/audio/desktop_audio_recorder.h"
+#include "memory_scene_storage.h"
+
+BounceResult bounceScene(const std::string& json, const std::string& name,
+                         const std::string& wavPath, const BounceOptions& options) {
+  BounceResult result;
+  int rate = options.sampleRate > 0 ? options.sampleRate : SAMPLE_RATE;
+  if (!MiniAcid::isSupportedSampleRate(rate)) {
+    result.error = "unsupported sample rate " + std::to_string(rate);
+    return result;
+  }
+  // The engine falls back to its built-in scene on a bad file; refuse
+  // instead of bouncing the wrong song.
+  {
+    std::unique_ptr<SceneManager> check(new SceneManager());
+    if (!check->loadScene(json)) {
+      result.error = "not a valid scene";
+      return result;
+    }
+  }
+
+  MemorySceneStorage storage(json, name);
+  std::unique_ptr<MiniAcid> synth(new MiniAcid(static_cast<float>(rate), &storage));
+  synth->init();
+  // Same drum hit cache and oversampling as the SDL build, so a bounce
+  // sounds like the desktop app.
+  synth->enableDrumHitCache(1 << 20, 2);
+  synth->set303Oversampling(2);
+  if (options.pool) synth->setRenderPool(options.pool);
+
+  // The whole arrangement from the top, whatever loop range was saved.
+  synth->setSongMode(true);
+  synth->setLoopMode(false);
+  synth->setSongPosition(0);
+
+  DesktopAudioRecorder wav;
+  if (!wav.start(wavPath, rate, 1)) {
+    result.error = "cannot write " + wavPath;
+    return result;
+  }
+
+  int positions = synth->songLength();
+  size_t songSamples = static_cast<size_t>(options.loops) * static_cast<size_t>(positions) *
+                       SEQ_STEPS * synth->stepLengthSamples();
+  size_t tailSamples = static_cast<size_t>(options.tailSeconds * static_cast<float>(rate));
+
+  int16_t block[AUDIO_BUFFER_SAMPLES];
+  auto render = [&](size_t samples) {
+    while (samples > 0) {
+      size_t n = samples < AUDIO_BUFFER_SAMPLES ? samples : AUDIO_BUFFER_SAMPLES;
+      synth->generateAudioBuffer(block, n);
+      wav.writeSamples(block, n);
+      samples -= n;
+    }
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  synth->start();
+  render(songSamples);
+  synth->releaseForTail();
+  render(tailSamples);
+  synth->stop();
+  auto end = std::chrono::steady_clock::now();
+  wav.stop();
+
+  result.ok = true;
+  result.positions = positions;
+  result.bpm = synth->bpm();
+  result.audioSeconds = static_cast<double>(songSamples + tailSamples) / rate;
+  result.renderSeconds = std::chrono::duration<double>(end - start).count();
+  return result;
+}
+
+bool readSceneFile(const std::string& path, std::string& out) {
+  std::ifstream file(path, std::ios::in | std::ios::binary);
+  if (!file.is_open()) return false;
+  out.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  return !out.empty();
+}
+
+std::string sceneBaseName(const std::string& path) {
+  size_t slash = path.find_last_of("/\\");
+  std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+  size_t dot = name.find_last_of('.');
+  if (dot != std::string::npos && dot > 0) name.erase(dot);
+  return name;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+
+class RenderPool;
+
+struct BounceOptions {
+  int loops = 1;            // times through the song
+  float tailSeconds = 2.0f; // rendering kept up after the last step
+  int sampleRate = 0;       // 0 for the engine default
+  RenderPool* pool = nullptr;
+};
+
+struct BounceResult {
+  bool ok = false;
+  std::string error;
+  int positions = 0;
+  float bpm = 0.0f;
+  double audioSeconds = 0.0;
+  double renderSeconds = 0.0;
+};
+
+// Renders a scene's whole song arrangement from the top to a mono WAV file.
+// Each call builds its own engine, so bounces on different threads don't
+// share any state; a pool, if given, must not be shared between them.
+BounceResult bounceScene(const std::string& json, const std::string& name,
+                         const std::string& wavPath, const BounceOptions& options);
+
+bool readSceneFile(const std::string& path, std::string& out);
+
+// "scenes/foo.json" -> "foo"
+std::string sceneBaseName(const std::string& path);
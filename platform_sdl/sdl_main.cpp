@@ -1,6 +1,8 @@
 #include <cmath>
 #include <functional>
+#include <memory>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string>
 
 #include <SDL.h>
@@ -12,20 +14,36 @@
 #include "../cardputer_display.h"
 #include "../src/ui/miniacid_display.h"
 #include "../src/dsp/miniacid_engine.h"
+#include "../src/dsp/resampler.h"
 #include "scene_storage_sdl.h"
 #ifndef __EMSCRIPTEN__
 #include "../src/audio/desktop_audio_recorder.h"
+#include "../src/audio/thread_render_pool.h"
+#include "../src/audio/thread_render_split.h"
 #else
 #include "../src/audio/wasm_audio_recorder.h"
 #endif
 
+// Device samples converted per resampler read; bounds deviceBlock.
+static const size_t kDeviceChunk = 512;
+
 struct AudioContext {
-  explicit AudioContext(float sampleRate) : storage(), synth(sampleRate, &storage), device(0) {}
+  explicit AudioContext(float sampleRate) : storage(), synth(sampleRate, &storage), device(0), channels(1) {}
   SceneStorageSdl storage;
   MiniAcid synth;
   SDL_AudioDeviceID device;
+  int channels;
+  // The engine renders AUDIO_BUFFER_SAMPLES at a time at its own rate; the
+  // resampler turns that into the device's rate and period.
+  PolyphaseResampler resampler;
+  int16_t engineBlock[AUDIO_BUFFER_SAMPLES];
+  float engineSamples[AUDIO_BUFFER_SAMPLES];
+  float deviceBlock[kDeviceChunk];
 #ifndef __EMSCRIPTEN__
   DesktopAudioRecorder recorder;
+  // Helper thread for --split; outlives the device, which is closed first.
+  std::unique_ptr<ThreadRenderSplit> renderSplit;
+  std::unique_ptr<ThreadRenderPool> renderPool; // for --threads
 #else
   WasmAudioRecorder recorder;
 #endif
@@ -43,14 +61,37 @@ struct AppState {
   unsigned long lastUIUpdate = 0;
 };
 
+static void renderEngineBlock(AudioContext& ctx) {
+  ctx.synth.generateAudioBuffer(ctx.engineBlock, AUDIO_BUFFER_SAMPLES);
+  // Recordings stay at the engine rate.
+  ctx.recorder.writeSamples(ctx.engineBlock, AUDIO_BUFFER_SAMPLES);
+  for (int i = 0; i < AUDIO_BUFFER_SAMPLES; ++i)
+    ctx.engineSamples[i] = static_cast<float>(ctx.engineBlock[i]) * (1.0f / 32768.0f);
+  ctx.resampler.write(ctx.engineSamples, AUDIO_BUFFER_SAMPLES);
+}
+
 static void audioCallback(void *userdata, Uint8 *stream, int len) {
   AudioContext *ctx = static_cast<AudioContext *>(userdata);
   int16_t *out = reinterpret_cast<int16_t *>(stream);
-  size_t frames = static_cast<size_t>(len) / sizeof(int16_t);
+  size_t channels = static_cast<size_t>(ctx->channels);
+  size_t frames = static_cast<size_t>(len) / (sizeof(int16_t) * channels);
 
-  // Fill the output buffer using the synth
-  ctx->synth.generateAudioBuffer(out, frames);
-  ctx->recorder.writeSamples(out, frames);
+  size_t done = 0;
+  while (done < frames) {
+    size_t want = frames - done;
+    if (want > kDeviceChunk) want = kDeviceChunk;
+    size_t got = ctx->resampler.read(ctx->deviceBlock, want);
+    for (size_t i = 0; i < got; ++i) {
+      float v = ctx->deviceBlock[i] * 32768.0f;
+      if (v > 32767.0f) v = 32767.0f;
+      if (v < -32768.0f) v = -32768.0f;
+      int16_t sample = static_cast<int16_t>(lrintf(v));
+      for (size_t c = 0; c < channels; ++c)
+        out[(done + i) * channels + c] = sample;
+    }
+    done += got;
+    if (got < want) renderEngineBlock(*ctx);
+  }
 }
 
 static void handleEvents(AppState& s) {
@@ -186,75 +227,35 @@ static void handleEvents(AppState& s) {
         if (s.ui) s.ui->nextPage();
         if (s.ui) s.ui->update();
       } else if (sc == SDL_SCANCODE_I) {
-        SDL_LockAudioDevice(s.audio.device);
-        s.audio.synth.randomize303Pattern(0);
-        SDL_UnlockAudioDevice(s.audio.device);
+        s.audio.synth.post(EngineCommand::randomize303Pattern(0));
       } else if (sc == SDL_SCANCODE_O) {
-        SDL_LockAudioDevice(s.audio.device);
-        s.audio.synth.randomize303Pattern(1);
-        SDL_UnlockAudioDevice(s.audio.device);
+        s.audio.synth.post(EngineCommand::randomize303Pattern(1));
       } else if (sc == SDL_SCANCODE_P) {
-        SDL_LockAudioDevice(s.audio.device);
-        s.audio.synth.randomizeDrumPattern();
-        SDL_UnlockAudioDevice(s.audio.device);
+        s.audio.synth.post(EngineCommand::randomizeDrumPattern());
       } else if (sc == SDL_SCANCODE_1) {
-        SDL_LockAudioDevice(s.audio.device);
-        s.audio.synth.toggleMute303(0);
-        bool muted = s.audio.synth.is303Muted(0);
-        SDL_UnlockAudioDevice(s.audio.device);
+        s.audio.synth.post(EngineCommand::toggleMute303(0));
       } else if (sc == SDL_SCANCODE_2) {
-        SDL_LockAudioDevice(s.audio.device);
-        s.audio.synth.toggleMute303(1);
-        bool muted = s.audio.synth.is303Muted(1);
-        SDL_UnlockAudioDevice(s.audio.device);
+        s.audio.synth.post(EngineCommand::toggleMute303(1));
       } else if (sc == SDL_SCANCODE_3) {
-        SDL_LockAudioDevice(s.audio.device);
-        s.audio.synth.toggleMuteKick();
-        bool muted = s.audio.synth.isKickMuted();
-        SDL_UnlockAudioDevice(s.audio.device);
+        s.audio.synth.post(EngineCommand::toggleMuteDrum(DrumVoiceId::Kick));
       } else if (sc == SDL_SCANCODE_4) {
-        SDL_LockAudioDevice(s.audio.device);
-        s.audio.synth.toggleMuteSnare();
-        bool muted = s.audio.synth.isSnareMuted();
-        SDL_UnlockAudioDevice(s.audio.device);
+        s.audio.synth.post(EngineCommand::toggleMuteDrum(DrumVoiceId::Snare));
       } else if (sc == SDL_SCANCODE_5) {
-        SDL_LockAudioDevice(s.audio.device);
-        s.audio.synth.toggleMuteHat();
-        bool muted = s.audio.synth.isHatMuted();
-        SDL_UnlockAudioDevice(s.audio.device);
+        s.audio.synth.post(EngineCommand::toggleMuteDrum(DrumVoiceId::Hat));
       } else if (sc == SDL_SCANCODE_6) {
-        SDL_LockAudioDevice(s.audio.device);
-        s.audio.synth.toggleMuteOpenHat();
-        bool muted = s.audio.synth.isOpenHatMuted();
-        SDL_UnlockAudioDevice(s.audio.device);
+        s.audio.synth.post(EngineCommand::toggleMuteDrum(DrumVoiceId::OpenHat));
       } else if (sc == SDL_SCANCODE_7) {
-        SDL_LockAudioDevice(s.audio.device);
-        s.audio.synth.toggleMuteMidTom();
-        bool muted = s.audio.synth.isMidTomMuted();
-        SDL_UnlockAudioDevice(s.audio.device);
+        s.audio.synth.post(EngineCommand::toggleMuteDrum(DrumVoiceId::MidTom));
       } else if (sc == SDL_SCANCODE_8) {
-        SDL_LockAudioDevice(s.audio.device);
-        s.audio.synth.toggleMuteHighTom();
-        bool muted = s.audio.synth.isHighTomMuted();
-        SDL_UnlockAudioDevice(s.audio.device);
+        s.audio.synth.post(EngineCommand::toggleMuteDrum(DrumVoiceId::HighTom));
       } else if (sc == SDL_SCANCODE_9) {
-        SDL_LockAudioDevice(s.audio.device);
-        s.audio.synth.toggleMuteRim();
-        bool muted = s.audio.synth.isRimMuted();
-        SDL_UnlockAudioDevice(s.audio.device);
+        s.audio.synth.post(EngineCommand::toggleMuteDrum(DrumVoiceId::Rim));
       } else if (sc == SDL_SCANCODE_0) {
-        SDL_LockAudioDevice(s.audio.device);
-        s.audio.synth.toggleMuteClap();
-        bool muted = s.audio.synth.isClapMuted();
-        SDL_UnlockAudioDevice(s.audio.device);
+        s.audio.synth.post(EngineCommand::toggleMuteDrum(DrumVoiceId::Clap));
       } else if (sc == SDL_SCANCODE_K) {
-        SDL_LockAudioDevice(s.audio.device);
-        s.audio.synth.setBpm(s.audio.synth.bpm() - 5.0f);
-        SDL_UnlockAudioDevice(s.audio.device);
+        s.audio.synth.post(EngineCommand::setBpm(s.audio.synth.bpm() - 5.0f));
       } else if (sc == SDL_SCANCODE_L) {
-        SDL_LockAudioDevice(s.audio.device);
-        s.audio.synth.setBpm(s.audio.synth.bpm() + 5.0f);
-        SDL_UnlockAudioDevice(s.audio.device);
+        s.audio.synth.post(EngineCommand::setBpm(s.audio.synth.bpm() + 5.0f));
       }
     }
   }
@@ -301,8 +302,26 @@ static void mainLoopTick(void* userdata) {
 }
 
 int main(int argc, char **argv) {
-  (void)argc;
-  (void)argv;
+  bool cardDisplay = false;
+  bool splitRender = false;
+  int renderThreads = 1;
+  int sampleRate = SAMPLE_RATE;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "card") {
+      cardDisplay = true;
+    } else if (arg == "--split") {
+      splitRender = true;
+    } else if (arg == "--threads" && i + 1 < argc) {
+      renderThreads = atoi(argv[++i]);
+    } else if (arg == "--rate" && i + 1 < argc) {
+      int rate = atoi(argv[++i]);
+      if (MiniAcid::isSupportedSampleRate(rate))
+        sampleRate = rate;
+      else
+        fprintf(stderr, "Unsupported sample rate %d, using %d\n", rate, sampleRate);
+    }
+  }
 
   if (SDL_Init(SDL_INIT_AUDIO | SDL_INIT_EVENTS | SDL_INIT_VIDEO) != 0) {
     fprintf(stderr, "SDL_Init failed: %s\n", SDL_GetError());
@@ -314,7 +333,7 @@ int main(int argc, char **argv) {
   int winw = 240;
   int winh = 135;
 
-  if (argc > 1 && std::string(argv[1]) == "card") {
+  if (cardDisplay) {
     state.card = new CardputerDisplay();
     state.gfx = state.card;
   } else {
@@ -329,23 +348,55 @@ int main(int argc, char **argv) {
   }
 
   state.gfx->begin();
+  state.audio.synth.setSampleRate(static_cast<float>(sampleRate));
   state.audio.synth.init();
+  // 2 MB holds two takes of every hit of the largest kit.
+  state.audio.synth.enableDrumHitCache(1 << 20, 2);
+  // 2x clears most of the filter and distortion aliasing; 4x only adds
+  // to it while the resonance is low, at twice the cost.
+  state.audio.synth.set303Oversampling(2);
+#ifndef __EMSCRIPTEN__
+  if (renderThreads > 1) {
+    state.audio.renderPool.reset(new ThreadRenderPool(renderThreads));
+    state.audio.synth.setRenderPool(state.audio.renderPool.get());
+  } else if (splitRender) {
+    state.audio.renderSplit.reset(new ThreadRenderSplit());
+    state.audio.synth.setRenderSplit(state.audio.renderSplit.get());
+  }
+#else
+  (void)splitRender;
+  (void)renderThreads;
+#endif
 
+  // Ask for the device's own rate and period so SDL does no conversion of
+  // its own; the engine rate is bridged by the resampler instead.
   SDL_AudioSpec desired{};
-  desired.freq = SAMPLE_RATE;
+  desired.freq = sampleRate;
+  desired.samples = AUDIO_BUFFER_SAMPLES;
+#if SDL_VERSION_ATLEAST(2, 24, 0)
+  SDL_AudioSpec native{};
+  if (SDL_GetDefaultAudioInfo(nullptr, &native, 0) == 0) {
+    if (native.freq > 0) desired.freq = native.freq;
+    if (native.samples > 0) desired.samples = native.samples;
+  }
+#endif
   desired.format = AUDIO_S16SYS;
   desired.channels = 1;
-  desired.samples = AUDIO_BUFFER_SAMPLES;
   desired.callback = audioCallback;
   desired.userdata = &state.audio;
 
   SDL_AudioSpec obtained{};
-  state.audio.device = SDL_OpenAudioDevice(nullptr, 0, &desired, &obtained, 0);
+  state.audio.device = SDL_OpenAudioDevice(
+    nullptr, 0, &desired, &obtained,
+    SDL_AUDIO_ALLOW_FREQUENCY_CHANGE | SDL_AUDIO_ALLOW_SAMPLES_CHANGE | SDL_AUDIO_ALLOW_CHANNELS_CHANGE);
   if (state.audio.device == 0) {
     fprintf(stderr, "Failed to open audio: %s\n", SDL_GetError());
     SDL_Quit();
     return 1;
   }
+  state.audio.channels = obtained.channels > 0 ? obtained.channels : 1;
+  state.audio.resampler.configure(static_cast<float>(sampleRate), static_cast<float>(obtained.freq),
+                                  PolyphaseResampler::Quality::Medium, AUDIO_BUFFER_SAMPLES);
 
   SDL_PauseAudioDevice(state.audio.device, 0); // start playback
 
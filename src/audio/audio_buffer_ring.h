@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A fixed ring of render buffers for an output that plays straight from
+// the caller's memory, such as a speaker queue fed by I2S DMA. The audio
+// task renders into acquire(), hands that buffer to the device and calls
+// submit(). retire() frees the oldest buffers once the device reports it
+// holds fewer of them, so a buffer is never overwritten while it plays.
+//
+// With Count buffers the device can hold Count - 1 while the next one
+// renders. The ring has no locking; acquire, submit and retire all belong
+// to the audio task.
+//
+// The ring does not wait for the device itself. M5Unified's speaker has no
+// DMA-complete callback, so the Cardputer task in miniacid.ino still polls
+// Speaker.isPlaying() and sleeps with vTaskDelay(): a tick at a time while
+// the ring is full, a quarter block at a time while both speaker slots are.
+// platform_cli/ring_bench times that loop against a simulated speaker.
+template <size_t Frames, size_t Count>
+class AudioBufferRing {
+  static_assert(Count >= 2, "rendering overlaps playback only with two or more buffers");
+
+public:
+  static constexpr size_t kFrames = Frames;
+  static constexpr size_t kCount = Count;
+
+  // The buffer to render next, or nullptr while the device holds them all.
+  int16_t* acquire() {
+    if (inFlight() >= Count) return nullptr;
+    return buffers_[head_ % Count];
+  }
+  // The buffer from acquire() now belongs to the device.
+  void submit() { ++head_; }
+  // The device still holds `pending` buffers; older ones are free again.
+  void retire(size_t pending) {
+    size_t held = inFlight();
+    if (pending < held) tail_ += held - pending;
+  }
+  size_t inFlight() const { return head_ - tail_; }
+  void reset() {
+    head_ = 0;
+    tail_ = 0;
+  }
+
+private:
+  int16_t buffers_[Count][Frames] = {};
+  size_t head_ = 0; // buffers submitted
+  size_t tail_ = 0; // buffers the device has finished with
+};
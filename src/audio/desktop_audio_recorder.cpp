@@ -26,11 +26,15 @@ DesktopAudioRecorder::~DesktopAudioRecorder() {
 }
 
 bool DesktopAudioRecorder::start(int sampleRate, int channels) {
+  return start(generateTimestampFilename(), sampleRate, channels);
+}
+
+bool DesktopAudioRecorder::start(const std::string& path, int sampleRate, int channels) {
   if (file_) {
     return false;
   }
 
-  filename_ = generateTimestampFilename();
+  filename_ = path;
   file_ = std::fopen(filename_.c_str(), "wb");
   if (!file_) {
     filename_.clear();
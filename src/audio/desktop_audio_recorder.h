@@ -11,6 +11,8 @@ class DesktopAudioRecorder : public IAudioRecorder {
   ~DesktopAudioRecorder() override;
 
   bool start(int sampleRate, int channels) override;
+  // Records to path instead of a timestamped file in the working directory.
+  bool start(const std::string& path, int sampleRate, int channels);
   void stop() override;
   bool isRecording() const override;
   void writeSamples(const int16_t* samples, size_t sampleCount) override;
@@ -0,0 +1,38 @@
+#include "freertos_render_split.h"
+
+#if defined(ARDUINO)
+
+FreeRtosRenderSplit::FreeRtosRenderSplit()
+  : helper_(nullptr), caller_(nullptr), job_(nullptr), context_(nullptr) {}
+
+FreeRtosRenderSplit::~FreeRtosRenderSplit() {
+  if (helper_) vTaskDelete(helper_);
+}
+
+bool FreeRtosRenderSplit::begin(BaseType_t core, UBaseType_t priority, uint32_t stackBytes) {
+  if (helper_) return true;
+  return xTaskCreatePinnedToCore(taskEntry, "RenderHelper", stackBytes, this, priority,
+                                 &helper_, core) == pdPASS;
+}
+
+void FreeRtosRenderSplit::fork(Job job, void* context) {
+  caller_ = xTaskGetCurrentTaskHandle();
+  job_ = job;
+  context_ = context;
+  xTaskNotifyGive(helper_);
+}
+
+void FreeRtosRenderSplit::join() {
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+}
+
+void FreeRtosRenderSplit::taskEntry(void* param) {
+  FreeRtosRenderSplit* self = static_cast<FreeRtosRenderSplit*>(param);
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    self->job_(self->context_);
+    xTaskNotifyGive(self->caller_);
+  }
+}
+
+#endif // ARDUINO
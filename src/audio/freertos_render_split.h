@@ -0,0 +1,34 @@
+#pragma once
+
+#include "../dsp/render_split.h"
+
+#if defined(ARDUINO)
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// RenderSplit on a FreeRTOS task pinned to the other core of the ESP32.
+// fork() and join() hand over with direct-to-task notifications, so the
+// helper sleeps between blocks and the caller sleeps if it finishes first.
+class FreeRtosRenderSplit : public RenderSplit {
+public:
+  FreeRtosRenderSplit();
+  ~FreeRtosRenderSplit() override;
+  FreeRtosRenderSplit(const FreeRtosRenderSplit&) = delete;
+  FreeRtosRenderSplit& operator=(const FreeRtosRenderSplit&) = delete;
+
+  // Starts the helper task; false if it could not be created.
+  bool begin(BaseType_t core, UBaseType_t priority, uint32_t stackBytes);
+
+  void fork(Job job, void* context) override;
+  void join() override;
+
+private:
+  static void taskEntry(void* param);
+
+  TaskHandle_t helper_;
+  TaskHandle_t caller_;
+  Job job_;
+  void* context_;
+};
+
+#endif // ARDUINO
@@ -0,0 +1,80 @@
+#include "thread_render_pool.h"
+
+#include <chrono>
+
+#if !defined(ARDUINO)
+
+ThreadRenderPool::ThreadRenderPool(int threads)
+  : claim_(0), count_(0), done_(0), job_(nullptr), context_(nullptr), sleepers_(0), quit_(false) {
+  for (int i = 1; i < threads; ++i)
+    workers_.emplace_back(&ThreadRenderPool::workerLoop, this);
+}
+
+ThreadRenderPool::~ThreadRenderPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    quit_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread& worker : workers_) worker.join();
+}
+
+void ThreadRenderPool::run(Job job, void* context, int count) {
+  if (count <= 0) return;
+  job_ = job;
+  context_ = context;
+  count_.store(count);
+  done_.store(0);
+  uint64_t run = (claim_.load() >> 32) + 1;
+  claim_.store(run << 32);
+  // A worker counts itself in sleepers_ before its last look at claim_, so
+  // either it sees this run or we see it asleep.
+  if (sleepers_.load() > 0) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    wake_.notify_all();
+  }
+  while (runOne()) {
+  }
+  while (done_.load(std::memory_order_acquire) != count)
+    std::this_thread::yield();
+}
+
+bool ThreadRenderPool::runOne() {
+  uint64_t claim = claim_.load(std::memory_order_acquire);
+  while (true) {
+    int index = static_cast<int>(claim & 0xffffffffu);
+    // count_ can only be stale if claim_ has moved on, and then the
+    // exchange below fails.
+    if (index >= count_.load(std::memory_order_acquire))
+      return false;
+    if (claim_.compare_exchange_weak(claim, claim + 1, std::memory_order_acq_rel))
+      break;
+  }
+  // The run cannot end, and job_ cannot change, until this job is done.
+  job_(context_, static_cast<int>(claim & 0xffffffffu));
+  done_.fetch_add(1, std::memory_order_release);
+  return true;
+}
+
+void ThreadRenderPool::workerLoop() {
+  using Clock = std::chrono::steady_clock;
+  uint64_t seenRun = 0;
+  auto newRun = [&] { return (claim_.load() >> 32) != seenRun; };
+  while (!quit_.load(std::memory_order_relaxed)) {
+    Clock::time_point spinUntil = Clock::now() + std::chrono::microseconds(kSpinMicros);
+    while (!newRun() && Clock::now() < spinUntil)
+      std::this_thread::yield();
+    if (!newRun()) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      sleepers_.fetch_add(1);
+      wake_.wait(lock, [&] { return quit_.load() || newRun(); });
+      sleepers_.fetch_sub(1);
+      if (quit_.load()) return;
+    }
+    seenRun = claim_.load() >> 32;
+    while (runOne()) {
+    }
+  }
+}
+
+#endif // !ARDUINO
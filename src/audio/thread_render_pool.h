@@ -0,0 +1,52 @@
+#pragma once
+
+#include "../dsp/render_pool.h"
+
+#if !defined(ARDUINO)
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// RenderPool on std::threads, for desktop builds. Jobs are claimed one at
+// a time from a shared counter, so a thread that finishes early takes the
+// next bus rather than waiting on a fixed share. Idle workers spin for a
+// moment, like ThreadRenderSplit's helper, and then sleep until the next
+// run().
+class ThreadRenderPool : public RenderPool {
+public:
+  // threads counts the thread that calls run(), so 1 starts no workers.
+  explicit ThreadRenderPool(int threads);
+  ~ThreadRenderPool() override;
+  ThreadRenderPool(const ThreadRenderPool&) = delete;
+  ThreadRenderPool& operator=(const ThreadRenderPool&) = delete;
+
+  int threads() const { return static_cast<int>(workers_.size()) + 1; }
+  void run(Job job, void* context, int count) override;
+
+private:
+  static constexpr int kSpinMicros = 200;
+
+  // Claims the next job of the current run and does it; false once they
+  // are all taken.
+  bool runOne();
+  void workerLoop();
+
+  // The run number sits in the top half of claim_ and the next job index
+  // in the bottom half, so a worker still holding a finished run's number
+  // can never claim a job of the next one.
+  std::atomic<uint64_t> claim_;
+  std::atomic<int> count_;
+  std::atomic<int> done_;
+  Job job_;
+  void* context_;
+  std::atomic<int> sleepers_;
+  std::atomic<bool> quit_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::vector<std::thread> workers_;
+};
+
+#endif // !ARDUINO
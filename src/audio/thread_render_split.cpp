@@ -0,0 +1,59 @@
+#include "thread_render_split.h"
+
+#include <chrono>
+
+#if !defined(ARDUINO)
+
+ThreadRenderSplit::ThreadRenderSplit()
+  : job_(nullptr), context_(nullptr), forked_(0), done_(0), sleeping_(false), quit_(false) {
+  thread_ = std::thread(&ThreadRenderSplit::run, this);
+}
+
+ThreadRenderSplit::~ThreadRenderSplit() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    quit_ = true;
+  }
+  wake_.notify_one();
+  thread_.join();
+}
+
+void ThreadRenderSplit::fork(Job job, void* context) {
+  job_ = job;
+  context_ = context;
+  forked_.fetch_add(1);
+  // The helper publishes sleeping_ before its last look at forked_, so one
+  // of the two sides always sees the other.
+  if (sleeping_.load()) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    wake_.notify_one();
+  }
+}
+
+void ThreadRenderSplit::join() {
+  unsigned forked = forked_.load(std::memory_order_relaxed);
+  while (done_.load(std::memory_order_acquire) != forked)
+    std::this_thread::yield();
+}
+
+void ThreadRenderSplit::run() {
+  using Clock = std::chrono::steady_clock;
+  unsigned seen = 0;
+  while (!quit_.load(std::memory_order_relaxed)) {
+    Clock::time_point spinUntil = Clock::now() + std::chrono::microseconds(kSpinMicros);
+    while (forked_.load(std::memory_order_acquire) == seen && Clock::now() < spinUntil)
+      std::this_thread::yield();
+    if (forked_.load(std::memory_order_acquire) == seen) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      sleeping_.store(true);
+      wake_.wait(lock, [&] { return quit_.load() || forked_.load() != seen; });
+      sleeping_.store(false);
+      if (quit_.load()) return;
+    }
+    seen = forked_.load(std::memory_order_acquire);
+    job_(context_);
+    done_.store(seen, std::memory_order_release);
+  }
+}
+
+#endif // !ARDUINO
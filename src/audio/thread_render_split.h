@@ -0,0 +1,44 @@
+#pragma once
+
+#include "../dsp/render_split.h"
+
+#if !defined(ARDUINO)
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// RenderSplit on a std::thread, for desktop builds. A desktop block is only
+// tens of microseconds of work, about what it takes to wake a sleeping
+// thread, so the helper spins on the fork counter for a moment after each
+// job, long enough to catch the rest of a device period's blocks, and then
+// sleeps on the condition variable until the next period. join() spins,
+// since the caller's own half takes about as long as the helper's.
+class ThreadRenderSplit : public RenderSplit {
+public:
+  ThreadRenderSplit();
+  ~ThreadRenderSplit() override;
+  ThreadRenderSplit(const ThreadRenderSplit&) = delete;
+  ThreadRenderSplit& operator=(const ThreadRenderSplit&) = delete;
+
+  void fork(Job job, void* context) override;
+  void join() override;
+
+private:
+  // How long the helper looks for the next job before it sleeps.
+  static constexpr int kSpinMicros = 200;
+
+  void run();
+
+  Job job_;
+  void* context_;
+  std::atomic<unsigned> forked_; // jobs handed over
+  std::atomic<unsigned> done_;   // jobs finished
+  std::atomic<bool> sleeping_;
+  std::atomic<bool> quit_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::thread thread_;
+};
+
+#endif // !ARDUINO
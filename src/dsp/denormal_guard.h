@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define MINIACID_DENORMAL_SSE 1
+#elif defined(__aarch64__)
+#define MINIACID_DENORMAL_AARCH64 1
+#elif defined(__arm__) && defined(__ARM_FP)
+#define MINIACID_DENORMAL_VFP 1
+#endif
+
+// Flushes denormals to zero on the current thread while in scope and puts
+// the previous floating-point mode back on exit. Decaying feedback paths
+// (filters, delay tails, envelopes) otherwise drift into the denormal range,
+// where x86 and ARM cores slow down by an order of magnitude or more.
+//
+// SSE sets FTZ and DAZ in MXCSR, ARM sets FZ in FPCR/FPSCR. Other targets,
+// including the ESP32 and WebAssembly, have no mode to set and rely on the
+// engine putting silent voices and delay lines to sleep instead.
+class DenormalGuard {
+public:
+  DenormalGuard() {
+#if defined(MINIACID_DENORMAL_SSE)
+    saved_ = _mm_getcsr();
+    _mm_setcsr(static_cast<unsigned int>(saved_) | 0x8040u); // FTZ | DAZ
+#elif defined(MINIACID_DENORMAL_AARCH64)
+    uint64_t fpcr;
+    __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+    saved_ = fpcr;
+    fpcr |= (1ull << 24); // FZ
+    __asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr));
+#elif defined(MINIACID_DENORMAL_VFP)
+    uint32_t fpscr;
+    __asm__ __volatile__("vmrs %0, fpscr" : "=r"(fpscr));
+    saved_ = fpscr;
+    fpscr |= (1u << 24); // FZ
+    __asm__ __volatile__("vmsr fpscr, %0" : : "r"(fpscr));
+#else
+    saved_ = 0;
+#endif
+  }
+
+  ~DenormalGuard() {
+#if defined(MINIACID_DENORMAL_SSE)
+    _mm_setcsr(static_cast<unsigned int>(saved_));
+#elif defined(MINIACID_DENORMAL_AARCH64)
+    uint64_t fpcr = saved_;
+    __asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr));
+#elif defined(MINIACID_DENORMAL_VFP)
+    uint32_t fpscr = static_cast<uint32_t>(saved_);
+    __asm__ __volatile__("vmsr fpscr, %0" : : "r"(fpscr));
+#endif
+  }
+
+  DenormalGuard(const DenormalGuard&) = delete;
+  DenormalGuard& operator=(const DenormalGuard&) = delete;
+
+private:
+  uint64_t saved_;
+};
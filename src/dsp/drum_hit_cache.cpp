@@ -0,0 +1,216 @@
+#include "drum_hit_cache.h"
+
+#include <new>
+
+namespace {
+// Build order: shortest hits first, so a small budget still covers the
+// voices that are triggered most often.
+const DrumVoiceId kBuildOrder[] = {
+  DrumVoiceId::Hat,
+  DrumVoiceId::Rim,
+  DrumVoiceId::Snare,
+  DrumVoiceId::Clap,
+  DrumVoiceId::HighTom,
+  DrumVoiceId::MidTom,
+  DrumVoiceId::OpenHat,
+  DrumVoiceId::Kick,
+};
+constexpr int kBuildOrderCount = sizeof(kBuildOrder) / sizeof(kBuildOrder[0]);
+} // namespace
+
+DrumHitCache::DrumHitCache()
+  : pool_(nullptr),
+    capacity_(0),
+    used_(0),
+    takes_(1),
+    kit_(nullptr),
+    scratch_(nullptr),
+    builtVersion_(0),
+    stale_(true),
+    heldMask_(0),
+    buildIndex_(0),
+    rendering_(false),
+    hitStart_(0),
+    hits_{},
+    playing_{},
+    nextTake_{} {}
+
+DrumHitCache::~DrumHitCache() {
+  delete[] pool_;
+}
+
+bool DrumHitCache::configure(size_t maxSamples, int takes) {
+  delete[] pool_;
+  pool_ = nullptr;
+  capacity_ = 0;
+  if (takes < 1) takes = 1;
+  if (takes > kMaxTakes) takes = kMaxTakes;
+  takes_ = takes;
+  stop();
+  stale_ = true;
+  if (maxSamples == 0)
+    return false;
+  pool_ = new (std::nothrow) int16_t[maxSamples];
+  if (!pool_)
+    return false;
+  capacity_ = maxSamples;
+  return true;
+}
+
+void DrumHitCache::bind(const DrumSynthVoice* kit, DrumSynthVoice* scratch) {
+  kit_ = kit;
+  scratch_ = scratch;
+  stale_ = true;
+}
+
+bool DrumHitCache::trigger(DrumVoiceId id, bool accent) {
+  int v = static_cast<int>(id);
+  if (v < 0 || v >= kVoices)
+    return false;
+  playing_[v].data = nullptr;
+  if (!pool_ || stale_)
+    return false;
+  for (int t = 0; t < takes_; ++t) {
+    int take = (nextTake_[v] + t) % takes_;
+    const Hit& hit = hits_[v][accent ? 1 : 0][take];
+    if (!hit.ready)
+      continue;
+    nextTake_[v] = static_cast<uint8_t>((take + 1) % takes_);
+    Playback& play = playing_[v];
+    play.data = pool_ + hit.offset;
+    play.length = hit.length;
+    play.position = 0;
+    play.gain = 1.0f;
+    if (id == DrumVoiceId::Hat)
+      playing_[static_cast<int>(DrumVoiceId::OpenHat)].gain *= kHatChokeGain;
+    return true;
+  }
+  return false;
+}
+
+void DrumHitCache::cut(DrumVoiceId id) {
+  int v = static_cast<int>(id);
+  if (v >= 0 && v < kVoices)
+    playing_[v].data = nullptr;
+}
+
+void DrumHitCache::mix(float* out, size_t numSamples, uint16_t voiceMask) {
+  heldMask_ = static_cast<uint16_t>(~voiceMask);
+  for (int v = 0; v < kVoices; ++v) {
+    Playback& play = playing_[v];
+    // A muted voice holds its place, like a live kit voice left out of
+    // process(), and carries on from there when unmuted.
+    if (!play.data || !(voiceMask & drumVoiceBit(static_cast<DrumVoiceId>(v))))
+      continue;
+    size_t n = play.length - play.position;
+    if (n > numSamples) n = numSamples;
+    const int16_t* src = play.data + play.position;
+    float scale = play.gain / kSampleScale;
+    for (size_t i = 0; i < n; ++i)
+      out[i] += static_cast<float>(src[i]) * scale;
+    play.position += static_cast<uint32_t>(n);
+    if (play.position >= play.length)
+      play.data = nullptr;
+  }
+}
+
+void DrumHitCache::build(size_t numSamples) {
+  if (!pool_ || !kit_ || !scratch_)
+    return;
+  if (kit_->parameterVersion() != builtVersion_)
+    stale_ = true;
+  if (stale_) {
+    // A held hit could wait on its mute indefinitely; drop it rather than
+    // keep the whole cache from rebuilding.
+    for (int v = 0; v < kVoices; ++v) {
+      if (heldMask_ & drumVoiceBit(static_cast<DrumVoiceId>(v)))
+        playing_[v].data = nullptr;
+    }
+    // Hits from the old cache are still reading the pool.
+    if (anyPlaying())
+      return;
+    restart();
+  }
+
+  int buildCount = takes_ * kBuildOrderCount * 2;
+  while (numSamples > 0 && buildIndex_ < buildCount) {
+    DrumVoiceId id;
+    bool accent;
+    Hit& hit = hitAt(buildIndex_, &id, &accent);
+    uint16_t bit = drumVoiceBit(id);
+    if (!rendering_) {
+      scratch_->reset();
+      scratch_->trigger(id, accent);
+      hitStart_ = used_;
+      rendering_ = true;
+    }
+    if (!(scratch_->activeVoiceMask() & bit)) {
+      hit.offset = static_cast<uint32_t>(hitStart_);
+      hit.length = static_cast<uint32_t>(used_ - hitStart_);
+      hit.ready = true;
+      rendering_ = false;
+      ++buildIndex_;
+      continue;
+    }
+    size_t n = numSamples < kBuildChunk ? numSamples : kBuildChunk;
+    if (used_ + n > capacity_) {
+      // Over budget: drop this hit, it stays live, and try the next one.
+      used_ = hitStart_;
+      rendering_ = false;
+      ++buildIndex_;
+      continue;
+    }
+    scratch_->process(buildBuffer_, n, bit);
+    int16_t* dst = pool_ + used_;
+    for (size_t i = 0; i < n; ++i) {
+      float x = buildBuffer_[i] * kSampleScale;
+      if (x > 32767.0f) x = 32767.0f;
+      if (x < -32768.0f) x = -32768.0f;
+      dst[i] = static_cast<int16_t>(x >= 0.0f ? x + 0.5f : x - 0.5f);
+    }
+    used_ += n;
+    numSamples -= n;
+  }
+}
+
+void DrumHitCache::stop() {
+  for (int v = 0; v < kVoices; ++v)
+    playing_[v].data = nullptr;
+}
+
+bool DrumHitCache::anyPlaying() const {
+  for (int v = 0; v < kVoices; ++v) {
+    if (playing_[v].data)
+      return true;
+  }
+  return false;
+}
+
+void DrumHitCache::restart() {
+  for (int v = 0; v < kVoices; ++v) {
+    for (int a = 0; a < 2; ++a) {
+      for (int t = 0; t < kMaxTakes; ++t)
+        hits_[v][a][t].ready = false;
+    }
+    nextTake_[v] = 0;
+  }
+  // The scratch kit has to sound like the live one.
+  for (int p = 0; p < static_cast<int>(DrumParamId::Count); ++p) {
+    DrumParamId param = static_cast<DrumParamId>(p);
+    scratch_->setParameter(param, kit_->parameter(param).value());
+  }
+  builtVersion_ = kit_->parameterVersion();
+  used_ = 0;
+  buildIndex_ = 0;
+  rendering_ = false;
+  stale_ = false;
+}
+
+DrumHitCache::Hit& DrumHitCache::hitAt(int buildIndex, DrumVoiceId* id, bool* accent) {
+  // All voices get their first take before any voice gets a second one.
+  int take = buildIndex / (kBuildOrderCount * 2);
+  int rest = buildIndex % (kBuildOrderCount * 2);
+  *id = kBuildOrder[rest / 2];
+  *accent = (rest % 2) != 0;
+  return hits_[static_cast<int>(*id)][*accent ? 1 : 0][take];
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mini_drumvoices.h"
+
+// "Render once, play many" for the drum kits. Every kit voice's plain and
+// accented hits are rendered into 16-bit buffers and later triggers play the
+// buffers back instead of synthesizing the hit again.
+//
+// The cache fills itself a slice per audio block on a scratch instance of the
+// kit, so building it costs no spike and shares no state with the live kit.
+// Until a hit is ready, trigger() returns false and the kit plays it live.
+// Hits are built shortest voices first, and whatever does not fit in the
+// configured budget keeps playing live. Several takes of each hit can be
+// kept so noisy voices do not repeat the exact same noise.
+//
+// The 606 voices share an accent envelope; cached hits are rendered in
+// isolation, so they do not pick up the accent of other voices hit on the
+// same step.
+class DrumHitCache {
+public:
+  static constexpr int kMaxTakes = 4;
+
+  DrumHitCache();
+  ~DrumHitCache();
+  DrumHitCache(const DrumHitCache&) = delete;
+  DrumHitCache& operator=(const DrumHitCache&) = delete;
+
+  // Reserves maxSamples of hit storage and keeps `takes` renders of every
+  // hit. Returns false, leaving the cache disabled, if the memory is not
+  // available. Call before the audio thread starts.
+  bool configure(size_t maxSamples, int takes);
+  bool isEnabled() const { return pool_ != nullptr; }
+
+  // Caches hits of `kit`, rendering them on `scratch`, a spare instance of
+  // the same kit type. Hits from the previous kit finish playing before its
+  // buffers are reused.
+  void bind(const DrumSynthVoice* kit, DrumSynthVoice* scratch);
+
+  // Starts the cached hit, cutting the voice's previous one. False means
+  // it is not ready and should be triggered on the live kit. A closed hat
+  // chokes the cached open hat the way the kits do.
+  bool trigger(DrumVoiceId id, bool accent);
+  // Stops the voice's cached hit, e.g. when it is retriggered live.
+  void cut(DrumVoiceId id);
+  // Adds the playing hits whose drumVoiceBit() is set in voiceMask to out.
+  // The others hold their place, as live voices do.
+  void mix(float* out, size_t numSamples, uint16_t voiceMask);
+  // Renders up to numSamples more of the cache; call once per audio block.
+  void build(size_t numSamples);
+  // Silences all playing hits.
+  void stop();
+
+private:
+  static constexpr int kVoices = static_cast<int>(DrumVoiceId::Count);
+  static constexpr size_t kBuildChunk = 128;
+  // Samples are stored as value * kSampleScale, covering +-2.
+  static constexpr float kSampleScale = 16384.0f;
+  static constexpr float kHatChokeGain = 0.25f;
+
+  struct Hit {
+    uint32_t offset;
+    uint32_t length;
+    bool ready;
+  };
+
+  struct Playback {
+    const int16_t* data;
+    uint32_t length;
+    uint32_t position;
+    float gain;
+  };
+
+  bool anyPlaying() const;
+  void restart();
+  Hit& hitAt(int buildIndex, DrumVoiceId* id, bool* accent);
+
+  int16_t* pool_;
+  size_t capacity_;
+  size_t used_;
+  int takes_;
+
+  const DrumSynthVoice* kit_;
+  DrumSynthVoice* scratch_;
+  uint32_t builtVersion_;
+  bool stale_;
+  uint16_t heldMask_;   // voices mix() last left out
+
+  int buildIndex_;      // next hit to render, see hitAt()
+  bool rendering_;      // the hit at buildIndex_ is partly rendered
+  size_t hitStart_;     // pool offset of the hit being rendered
+
+  Hit hits_[kVoices][2][kMaxTakes];
+  Playback playing_[kVoices];
+  uint8_t nextTake_[kVoices];
+  float buildBuffer_[kBuildChunk];
+};
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+// Cheap replacements for the libm calls in the per-sample DSP paths.
+//
+// Every voice calls the dsp* wrappers at the bottom of this file. Building
+// with MINIACID_FAST_MATH=0 routes them back to libm, e.g. to A/B a change
+// against the reference maths.
+//
+// Measured worst-case error against double-precision libm:
+//   fastSin2Pi  |err| < 5e-6 absolute for any phase
+//   fastTanPi   relative err < 2.5e-5 for x <= 0.45, < 6e-4 for x <= 0.49
+//   fastTanh    |err| < 1.1e-6 absolute for |x| <= 3, < 1e-4 everywhere
+//   fastExp     relative err < 1e-5 for x in [-87, 88], 0 below
+//   fastLog     |err| < 1.1e-6 absolute for x in [1e-6, 1e6]
+#ifndef MINIACID_FAST_MATH
+#define MINIACID_FAST_MATH 1
+#endif
+
+namespace fast_math_detail {
+
+constexpr int kSineTableBits = 10;
+constexpr int kSineTableSize = 1 << kSineTableBits;
+constexpr double kPi = 3.14159265358979323846;
+
+// Taylor series around zero after folding the argument into [-pi, pi];
+// only ever evaluated at compile time.
+constexpr double constexprSin(double x) {
+  while (x > kPi) x -= 2.0 * kPi;
+  while (x < -kPi) x += 2.0 * kPi;
+  double term = x;
+  double sum = x;
+  for (int n = 1; n < 16; ++n) {
+    term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+    sum += term;
+  }
+  return sum;
+}
+
+struct SineTable {
+  // One guard entry so interpolation never has to wrap the upper index.
+  float values[kSineTableSize + 1];
+};
+
+constexpr SineTable makeSineTable() {
+  SineTable table{};
+  for (int i = 0; i <= kSineTableSize; ++i) {
+    table.values[i] = static_cast<float>(constexprSin(2.0 * kPi * i / kSineTableSize));
+  }
+  return table;
+}
+
+constexpr SineTable kSineTable = makeSineTable();
+
+constexpr int kTanTableSize = 1024;
+
+struct TanTable {
+  float values[kTanTableSize];
+};
+
+// tan(pi * x) at x = i / (2 * kTanTableSize), i.e. across [0, 0.5) up to
+// one step short of the pole.
+constexpr TanTable makeTanTable() {
+  TanTable table{};
+  for (int i = 0; i < kTanTableSize; ++i) {
+    double x = kPi * i / (2.0 * kTanTableSize);
+    table.values[i] = static_cast<float>(constexprSin(x) / constexprSin(x + 0.5 * kPi));
+  }
+  return table;
+}
+
+constexpr TanTable kTanTable = makeTanTable();
+
+inline int floorToInt(float x) {
+  int i = static_cast<int>(x);
+  return i - (x < static_cast<float>(i) ? 1 : 0);
+}
+
+} // namespace fast_math_detail
+
+// sin(2 * pi * phase), from a 1024-entry table with linear interpolation.
+inline float fastSin2Pi(float phase) {
+  using namespace fast_math_detail;
+  float x = phase * static_cast<float>(kSineTableSize);
+  int i = floorToInt(x);
+  float frac = x - static_cast<float>(i);
+  i &= kSineTableSize - 1;
+  float a = kSineTable.values[i];
+  float b = kSineTable.values[i + 1];
+  return a + (b - a) * frac;
+}
+
+// tan(pi * x) for x in [0, 0.5), from a 1024-entry table with linear
+// interpolation. x is clamped to the table, whose top (just short of the
+// pole at 0.5) is about 650.
+inline float fastTanPi(float x) {
+  using namespace fast_math_detail;
+  float pos = x * static_cast<float>(2 * kTanTableSize);
+  if (!(pos > 0.0f)) return 0.0f;
+  if (pos > static_cast<float>(kTanTableSize - 1)) pos = static_cast<float>(kTanTableSize - 1);
+  int i = static_cast<int>(pos);
+  if (i > kTanTableSize - 2) i = kTanTableSize - 2;
+  float frac = pos - static_cast<float>(i);
+  float a = kTanTable.values[i];
+  float b = kTanTable.values[i + 1];
+  return a + (b - a) * frac;
+}
+
+// 7/6 Pade approximant of tanh, clamped where it crosses +-1.
+inline float fastTanh(float x) {
+  if (x > 4.97f) return 1.0f;
+  if (x < -4.97f) return -1.0f;
+  float x2 = x * x;
+  float num = x * (135135.0f + x2 * (17325.0f + x2 * (378.0f + x2)));
+  float den = 135135.0f + x2 * (62370.0f + x2 * (3150.0f + x2 * 28.0f));
+  return num / den;
+}
+
+// 2^x as 2^round(x) from the exponent bits times a degree-5 polynomial for
+// the remaining fraction in [-0.5, 0.5].
+inline float fastExp2(float x) {
+  if (x < -126.0f) return 0.0f;
+  if (x > 127.0f) x = 127.0f;
+  int i = fast_math_detail::floorToInt(x + 0.5f);
+  float f = x - static_cast<float>(i);
+  float p = 1.0f + f * (0.693147181f + f * (0.240226507f + f * (0.0555041087f +
+            f * (0.00961812911f + f * 0.00133335581f))));
+  uint32_t bits = static_cast<uint32_t>(i + 127) << 23;
+  float scale;
+  memcpy(&scale, &bits, sizeof(scale));
+  return p * scale;
+}
+
+inline float fastExp(float x) {
+  return fastExp2(x * 1.44269504f);
+}
+
+// log(x) for x > 0 as e * log(2) from the exponent bits plus
+// 2 * atanh((m - 1) / (m + 1)) for the mantissa m in [sqrt(0.5), sqrt(2)),
+// summed to the s^7 term.
+inline float fastLog(float x) {
+  uint32_t bits;
+  memcpy(&bits, &x, sizeof(bits));
+  int e = static_cast<int>((bits >> 23) & 0xff) - 127;
+  bits = (bits & 0x007fffffu) | 0x3f800000u;
+  float m;
+  memcpy(&m, &bits, sizeof(m));
+  if (m > 1.41421356f) {
+    m *= 0.5f;
+    ++e;
+  }
+  float s = (m - 1.0f) / (m + 1.0f);
+  float s2 = s * s;
+  float series = s * (2.0f + s2 * (0.666666667f + s2 * (0.4f + s2 * 0.285714286f)));
+  return static_cast<float>(e) * 0.693147181f + series;
+}
+
+#if MINIACID_FAST_MATH
+inline float dspSin2Pi(float phase) { return fastSin2Pi(phase); }
+inline float dspTanPi(float x) { return fastTanPi(x); }
+inline float dspTanh(float x) { return fastTanh(x); }
+inline float dspExp(float x) { return fastExp(x); }
+inline float dspLog(float x) { return fastLog(x); }
+#else
+inline float dspSin2Pi(float phase) { return sinf(2.0f * 3.14159265f * phase); }
+inline float dspTanPi(float x) {
+  // Same domain as the table, so both builds stop short of the pole alike.
+  const float kMaxX = 1023.0f / 2048.0f;
+  if (!(x > 0.0f)) return 0.0f;
+  return tanf(3.14159265f * (x < kMaxX ? x : kMaxX));
+}
+inline float dspTanh(float x) { return tanhf(x); }
+inline float dspExp(float x) { return expf(x); }
+inline float dspLog(float x) { return logf(x); }
+#endif
@@ -2,8 +2,10 @@
 
 #include <math.h>
 
+#include "fast_math.h"
+
 ChamberlinFilterBase::ChamberlinFilterBase(float sampleRate) 
-    : _lp(0.0f), _bp(0.0f), _hp(0.0f), _sampleRate(sampleRate) {
+    : _lp(0.0f), _bp(0.0f), _hp(0.0f), _f(-1.0f), _sampleRate(sampleRate) {
   if (_sampleRate <= 0.0f) _sampleRate = 44100.0f;
 }
 
@@ -11,26 +13,50 @@ void ChamberlinFilterBase::reset() {
   _lp = 0.0f;
   _bp = 0.0f;
   _hp = 0.0f;
+  _f = -1.0f;
 }
 
 void ChamberlinFilterBase::setSampleRate(float sr) {
   if (sr <= 0.0f) sr = 44100.0f;
   _sampleRate = sr;
+  _f = -1.0f;
 }
 
-void ChamberlinFilterBase::processInternal(float input, float cutoffHz, float resonance) {
-  float f = 2.0f * sinf(3.14159265f * cutoffHz / _sampleRate);
+float ChamberlinFilterBase::cutoffCoeff(float cutoffHz) const {
+  float f = 2.0f * dspSin2Pi(0.5f * cutoffHz / _sampleRate);
   if (!isfinite(f))
     f = 0.0f;
+  return f;
+}
+
+float ChamberlinFilterBase::resonanceCoeff(float resonance) {
   float q = 1.0f / (1.0f + resonance * 4.0f);
   if (q < 0.06f)
     q = 0.06f;
+  return q;
+}
+
+float ChamberlinFilterBase::rampIncrement(float cutoffHz, size_t numSamples) {
+  float target = cutoffCoeff(cutoffHz);
+  if (_f < 0.0f || numSamples == 0) {
+    // Nothing to ramp from yet; start right on the target.
+    _f = target;
+    return 0.0f;
+  }
+  return (target - _f) / static_cast<float>(numSamples);
+}
+
+void ChamberlinFilterBase::processInternal(float input, float cutoffHz, float resonance) {
+  _f = cutoffCoeff(cutoffHz);
+  tick(input, _f, resonanceCoeff(resonance));
+}
 
+void ChamberlinFilterBase::tick(float input, float f, float q) {
   _hp = input - _lp - q * _bp;
   _bp += f * _hp;
   _lp += f * _bp;
 
-  _bp = tanhf(_bp * 1.3f);
+  _bp = dspTanh(_bp * 1.3f);
 
   // Keep states bounded to avoid numeric blowups
   const float kStateLimit = 50.0f;
@@ -42,17 +68,316 @@ void ChamberlinFilterBase::processInternal(float input, float cutoffHz, float re
   if (_hp < -kStateLimit) _hp = -kStateLimit;
 }
 
+float ChamberlinFilterBase::tapOutput(SvfTap tap) const {
+  switch (tap) {
+    case SvfTap::Bandpass:
+      return _bp;
+    case SvfTap::Highpass:
+      return _hp;
+    case SvfTap::Lowpass:
+    default:
+      return _lp;
+  }
+}
+
+template <SvfTap Tap>
+void ChamberlinFilterBase::rampTap(float* samples, size_t numSamples, float cutoffHz, float resonance) {
+  float q = resonanceCoeff(resonance);
+  float inc = rampIncrement(cutoffHz, numSamples);
+  for (size_t i = 0; i < numSamples; ++i) {
+    _f += inc;
+    tick(samples[i], _f, q);
+    // Tap is a template argument, so this folds to a single load.
+    samples[i] = tapOutput(Tap);
+  }
+}
+
 float ChamberlinFilterLp::process(float input, float cutoffHz, float resonance) {
   processInternal(input, cutoffHz, resonance);
   return _lp;
 }
 
+void ChamberlinFilterLp::processRamp(float* samples, size_t numSamples, float cutoffHz, float resonance) {
+  rampTap<SvfTap::Lowpass>(samples, numSamples, cutoffHz, resonance);
+}
+
 float ChamberlinFilterBp::process(float input, float cutoffHz, float resonance) {
   processInternal(input, cutoffHz, resonance);
   return _bp;
 }
 
+void ChamberlinFilterBp::processRamp(float* samples, size_t numSamples, float cutoffHz, float resonance) {
+  rampTap<SvfTap::Bandpass>(samples, numSamples, cutoffHz, resonance);
+}
+
 float ChamberlinFilterHp::process(float input, float cutoffHz, float resonance) {
   processInternal(input, cutoffHz, resonance);
   return _hp;
 }
+
+void ChamberlinFilterHp::processRamp(float* samples, size_t numSamples, float cutoffHz, float resonance) {
+  rampTap<SvfTap::Highpass>(samples, numSamples, cutoffHz, resonance);
+}
+
+ChamberlinFilterMulti::ChamberlinFilterMulti(float sampleRate)
+    : ChamberlinFilterBase(sampleRate),
+      _tap(SvfTap::Lowpass),
+      _fadeFrom(SvfTap::Lowpass),
+      _fadeRemaining(0) {}
+
+void ChamberlinFilterMulti::reset() {
+  ChamberlinFilterBase::reset();
+  _fadeRemaining = 0;
+}
+
+void ChamberlinFilterMulti::setTap(SvfTap tap) {
+  if (tap == _tap)
+    return;
+  _fadeFrom = _tap;
+  _tap = tap;
+  _fadeRemaining = kTapFadeSamples;
+}
+
+float ChamberlinFilterMulti::process(float input, float cutoffHz, float resonance) {
+  processInternal(input, cutoffHz, resonance);
+  return output();
+}
+
+float ChamberlinFilterMulti::output() {
+  if (_fadeRemaining == 0)
+    return tapOutput(_tap);
+  --_fadeRemaining;
+  float mix = 1.0f - static_cast<float>(_fadeRemaining) / static_cast<float>(kTapFadeSamples);
+  float from = tapOutput(_fadeFrom);
+  return from + (tapOutput(_tap) - from) * mix;
+}
+
+void ChamberlinFilterMulti::processRamp(float* samples, size_t numSamples, float cutoffHz, float resonance) {
+  if (_fadeRemaining > 0) {
+    float q = resonanceCoeff(resonance);
+    float inc = rampIncrement(cutoffHz, numSamples);
+    for (size_t i = 0; i < numSamples; ++i) {
+      _f += inc;
+      tick(samples[i], _f, q);
+      samples[i] = output();
+    }
+    return;
+  }
+  switch (_tap) {
+    case SvfTap::Bandpass:
+      rampTap<SvfTap::Bandpass>(samples, numSamples, cutoffHz, resonance);
+      break;
+    case SvfTap::Highpass:
+      rampTap<SvfTap::Highpass>(samples, numSamples, cutoffHz, resonance);
+      break;
+    case SvfTap::Lowpass:
+    default:
+      rampTap<SvfTap::Lowpass>(samples, numSamples, cutoffHz, resonance);
+      break;
+  }
+}
+
+TptFilterBase::TptFilterBase(float sampleRate) : _g(-1.0f), _sampleRate(sampleRate) {
+  if (_sampleRate <= 0.0f) _sampleRate = 44100.0f;
+}
+
+void TptFilterBase::setSampleRate(float sr) {
+  if (sr <= 0.0f) sr = 44100.0f;
+  _sampleRate = sr;
+  _g = -1.0f;
+}
+
+float TptFilterBase::tuningCoeff(float cutoffHz) const {
+  // dspTanPi stops just short of Nyquist and returns 0 for NaN, so g is
+  // always finite and non-negative.
+  return dspTanPi(cutoffHz / _sampleRate);
+}
+
+float TptFilterBase::rampIncrement(float target, size_t numSamples) {
+  if (_g < 0.0f || numSamples == 0) {
+    _g = target;
+    return 0.0f;
+  }
+  return (target - _g) / static_cast<float>(numSamples);
+}
+
+TptSvfFilter::TptSvfFilter(float sampleRate)
+    : TptFilterBase(sampleRate),
+      _ic1(0.0f),
+      _ic2(0.0f),
+      _lp(0.0f),
+      _bp(0.0f),
+      _hp(0.0f),
+      _tap(SvfTap::Lowpass),
+      _fadeFrom(SvfTap::Lowpass),
+      _fadeRemaining(0) {}
+
+void TptSvfFilter::reset() {
+  _ic1 = 0.0f;
+  _ic2 = 0.0f;
+  _lp = 0.0f;
+  _bp = 0.0f;
+  _hp = 0.0f;
+  _g = -1.0f;
+  _fadeRemaining = 0;
+}
+
+void TptSvfFilter::setTap(SvfTap tap) {
+  if (tap == _tap)
+    return;
+  _fadeFrom = _tap;
+  _tap = tap;
+  _fadeRemaining = kTapFadeSamples;
+}
+
+float TptSvfFilter::dampingCoeff(float resonance) {
+  // Same curve as the Chamberlin filter's q, so a patch keeps its peak.
+  float k = 1.0f / (1.0f + resonance * 4.0f);
+  if (k < 0.06f)
+    k = 0.06f;
+  return k;
+}
+
+void TptSvfFilter::tick(float input, float g, float k) {
+  // Any g >= 0 and k > 0 keep the poles inside the unit circle.
+  float a1 = 1.0f / (1.0f + g * (g + k));
+  float v3 = input - _ic2;
+  float v1 = a1 * (_ic1 + g * v3);
+  float v2 = _ic2 + g * v1;
+  _ic1 = 2.0f * v1 - _ic1;
+  _ic2 = 2.0f * v2 - _ic2;
+  _lp = v2;
+  _bp = v1;
+  _hp = input - k * v1 - v2;
+}
+
+float TptSvfFilter::tapOutput(SvfTap tap) const {
+  switch (tap) {
+    case SvfTap::Bandpass:
+      return _bp;
+    case SvfTap::Highpass:
+      return _hp;
+    case SvfTap::Lowpass:
+    default:
+      return _lp;
+  }
+}
+
+float TptSvfFilter::output() {
+  if (_fadeRemaining == 0)
+    return tapOutput(_tap);
+  --_fadeRemaining;
+  float mix = 1.0f - static_cast<float>(_fadeRemaining) / static_cast<float>(kTapFadeSamples);
+  float from = tapOutput(_fadeFrom);
+  return from + (tapOutput(_tap) - from) * mix;
+}
+
+float TptSvfFilter::process(float input, float cutoffHz, float resonance) {
+  _g = tuningCoeff(cutoffHz);
+  tick(input, _g, dampingCoeff(resonance));
+  return output();
+}
+
+template <SvfTap Tap>
+void TptSvfFilter::rampTap(float* samples, size_t numSamples, float cutoffHz, float resonance) {
+  float k = dampingCoeff(resonance);
+  float inc = rampIncrement(tuningCoeff(cutoffHz), numSamples);
+  for (size_t i = 0; i < numSamples; ++i) {
+    _g += inc;
+    tick(samples[i], _g, k);
+    samples[i] = tapOutput(Tap);
+  }
+}
+
+void TptSvfFilter::processRamp(float* samples, size_t numSamples, float cutoffHz, float resonance) {
+  if (_fadeRemaining > 0) {
+    float k = dampingCoeff(resonance);
+    float inc = rampIncrement(tuningCoeff(cutoffHz), numSamples);
+    for (size_t i = 0; i < numSamples; ++i) {
+      _g += inc;
+      tick(samples[i], _g, k);
+      samples[i] = output();
+    }
+    return;
+  }
+  switch (_tap) {
+    case SvfTap::Bandpass:
+      rampTap<SvfTap::Bandpass>(samples, numSamples, cutoffHz, resonance);
+      break;
+    case SvfTap::Highpass:
+      rampTap<SvfTap::Highpass>(samples, numSamples, cutoffHz, resonance);
+      break;
+    case SvfTap::Lowpass:
+    default:
+      rampTap<SvfTap::Lowpass>(samples, numSamples, cutoffHz, resonance);
+      break;
+  }
+}
+
+TptLadderFilter::TptLadderFilter(float sampleRate) : TptFilterBase(sampleRate) {
+  reset();
+}
+
+void TptLadderFilter::reset() {
+  for (int i = 0; i < 4; ++i)
+    _s[i] = 0.0f;
+  _g = -1.0f;
+}
+
+float TptLadderFilter::feedbackCoeff(float resonance) {
+  const float kMaxFeedback = 3.9f;
+  float k = resonance * 4.0f;
+  if (k < 0.0f) k = 0.0f;
+  if (k > kMaxFeedback) k = kMaxFeedback;
+  return k;
+}
+
+float TptLadderFilter::stageGain(float cutoffHz) const {
+  float g = tuningCoeff(cutoffHz);
+  return g / (1.0f + g);
+}
+
+float TptLadderFilter::tick(float input, float G, float k) {
+  // Each one-pole outputs G * x + (1 - G) * s, so stage i outputs
+  // G^(i+1) * u plus a term Ti built from the states up to it. Solving
+  // u = input - k * y3 for u closes the loop without a unit delay. Writing
+  // every stage against u directly, rather than chaining them, keeps the
+  // sample-to-sample dependency short; the divide depends only on the
+  // tuning.
+  float G2 = G * G;
+  float G3 = G2 * G;
+  float G4 = G2 * G2;
+  float h = 1.0f - G;
+  float S0 = h * _s[0];
+  float S1 = h * _s[1];
+  float S2 = h * _s[2];
+  float S3 = h * _s[3];
+  float T1 = G * S0 + S1;
+  float T2 = G2 * S0 + G * S1 + S2;
+  float T3 = G3 * S0 + G2 * S1 + G * S2 + S3;
+  float scale = 1.0f / (1.0f + k * G4);
+  float u = (input - k * T3) * scale;
+  float y0 = G * u + S0;
+  float y1 = G2 * u + T1;
+  float y2 = G3 * u + T2;
+  float y3 = G4 * u + T3;
+  _s[0] = 2.0f * y0 - _s[0];
+  _s[1] = 2.0f * y1 - _s[1];
+  _s[2] = 2.0f * y2 - _s[2];
+  _s[3] = 2.0f * y3 - _s[3];
+  return y3 * (1.0f + 0.5f * k);
+}
+
+float TptLadderFilter::process(float input, float cutoffHz, float resonance) {
+  _g = stageGain(cutoffHz);
+  return tick(input, _g, feedbackCoeff(resonance));
+}
+
+void TptLadderFilter::processRamp(float* samples, size_t numSamples, float cutoffHz, float resonance) {
+  float k = feedbackCoeff(resonance);
+  float inc = rampIncrement(stageGain(cutoffHz), numSamples);
+  for (size_t i = 0; i < numSamples; ++i) {
+    _g += inc;
+    samples[i] = tick(samples[i], _g, k);
+  }
+}
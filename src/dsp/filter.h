@@ -1,5 +1,8 @@
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
 class AudioFilter {
 public:
   virtual ~AudioFilter() = default;
@@ -7,6 +10,18 @@ public:
   virtual void reset() = 0;
   virtual void setSampleRate(float sr) = 0;
   virtual float process(float input, float cutoffHz, float resonance) = 0;
+  // Filters numSamples in place at control rate: the tuning coefficient is
+  // computed once for cutoffHz and ramped linearly from where the previous
+  // call left it, so the per-sample cost is just the filter update.
+  virtual void processRamp(float* samples, size_t numSamples, float cutoffHz, float resonance) = 0;
+};
+
+// A state variable filter computes all three responses from one state; a
+// tap picks which one is returned.
+enum class SvfTap : uint8_t {
+  Lowpass = 0,
+  Bandpass,
+  Highpass,
 };
 
 class ChamberlinFilterBase {
@@ -17,9 +32,18 @@ public:
   void processInternal(float input, float cutoffHz, float resonance);
 
 protected:
+  float cutoffCoeff(float cutoffHz) const;
+  static float resonanceCoeff(float resonance);
+  float rampIncrement(float cutoffHz, size_t numSamples);
+  void tick(float input, float f, float q);
+  float tapOutput(SvfTap tap) const;
+  template <SvfTap Tap>
+  void rampTap(float* samples, size_t numSamples, float cutoffHz, float resonance);
+
   float _lp;
   float _bp;
   float _hp;
+  float _f; // last tuning coefficient, negative until the first sample
   float _sampleRate;
 };
 
@@ -29,6 +53,7 @@ public:
   void reset() override { ChamberlinFilterBase::reset(); }
   void setSampleRate(float sr) override { ChamberlinFilterBase::setSampleRate(sr); }
   float process(float input, float cutoffHz, float resonance) override;
+  void processRamp(float* samples, size_t numSamples, float cutoffHz, float resonance) override;
 };
 
 class ChamberlinFilterBp : public AudioFilter, protected ChamberlinFilterBase {
@@ -37,6 +62,7 @@ public:
   void reset() override { ChamberlinFilterBase::reset(); }
   void setSampleRate(float sr) override { ChamberlinFilterBase::setSampleRate(sr); }
   float process(float input, float cutoffHz, float resonance) override;
+  void processRamp(float* samples, size_t numSamples, float cutoffHz, float resonance) override;
 };
 
 class ChamberlinFilterHp : public AudioFilter, protected ChamberlinFilterBase {
@@ -45,6 +71,107 @@ public:
   void reset() override { ChamberlinFilterBase::reset(); }
   void setSampleRate(float sr) override { ChamberlinFilterBase::setSampleRate(sr); }
   float process(float input, float cutoffHz, float resonance) override;
+  void processRamp(float* samples, size_t numSamples, float cutoffHz, float resonance) override;
+};
+
+// All three responses behind a tap selected at runtime, without virtual
+// calls or reallocation. Changing the tap keeps the filter state and
+// crossfades from the old response to the new one over a few milliseconds,
+// so switching while a note rings does not click.
+class ChamberlinFilterMulti : protected ChamberlinFilterBase {
+public:
+  explicit ChamberlinFilterMulti(float sampleRate);
+  void reset();
+  void setSampleRate(float sr) { ChamberlinFilterBase::setSampleRate(sr); }
+  void setTap(SvfTap tap);
+  SvfTap tap() const { return _tap; }
+  float process(float input, float cutoffHz, float resonance);
+  void processRamp(float* samples, size_t numSamples, float cutoffHz, float resonance);
+
+private:
+  static constexpr int kTapFadeSamples = 64;
+
+  float output();
+
+  SvfTap _tap;
+  SvfTap _fadeFrom;
+  int _fadeRemaining; // samples left in the crossfade after a tap change
+};
+
+// Zero-delay-feedback filters built from trapezoidal (TPT) integrators.
+// The feedback loop is solved each sample rather than delayed by one, so
+// the response matches the analog prototype right up to Nyquist and the
+// filters are stable at any cutoff without clamping their state. Cutoff is
+// prewarped with tan(pi * fc / fs) from the fast_math table.
+class TptFilterBase {
+public:
+  explicit TptFilterBase(float sampleRate);
+  void setSampleRate(float sr);
+
+protected:
+  float tuningCoeff(float cutoffHz) const;
+  // Per-sample step taking _g to target over numSamples.
+  float rampIncrement(float target, size_t numSamples);
+
+  // Last ramped coefficient, negative until the first sample. The ladder
+  // keeps its stage gain here rather than g.
+  float _g;
+  float _sampleRate;
+};
+
+// The 2-pole SVF, with the same taps, resonance range and tap crossfade as
+// ChamberlinFilterMulti. It is linear, so high resonance rings longer and
+// louder than the Chamberlin filter's saturated band.
+class TptSvfFilter final : public AudioFilter, protected TptFilterBase {
+public:
+  explicit TptSvfFilter(float sampleRate);
+  void reset() override;
+  void setSampleRate(float sr) override { TptFilterBase::setSampleRate(sr); }
+  void setTap(SvfTap tap);
+  SvfTap tap() const { return _tap; }
+  float process(float input, float cutoffHz, float resonance) override;
+  void processRamp(float* samples, size_t numSamples, float cutoffHz, float resonance) override;
+
+private:
+  static constexpr int kTapFadeSamples = 64;
+
+  static float dampingCoeff(float resonance);
+  void tick(float input, float g, float k);
+  float tapOutput(SvfTap tap) const;
+  float output();
+  template <SvfTap Tap>
+  void rampTap(float* samples, size_t numSamples, float cutoffHz, float resonance);
+
+  float _ic1; // trapezoidal integrator states
+  float _ic2;
+  float _lp;
+  float _bp;
+  float _hp;
+  SvfTap _tap;
+  SvfTap _fadeFrom;
+  int _fadeRemaining;
+};
+
+// 4-pole (24 dB/octave) lowpass ladder: four TPT one-poles inside a global
+// feedback loop. Resonance 0..1 maps to a loop gain short of the 4 at which
+// it would self-oscillate; the output is partly gain-compensated for the
+// bass the feedback removes.
+class TptLadderFilter final : public AudioFilter, protected TptFilterBase {
+public:
+  explicit TptLadderFilter(float sampleRate);
+  void reset() override;
+  void setSampleRate(float sr) override { TptFilterBase::setSampleRate(sr); }
+  float process(float input, float cutoffHz, float resonance) override;
+  void processRamp(float* samples, size_t numSamples, float cutoffHz, float resonance) override;
+
+private:
+  static float feedbackCoeff(float resonance);
+  // G = g / (1 + g), the one-pole gain; ramping it instead of g saves a
+  // division per sample.
+  float stageGain(float cutoffHz) const;
+  float tick(float input, float G, float k);
+
+  float _s[4]; // one-pole integrator states
 };
 
 // Legacy alias for backward compatibility
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+
+// Fixed-point build profile for targets where integer maths beats the FPU
+// or memory is tight. Building with MINIACID_FIXED_POINT=1 switches the
+// delay lines to 16-bit storage and runs the tube distortion and the
+// saw/square oscillators on integer kernels. The float build is the
+// default and the reference the fixed one is null-tested against.
+#ifndef MINIACID_FIXED_POINT
+#define MINIACID_FIXED_POINT 0
+#endif
+
+// Qn helpers: a value v is stored as v * 2^FracBits in an integer.
+template <int FracBits>
+inline int32_t floatToFixed(float x) {
+  float scaled = x * static_cast<float>(1 << FracBits);
+  return static_cast<int32_t>(scaled >= 0.0f ? scaled + 0.5f : scaled - 0.5f);
+}
+
+template <int FracBits>
+inline float fixedToFloat(int32_t x) {
+  return static_cast<float>(x) * (1.0f / static_cast<float>(1 << FracBits));
+}
+
+inline int16_t saturateToInt16(int32_t x) {
+  if (x > 32767) return 32767;
+  if (x < -32768) return -32768;
+  return static_cast<int16_t>(x);
+}
+
+// Q15 is [-1, 1) in an int16_t.
+inline int16_t floatToQ15(float x) {
+  return saturateToInt16(floatToFixed<15>(x));
+}
+
+inline float q15ToFloat(int32_t x) {
+  return fixedToFloat<15>(x);
+}
+
+// a * b for a Q15 b. Rounds toward zero, so a decaying feedback loop
+// really reaches 0 instead of getting stuck on +-1 LSB.
+inline int32_t mulQ15(int32_t a, int32_t b) {
+  return (a * b) / 32768;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+
+// Tables generated at compile time, so they live in flash (rodata) and the
+// voices need no transcendental maths to tune notes or set envelope speeds.
+//
+// Envelopes are described by their time constant: the time to fall to 1/e.
+// The per-sample multiplier for that time is tabulated for every rate in
+// kTableSampleRates, so an envelope lasts as long at 48 kHz as at 22.05 kHz.
+// Other rates fall back to expf when the voice's sample rate is set.
+
+constexpr int kTableSampleRates[] = {22050, 32000, 44100, 48000};
+constexpr int kTableSampleRateCount = sizeof(kTableSampleRates) / sizeof(kTableSampleRates[0]);
+
+namespace lookup_tables_detail {
+
+// exp(x) as exp(x / 2^k)^(2^k) with the reduced argument under 1/16,
+// where a short Taylor series is exact to double precision; only ever
+// evaluated at compile time.
+constexpr double constexprExp(double x) {
+  int halvings = 0;
+  while (x > 0.0625 || x < -0.0625) {
+    x *= 0.5;
+    ++halvings;
+  }
+  double term = 1.0;
+  double sum = 1.0;
+  for (int n = 1; n < 12; ++n) {
+    term *= x / n;
+    sum += term;
+  }
+  for (int i = 0; i < halvings; ++i)
+    sum *= sum;
+  return sum;
+}
+
+constexpr double kLn2 = 0.693147180559945309;
+
+} // namespace lookup_tables_detail
+
+// Per-sample multiplier that makes an envelope fall to 1/e in timeSeconds.
+constexpr float decayCoefficient(double timeSeconds, double sampleRate) {
+  return static_cast<float>(lookup_tables_detail::constexprExp(-1.0 / (timeSeconds * sampleRate)));
+}
+
+// Index of sampleRate in kTableSampleRates, or -1 if it has no tables.
+inline int tableSampleRateIndex(float sampleRate) {
+  for (int i = 0; i < kTableSampleRateCount; ++i) {
+    if (sampleRate == static_cast<float>(kTableSampleRates[i]))
+      return i;
+  }
+  return -1;
+}
+
+// The decay multipliers of one voice's N envelopes at every tabulated rate.
+template <size_t N>
+struct DecayTable {
+  double timesSeconds[N];
+  float values[kTableSampleRateCount][N];
+};
+
+template <size_t N>
+constexpr DecayTable<N> makeDecayTable(const double (&timesSeconds)[N]) {
+  DecayTable<N> table{};
+  for (size_t i = 0; i < N; ++i) {
+    table.timesSeconds[i] = timesSeconds[i];
+    for (int r = 0; r < kTableSampleRateCount; ++r)
+      table.values[r][i] = decayCoefficient(timesSeconds[i], kTableSampleRates[r]);
+  }
+  return table;
+}
+
+// Copies the multipliers for sampleRate into out. Not for the audio thread
+// when the rate is not tabulated, since that computes them with expf.
+template <size_t N>
+void loadDecays(const DecayTable<N>& table, float sampleRate, float (&out)[N]) {
+  int rate = tableSampleRateIndex(sampleRate);
+  for (size_t i = 0; i < N; ++i) {
+    out[i] = rate >= 0 ? table.values[rate][i]
+                       : expf(-1.0f / (static_cast<float>(table.timesSeconds[i]) * sampleRate));
+  }
+}
+
+constexpr int kNoteCount = 128;
+
+struct NoteTable {
+  float values[kNoteCount];
+};
+
+// Equal-tempered MIDI notes, A4 (69) = 440 Hz.
+constexpr NoteTable makeNoteTable() {
+  NoteTable table{};
+  for (int n = 0; n < kNoteCount; ++n) {
+    table.values[n] = static_cast<float>(
+      440.0 * lookup_tables_detail::constexprExp(lookup_tables_detail::kLn2 * (n - 69) / 12.0));
+  }
+  return table;
+}
+
+constexpr NoteTable kNoteFrequencies = makeNoteTable();
+
+// Frequency of MIDI note, clamped to 0..127.
+inline float noteFrequency(int note) {
+  if (note < 0) note = 0;
+  if (note >= kNoteCount) note = kNoteCount - 1;
+  return kNoteFrequencies.values[note];
+}
@@ -1,7 +1,99 @@
 #include "mini_drumvoices.h"
 
 #include <math.h>
-#include <stdlib.h>
+
+#include "fast_math.h"
+#include "lookup_tables.h"
+
+namespace {
+constexpr double ms(double milliseconds) { return milliseconds * 1e-3; }
+
+// Time constants in the order of each kit's Decay enum. The 808 and 909
+// were voiced at 22.05 kHz; these are the times their original per-sample
+// multipliers gave at that rate.
+constexpr double kTr808DecayTimes[] = {
+  ms(90.68),  // KickAmp
+  ms(129.6),  // KickAmpAccent
+  ms(15.09),  // KickPitch
+  ms(30.21),  // SnareAmp
+  ms(4529),   // SnareTone
+  ms(22.65),  // HatAmp
+  ms(0.5439), // HatTone
+  ms(64.77),  // OpenHatAmp
+  ms(0.7329), // OpenHatTone
+  ms(60.45),  // MidTom
+  ms(53.33),  // HighTom
+  ms(30.21),  // Rim
+  ms(56.67),  // Clap
+  ms(30.21),  // ClapTrans
+  ms(82.44),  // Cymbal
+  ms(1.791),  // CymbalTone
+  ms(0.5439), // HatHp
+  ms(0.6249), // OpenHatHp
+  ms(0.7329), // CymbalHp
+};
+
+constexpr double kTr909DecayTimes[] = {
+  ms(60.45),  // KickAmp
+  ms(69.75),  // KickAmpAccent
+  ms(11.32),  // KickPitch
+  ms(0.7329), // KickClick
+  ms(18.87),  // SnareAmp
+  ms(129.6),  // SnareTone
+  ms(11.32),  // HatAmp
+  ms(0.4304), // HatTone
+  ms(100.8),  // OpenHatAmp
+  ms(0.6249), // OpenHatTone
+  ms(41.21),  // MidTom
+  ms(37.77),  // HighTom
+  ms(18.12),  // Rim
+  ms(37.77),  // Clap
+  ms(69.75),  // Cymbal
+  ms(1.489),  // CymbalTone
+  ms(0.5439), // SnareColor
+  ms(0.8842), // HatHp
+  ms(0.985),  // OpenHatHp
+  ms(0.985),  // CymbalHp
+};
+
+constexpr double kTr606DecayTimes[] = {
+  ms(180),    // KickAmp
+  ms(12),     // KickFm
+  ms(75),     // SnareTone
+  ms(115),    // SnareNoise
+  ms(120),    // MidTomAmp
+  ms(10),     // MidTomFm
+  ms(95),     // HighTomAmp
+  ms(9),      // HighTomFm
+  ms(40),     // Hat
+  ms(280),    // OpenHat
+  ms(705),    // Cymbal, stretched by the resting accent level
+  ms(900),    // CymbalAccent
+  ms(110),    // Accent
+};
+
+// Centres of the snare noise band-pass.
+constexpr float kTr808SnareBpHz = 986.0f;
+constexpr float kTr909SnareBpHz = 1128.0f;
+
+constexpr auto kTr808Decays = makeDecayTable(kTr808DecayTimes);
+constexpr auto kTr909Decays = makeDecayTable(kTr909DecayTimes);
+constexpr auto kTr606Decays = makeDecayTable(kTr606DecayTimes);
+} // namespace
+
+void DrumSynthVoice::trigger(DrumVoiceId id, bool accent) {
+  switch (id) {
+    case DrumVoiceId::Kick: triggerKick(accent); break;
+    case DrumVoiceId::Snare: triggerSnare(accent); break;
+    case DrumVoiceId::Hat: triggerHat(accent); break;
+    case DrumVoiceId::OpenHat: triggerOpenHat(accent); break;
+    case DrumVoiceId::MidTom: triggerMidTom(accent); break;
+    case DrumVoiceId::HighTom: triggerHighTom(accent); break;
+    case DrumVoiceId::Rim: triggerRim(accent); break;
+    case DrumVoiceId::Clap: triggerClap(accent); break;
+    default: break;
+  }
+}
 
 TR808DrumSynthVoice::TR808DrumSynthVoice(float sampleRate)
   : sampleRate(sampleRate),
@@ -18,7 +110,8 @@ void TR808DrumSynthVoice::reset() {
   kickActive = false;
   kickAccentGain = 1.0f;
   kickAccentDistortion = false;
-  kickAmpDecay = 0.9995f;
+  kickAccentInput = 0.0f;
+  kickAmpDecay = decay(Decay::KickAmp);
   kickBaseFreq = 42.0f;
 
   snareEnvAmp = 0.0f;
@@ -31,6 +124,7 @@ void TR808DrumSynthVoice::reset() {
   snareAccentGain = 1.0f;
   snareToneGain = 1.0f;
   snareAccentDistortion = false;
+  snareAccentInput = 0.0f;
 
   hatEnvAmp = 0.0f;
   hatToneEnv = 0.0f;
@@ -42,6 +136,7 @@ void TR808DrumSynthVoice::reset() {
   hatAccentGain = 1.0f;
   hatBrightness = 1.0f;
   hatAccentDistortion = false;
+  hatAccentInput = 0.0f;
 
   openHatEnvAmp = 0.0f;
   openHatToneEnv = 0.0f;
@@ -53,24 +148,28 @@ void TR808DrumSynthVoice::reset() {
   openHatAccentGain = 1.0f;
   openHatBrightness = 1.0f;
   openHatAccentDistortion = false;
+  openHatAccentInput = 0.0f;
 
   midTomPhase = 0.0f;
   midTomEnv = 0.0f;
   midTomActive = false;
   midTomAccentGain = 1.0f;
   midTomAccentDistortion = false;
+  midTomAccentInput = 0.0f;
 
   highTomPhase = 0.0f;
   highTomEnv = 0.0f;
   highTomActive = false;
   highTomAccentGain = 1.0f;
   highTomAccentDistortion = false;
+  highTomAccentInput = 0.0f;
 
   rimPhase = 0.0f;
   rimEnv = 0.0f;
   rimActive = false;
   rimAccentGain = 1.0f;
   rimAccentDistortion = false;
+  rimAccentInput = 0.0f;
 
   clapEnv = 0.0f;
   clapTrans = 0.0f;
@@ -81,6 +180,7 @@ void TR808DrumSynthVoice::reset() {
   clapAccentAmount = 0.0f;
   clapAccentGain = 1.0f;
   clapAccentDistortion = false;
+  clapAccentInput = 0.0f;
   clapBandpass.reset();
 
   cymbalEnv = 0.0f;
@@ -93,6 +193,7 @@ void TR808DrumSynthVoice::reset() {
   cymbalAccentGain = 1.0f;
   cymbalBrightness = 1.0f;
   cymbalAccentDistortion = false;
+  cymbalAccentInput = 0.0f;
   clapLowpass.reset();
 
   cymbalEnv = 0.0f;
@@ -105,6 +206,7 @@ void TR808DrumSynthVoice::reset() {
   cymbalAccentGain = 1.0f;
   cymbalBrightness = 1.0f;
   cymbalAccentDistortion = false;
+  cymbalAccentInput = 0.0f;
 
   accentDistortion.setEnabled(true);
   accentDistortion.setDrive(3.0f);
@@ -118,6 +220,10 @@ void TR808DrumSynthVoice::setSampleRate(float sampleRateHz) {
   if (sampleRateHz <= 0.0f) sampleRateHz = 44100.0f;
   sampleRate = sampleRateHz;
   invSampleRate = 1.0f / sampleRate;
+  static_assert(sizeof(kTr808DecayTimes) / sizeof(double) == static_cast<size_t>(Decay::Count),
+                "one time per 808 time constant");
+  loadDecays(kTr808Decays, sampleRate, decays);
+  snareBpCoeff = 2.0f * sinf(3.14159265f * kTr808SnareBpHz * invSampleRate);
   updateClapFilters(clapAccentAmount);
 }
 
@@ -129,7 +235,7 @@ void TR808DrumSynthVoice::triggerKick(bool accent) {
   kickFreq = 55.0f;
   kickAccentGain = accent ? 1.15f : 1.0f;
   kickAccentDistortion = accent;
-  kickAmpDecay = accent ? 0.99965f : 0.9995f;
+  kickAmpDecay = decay(accent ? Decay::KickAmpAccent : Decay::KickAmp);
   kickBaseFreq = accent ? 36.0f : 42.0f;
 }
 
@@ -219,14 +325,15 @@ void TR808DrumSynthVoice::triggerCymbal(bool accent) {
 }
 
 float TR808DrumSynthVoice::frand() {
-  return (float)rand() / (float)RAND_MAX * 2.0f - 1.0f;
+  return noise.bipolar();
 }
 
-float TR808DrumSynthVoice::applyAccentDistortion(float input, bool accent) {
+float TR808DrumSynthVoice::applyAccentDistortion(float input, bool accent, float& lastInput) {
   if (!accent) {
+    lastInput = input;
     return input;
   }
-  return accentDistortion.process(input);
+  return accentDistortion.process(input, lastInput);
 }
 
 void TR808DrumSynthVoice::updateClapFilters(float accentAmount) {
@@ -275,7 +382,7 @@ float TR808DrumSynthVoice::processKick() {
 
   // Longer amp tail with faster pitch drop for a punchy thump
   kickEnvAmp *= kickAmpDecay;
-  kickEnvPitch *= 0.997f;
+  kickEnvPitch *= decay(Decay::KickPitch);
   if (kickEnvAmp < 0.0008f) {
     kickActive = false;
     return 0.0f;
@@ -288,12 +395,12 @@ float TR808DrumSynthVoice::processKick() {
   if (kickPhase >= 1.0f)
     kickPhase -= 1.0f;
 
-  float body = sinf(2.0f * 3.14159265f * kickPhase);
-  float transient = sinf(2.0f * 3.14159265f * kickPhase * 3.0f) * pitchFactor * 0.25f;
-  float driven = tanhf(body * (2.8f + 0.6f * kickEnvAmp));
+  float body = dspSin2Pi(kickPhase);
+  float transient = dspSin2Pi(kickPhase * 3.0f) * pitchFactor * 0.25f;
+  float driven = dspTanh(body * (2.8f + 0.6f * kickEnvAmp));
 
   float out = (driven * 0.85f + transient) * kickEnvAmp * kickAccentGain;
-  return applyAccentDistortion(out, kickAccentDistortion);
+  return applyAccentDistortion(out, kickAccentDistortion, kickAccentInput);
 }
 
 
@@ -303,8 +410,8 @@ float TR808DrumSynthVoice::processSnare() {
 
   // --- ENVELOPES ---
   // 808: Long noise decay, short tone decay
-  snareEnvAmp *= 0.9985f;   // slow decay, long tail
-  snareToneEnv *= 0.99999f;    // short tone "tick"
+  snareEnvAmp *= decay(Decay::SnareAmp);   // slow decay, long tail
+  snareToneEnv *= decay(Decay::SnareTone);    // short tone "tick"
 
   if (snareEnvAmp < 0.0002f) {
     snareActive = false;
@@ -316,7 +423,7 @@ float TR808DrumSynthVoice::processSnare() {
 
   // 808: Noise is brighter with a bit of highpass emphasis
   // simple bandpass around ~1–2 kHz
-  float f = 0.28f;
+  float f = snareBpCoeff;
   snareBp += f * (n - snareLp - 0.20f * snareBp);
   snareLp += f * snareBp;
 
@@ -331,15 +438,15 @@ float TR808DrumSynthVoice::processSnare() {
   snareTonePhase2 += 180.0f * invSampleRate;
   if (snareTonePhase2 >= 1.0f) snareTonePhase2 -= 1.0f;
 
-  float toneA = sinf(2.0f * 3.14159265f * snareTonePhase);
-  float toneB = sinf(2.0f * 3.14159265f * snareTonePhase2);
+  float toneA = dspSin2Pi(snareTonePhase);
+  float toneB = dspSin2Pi(snareTonePhase2);
   float tone = (toneA * 0.55f + toneB * 0.45f) * snareToneEnv * snareToneGain;
 
   // --- MIX ---
   // 808: tone only supports transient, noise dominates sustain
   float out = noiseOut * 0.75f + tone * 0.65f;
   out *= snareEnvAmp * snareAccentGain;
-  return applyAccentDistortion(out, snareAccentDistortion);
+  return applyAccentDistortion(out, snareAccentDistortion, snareAccentInput);
 }
 
 float TR808DrumSynthVoice::processHat() {
@@ -347,8 +454,8 @@ float TR808DrumSynthVoice::processHat() {
     return 0.0f;
 
   // hatEnvAmp *= 0.994f;   // slower decay for a longer hat tail
-  hatEnvAmp *= 0.998f;   // slower decay for a longer hat tail
-  hatToneEnv *= 0.92f;
+  hatEnvAmp *= decay(Decay::HatAmp);   // slower decay for a longer hat tail
+  hatToneEnv *= decay(Decay::HatTone);
   if (hatEnvAmp < 0.0005f) {
     hatActive = false;
     return 0.0f;
@@ -356,7 +463,7 @@ float TR808DrumSynthVoice::processHat() {
 
   float n = frand();
   // crude highpass
-  float alpha = 0.92f;
+  float alpha = decay(Decay::HatHp);
   hatHp = alpha * (hatHp + n - hatPrev);
   hatPrev = n;
 
@@ -367,27 +474,27 @@ float TR808DrumSynthVoice::processHat() {
   hatPhaseB += 7400.0f * invSampleRate;
   if (hatPhaseB >= 1.0f)
     hatPhaseB -= 1.0f;
-  float tone = (sinf(2.0f * 3.14159265f * hatPhaseA) + sinf(2.0f * 3.14159265f * hatPhaseB)) *
+  float tone = (dspSin2Pi(hatPhaseA) + dspSin2Pi(hatPhaseB)) *
                0.5f * hatToneEnv * hatBrightness;
 
   float out = hatHp * 0.65f + tone * 0.7f;
   out *= hatEnvAmp * 0.6f * hatAccentGain;
-  return applyAccentDistortion(out, hatAccentDistortion);
+  return applyAccentDistortion(out, hatAccentDistortion, hatAccentInput);
 }
 
 float TR808DrumSynthVoice::processOpenHat() {
   if (!openHatActive)
     return 0.0f;
 
-  openHatEnvAmp *= 0.9993f;
-  openHatToneEnv *= 0.94f;
+  openHatEnvAmp *= decay(Decay::OpenHatAmp);
+  openHatToneEnv *= decay(Decay::OpenHatTone);
   if (openHatEnvAmp < 0.0004f) {
     openHatActive = false;
     return 0.0f;
   }
 
   float n = frand();
-  float alpha = 0.93f;
+  float alpha = decay(Decay::OpenHatHp);
   openHatHp = alpha * (openHatHp + n - openHatPrev);
   openHatPrev = n;
 
@@ -398,19 +505,19 @@ float TR808DrumSynthVoice::processOpenHat() {
   if (openHatPhaseB >= 1.0f)
     openHatPhaseB -= 1.0f;
   float tone =
-    (sinf(2.0f * 3.14159265f * openHatPhaseA) + sinf(2.0f * 3.14159265f * openHatPhaseB)) *
+    (dspSin2Pi(openHatPhaseA) + dspSin2Pi(openHatPhaseB)) *
     0.5f * openHatToneEnv * openHatBrightness;
 
   float out = openHatHp * 0.55f + tone * 0.95f;
   out *= openHatEnvAmp * 0.7f * openHatAccentGain;
-  return applyAccentDistortion(out, openHatAccentDistortion);
+  return applyAccentDistortion(out, openHatAccentDistortion, openHatAccentInput);
 }
 
 float TR808DrumSynthVoice::processMidTom() {
   if (!midTomActive)
     return 0.0f;
 
-  midTomEnv *= 0.99925f;
+  midTomEnv *= decay(Decay::MidTom);
   if (midTomEnv < 0.0003f) {
     midTomActive = false;
     return 0.0f;
@@ -421,17 +528,17 @@ float TR808DrumSynthVoice::processMidTom() {
   if (midTomPhase >= 1.0f)
     midTomPhase -= 1.0f;
 
-  float tone = sinf(2.0f * 3.14159265f * midTomPhase);
+  float tone = dspSin2Pi(midTomPhase);
   float slightNoise = frand() * 0.05f;
   float out = (tone * 0.9f + slightNoise) * midTomEnv * 0.8f * midTomAccentGain;
-  return applyAccentDistortion(out, midTomAccentDistortion);
+  return applyAccentDistortion(out, midTomAccentDistortion, midTomAccentInput);
 }
 
 float TR808DrumSynthVoice::processHighTom() {
   if (!highTomActive)
     return 0.0f;
 
-  highTomEnv *= 0.99915f;
+  highTomEnv *= decay(Decay::HighTom);
   if (highTomEnv < 0.0003f) {
     highTomActive = false;
     return 0.0f;
@@ -443,17 +550,17 @@ float TR808DrumSynthVoice::processHighTom() {
   if (highTomPhase >= 1.0f)
     highTomPhase -= 1.0f;
 
-  float tone = sinf(2.0f * 3.14159265f * highTomPhase);
+  float tone = dspSin2Pi(highTomPhase);
   float slightNoise = frand() * 0.04f;
   float out = (tone * 0.88f + slightNoise) * highTomEnv * 0.75f * highTomAccentGain;
-  return applyAccentDistortion(out, highTomAccentDistortion);
+  return applyAccentDistortion(out, highTomAccentDistortion, highTomAccentInput);
 }
 
 float TR808DrumSynthVoice::processRim() {
   if (!rimActive)
     return 0.0f;
 
-  rimEnv *= 0.9985f;
+  rimEnv *= decay(Decay::Rim);
   if (rimEnv < 0.0004f) {
     rimActive = false;
     return 0.0f;
@@ -462,18 +569,18 @@ float TR808DrumSynthVoice::processRim() {
   rimPhase += 900.0f * invSampleRate;
   if (rimPhase >= 1.0f)
     rimPhase -= 1.0f;
-  float tone = sinf(2.0f * 3.14159265f * rimPhase);
+  float tone = dspSin2Pi(rimPhase);
   float click = (frand() * 0.6f + 0.4f) * rimEnv;
   float out = (tone * 0.5f + click) * rimEnv * 0.8f * rimAccentGain;
-  return applyAccentDistortion(out, rimAccentDistortion);
+  return applyAccentDistortion(out, rimAccentDistortion, rimAccentInput);
 }
 
 float TR808DrumSynthVoice::processClap() {
   if (!clapActive)
     return 0.0f;
 
-  clapEnv *= 0.9992f;
-  clapTrans *= 0.9985f;
+  clapEnv *= decay(Decay::Clap);
+  clapTrans *= decay(Decay::ClapTrans);
   clapDelay += invSampleRate;
   clapTime += invSampleRate;
   if (clapEnv < 0.0002f) {
@@ -484,36 +591,36 @@ float TR808DrumSynthVoice::processClap() {
   float decayScale = 1.0f + 0.5f * clapAccentAmount;
   float accentGain = 1.0f + 0.6f * clapAccentAmount;
 
-  float env1 = clapTime < 0.0f ? 0.0f : expf(-(clapTime - 0.0f) / (0.007f * decayScale));
-  float env2 = clapTime < 0.008f ? 0.0f : expf(-(clapTime - 0.008f) / (0.011f * decayScale));
-  float env3 = clapTime < 0.015f ? 0.0f : expf(-(clapTime - 0.015f) / (0.015f * decayScale));
+  float env1 = clapTime < 0.0f ? 0.0f : dspExp(-(clapTime - 0.0f) / (0.007f * decayScale));
+  float env2 = clapTime < 0.008f ? 0.0f : dspExp(-(clapTime - 0.008f) / (0.011f * decayScale));
+  float env3 = clapTime < 0.015f ? 0.0f : dspExp(-(clapTime - 0.015f) / (0.015f * decayScale));
   float body = frand() * (env1 + env2 + env3);
 
   float tail = 0.0f;
   if (clapTime >= 0.02f) {
-    tail = frand() * expf(-(clapTime - 0.02f) / (0.120f * decayScale));
+    tail = frand() * dspExp(-(clapTime - 0.02f) / (0.120f * decayScale));
   }
 
   float out = (body + tail) * accentGain;
   out = clapBandpass.process(out);
   out = clapLowpass.process(out);
   out *= (clapEnv * clapAccentGain) * 0.8f;
-  return applyAccentDistortion(out, clapAccentDistortion);
+  return applyAccentDistortion(out, clapAccentDistortion, clapAccentInput);
 }
 
 float TR808DrumSynthVoice::processCymbal() {
   if (!cymbalActive)
     return 0.0f;
 
-  cymbalEnv *= 0.99945f;
-  cymbalToneEnv *= 0.975f;
+  cymbalEnv *= decay(Decay::Cymbal);
+  cymbalToneEnv *= decay(Decay::CymbalTone);
   if (cymbalEnv < 0.0003f) {
     cymbalActive = false;
     return 0.0f;
   }
 
   float n = frand();
-  float alpha = 0.94f;
+  float alpha = decay(Decay::CymbalHp);
   cymbalHp = alpha * (cymbalHp + n - cymbalPrev);
   cymbalPrev = n;
 
@@ -524,12 +631,65 @@ float TR808DrumSynthVoice::processCymbal() {
   if (cymbalPhaseB >= 1.0f)
     cymbalPhaseB -= 1.0f;
   float tone =
-    (sinf(2.0f * 3.14159265f * cymbalPhaseA) + sinf(2.0f * 3.14159265f * cymbalPhaseB)) *
+    (dspSin2Pi(cymbalPhaseA) + dspSin2Pi(cymbalPhaseB)) *
     0.5f * cymbalToneEnv * cymbalBrightness;
 
   float out = cymbalHp * 0.6f + tone * 0.9f;
   out *= cymbalEnv * cymbalAccentGain;
-  return applyAccentDistortion(out, cymbalAccentDistortion);
+  return applyAccentDistortion(out, cymbalAccentDistortion, cymbalAccentInput);
+}
+
+void TR808DrumSynthVoice::process(float* out, size_t numSamples, uint16_t voiceMask) {
+  for (size_t i = 0; i < numSamples; ++i)
+    out[i] = 0.0f;
+
+  // The voices share no per-sample state, so each one renders the whole block
+  // on its own and idle voices are skipped outright.
+  if ((voiceMask & drumVoiceBit(DrumVoiceId::Kick)) && kickActive) {
+    for (size_t i = 0; i < numSamples; ++i)
+      out[i] += processKick();
+  }
+  if ((voiceMask & drumVoiceBit(DrumVoiceId::Snare)) && snareActive) {
+    for (size_t i = 0; i < numSamples; ++i)
+      out[i] += processSnare();
+  }
+  if ((voiceMask & drumVoiceBit(DrumVoiceId::Hat)) && hatActive) {
+    for (size_t i = 0; i < numSamples; ++i)
+      out[i] += processHat();
+  }
+  if ((voiceMask & drumVoiceBit(DrumVoiceId::OpenHat)) && openHatActive) {
+    for (size_t i = 0; i < numSamples; ++i)
+      out[i] += processOpenHat();
+  }
+  if ((voiceMask & drumVoiceBit(DrumVoiceId::MidTom)) && midTomActive) {
+    for (size_t i = 0; i < numSamples; ++i)
+      out[i] += processMidTom();
+  }
+  if ((voiceMask & drumVoiceBit(DrumVoiceId::HighTom)) && highTomActive) {
+    for (size_t i = 0; i < numSamples; ++i)
+      out[i] += processHighTom();
+  }
+  if ((voiceMask & drumVoiceBit(DrumVoiceId::Rim)) && rimActive) {
+    for (size_t i = 0; i < numSamples; ++i)
+      out[i] += processRim();
+  }
+  if ((voiceMask & drumVoiceBit(DrumVoiceId::Clap)) && clapActive) {
+    for (size_t i = 0; i < numSamples; ++i)
+      out[i] += processClap();
+  }
+}
+
+uint16_t TR808DrumSynthVoice::activeVoiceMask() const {
+  uint16_t mask = 0;
+  if (kickActive) mask |= drumVoiceBit(DrumVoiceId::Kick);
+  if (snareActive) mask |= drumVoiceBit(DrumVoiceId::Snare);
+  if (hatActive) mask |= drumVoiceBit(DrumVoiceId::Hat);
+  if (openHatActive) mask |= drumVoiceBit(DrumVoiceId::OpenHat);
+  if (midTomActive) mask |= drumVoiceBit(DrumVoiceId::MidTom);
+  if (highTomActive) mask |= drumVoiceBit(DrumVoiceId::HighTom);
+  if (rimActive) mask |= drumVoiceBit(DrumVoiceId::Rim);
+  if (clapActive) mask |= drumVoiceBit(DrumVoiceId::Clap);
+  return mask;
 }
 
 const Parameter& TR808DrumSynthVoice::parameter(DrumParamId id) const {
@@ -538,6 +698,7 @@ const Parameter& TR808DrumSynthVoice::parameter(DrumParamId id) const {
 
 void TR808DrumSynthVoice::setParameter(DrumParamId id, float value) {
   params[static_cast<int>(id)].setValue(value);
+  ++parameterVersion_;
 }
 
 TR909DrumSynthVoice::TR909DrumSynthVoice(float sampleRate)
@@ -555,7 +716,8 @@ void TR909DrumSynthVoice::reset() {
   kickActive = false;
   kickAccentGain = 1.0f;
   kickAccentDistortion = false;
-  kickAmpDecay = 0.99925f;
+  kickAccentInput = 0.0f;
+  kickAmpDecay = decay(Decay::KickAmp);
   kickBaseFreq = 48.0f;
   kickClickEnv = 0.0f;
 
@@ -569,6 +731,7 @@ void TR909DrumSynthVoice::reset() {
   snareAccentGain = 1.0f;
   snareToneGain = 1.0f;
   snareAccentDistortion = false;
+  snareAccentInput = 0.0f;
   snareNoiseColor = 0.0f;
 
   hatEnvAmp = 0.0f;
@@ -581,6 +744,7 @@ void TR909DrumSynthVoice::reset() {
   hatAccentGain = 1.0f;
   hatBrightness = 1.0f;
   hatAccentDistortion = false;
+  hatAccentInput = 0.0f;
 
   openHatEnvAmp = 0.0f;
   openHatToneEnv = 0.0f;
@@ -592,24 +756,28 @@ void TR909DrumSynthVoice::reset() {
   openHatAccentGain = 1.0f;
   openHatBrightness = 1.0f;
   openHatAccentDistortion = false;
+  openHatAccentInput = 0.0f;
 
   midTomPhase = 0.0f;
   midTomEnv = 0.0f;
   midTomActive = false;
   midTomAccentGain = 1.0f;
   midTomAccentDistortion = false;
+  midTomAccentInput = 0.0f;
 
   highTomPhase = 0.0f;
   highTomEnv = 0.0f;
   highTomActive = false;
   highTomAccentGain = 1.0f;
   highTomAccentDistortion = false;
+  highTomAccentInput = 0.0f;
 
   rimPhase = 0.0f;
   rimEnv = 0.0f;
   rimActive = false;
   rimAccentGain = 1.0f;
   rimAccentDistortion = false;
+  rimAccentInput = 0.0f;
 
   clapEnv = 0.0f;
   clapTrans = 0.0f;
@@ -619,6 +787,7 @@ void TR909DrumSynthVoice::reset() {
   clapTime = 0.0f;
   clapAccentGain = 1.0f;
   clapAccentDistortion = false;
+  clapAccentInput = 0.0f;
   clapBandpass.reset();
 
   accentDistortion.setEnabled(true);
@@ -634,6 +803,10 @@ void TR909DrumSynthVoice::setSampleRate(float sampleRateHz) {
   if (sampleRateHz <= 0.0f) sampleRateHz = 44100.0f;
   sampleRate = sampleRateHz;
   invSampleRate = 1.0f / sampleRate;
+  static_assert(sizeof(kTr909DecayTimes) / sizeof(double) == static_cast<size_t>(Decay::Count),
+                "one time per 909 time constant");
+  loadDecays(kTr909Decays, sampleRate, decays);
+  snareBpCoeff = 2.0f * sinf(3.14159265f * kTr909SnareBpHz * invSampleRate);
   updateClapFilter();
 }
 
@@ -645,7 +818,7 @@ void TR909DrumSynthVoice::triggerKick(bool accent) {
   kickFreq = 58.0f;
   kickAccentGain = accent ? 1.2f : 1.0f;
   kickAccentDistortion = accent;
-  kickAmpDecay = accent ? 0.99935f : 0.99925f;
+  kickAmpDecay = decay(accent ? Decay::KickAmpAccent : Decay::KickAmp);
   kickBaseFreq = accent ? 46.0f : 48.0f;
   kickClickEnv = accent ? 1.0f : 0.85f;
 }
@@ -733,14 +906,15 @@ void TR909DrumSynthVoice::triggerCymbal(bool accent) {
 }
 
 float TR909DrumSynthVoice::frand() {
-  return (float)rand() / (float)RAND_MAX * 2.0f - 1.0f;
+  return noise.bipolar();
 }
 
-float TR909DrumSynthVoice::applyAccentDistortion(float input, bool accent) {
+float TR909DrumSynthVoice::applyAccentDistortion(float input, bool accent, float& lastInput) {
   if (!accent) {
+    lastInput = input;
     return input;
   }
-  return accentDistortion.process(input);
+  return accentDistortion.process(input, lastInput);
 }
 
 void TR909DrumSynthVoice::updateClapFilter() {
@@ -769,8 +943,8 @@ float TR909DrumSynthVoice::processKick() {
     return 0.0f;
 
   kickEnvAmp *= kickAmpDecay;
-  kickEnvPitch *= 0.996f;
-  kickClickEnv *= 0.94f;
+  kickEnvPitch *= decay(Decay::KickPitch);
+  kickClickEnv *= decay(Decay::KickClick);
   if (kickEnvAmp < 0.0008f) {
     kickActive = false;
     return 0.0f;
@@ -782,21 +956,21 @@ float TR909DrumSynthVoice::processKick() {
   if (kickPhase >= 1.0f)
     kickPhase -= 1.0f;
 
-  float body = sinf(2.0f * 3.14159265f * kickPhase);
-  float transient = sinf(2.0f * 3.14159265f * kickPhase * 4.0f) * pitchFactor * 0.2f;
+  float body = dspSin2Pi(kickPhase);
+  float transient = dspSin2Pi(kickPhase * 4.0f) * pitchFactor * 0.2f;
   float click = (frand() * 0.4f + 0.6f) * kickClickEnv * 0.2f;
-  float driven = tanhf(body * (2.4f + 0.7f * kickEnvAmp));
+  float driven = dspTanh(body * (2.4f + 0.7f * kickEnvAmp));
 
   float out = (driven * 0.9f + transient + click) * kickEnvAmp * kickAccentGain;
-  return applyAccentDistortion(out, kickAccentDistortion);
+  return applyAccentDistortion(out, kickAccentDistortion, kickAccentInput);
 }
 
 float TR909DrumSynthVoice::processSnare() {
   if (!snareActive)
     return 0.0f;
 
-  snareEnvAmp *= 0.9976f;
-  snareToneEnv *= 0.99965f;
+  snareEnvAmp *= decay(Decay::SnareAmp);
+  snareToneEnv *= decay(Decay::SnareTone);
 
   if (snareEnvAmp < 0.00025f) {
     snareActive = false;
@@ -804,12 +978,13 @@ float TR909DrumSynthVoice::processSnare() {
   }
 
   float n = frand();
-  float f = 0.32f;
+  float f = snareBpCoeff;
   snareBp += f * (n - snareLp - 0.18f * snareBp);
   snareLp += f * snareBp;
 
   float noiseHP = n - snareLp;
-  snareNoiseColor = 0.92f * snareNoiseColor + 0.08f * noiseHP;
+  float color = decay(Decay::SnareColor);
+  snareNoiseColor = color * snareNoiseColor + (1.0f - color) * noiseHP;
   float noiseOut = snareBp * 0.25f + snareNoiseColor * 0.75f;
 
   snareTonePhase += 330.0f * invSampleRate;
@@ -817,28 +992,28 @@ float TR909DrumSynthVoice::processSnare() {
   snareTonePhase2 += 200.0f * invSampleRate;
   if (snareTonePhase2 >= 1.0f) snareTonePhase2 -= 1.0f;
 
-  float toneA = sinf(2.0f * 3.14159265f * snareTonePhase);
-  float toneB = sinf(2.0f * 3.14159265f * snareTonePhase2);
+  float toneA = dspSin2Pi(snareTonePhase);
+  float toneB = dspSin2Pi(snareTonePhase2);
   float tone = (toneA * 0.6f + toneB * 0.4f) * snareToneEnv * snareToneGain;
 
   float out = (noiseOut * 0.6f + tone * 0.85f) * 1.25f;
   out *= snareEnvAmp * snareAccentGain;
-  return applyAccentDistortion(out, snareAccentDistortion);
+  return applyAccentDistortion(out, snareAccentDistortion, snareAccentInput);
 }
 
 float TR909DrumSynthVoice::processHat() {
   if (!hatActive)
     return 0.0f;
 
-  hatEnvAmp *= 0.996f;
-  hatToneEnv *= 0.9f;
+  hatEnvAmp *= decay(Decay::HatAmp);
+  hatToneEnv *= decay(Decay::HatTone);
   if (hatEnvAmp < 0.00045f) {
     hatActive = false;
     return 0.0f;
   }
 
   float n = frand();
-  float alpha = 0.95f;
+  float alpha = decay(Decay::HatHp);
   hatHp = alpha * (hatHp + n - hatPrev);
   hatPrev = n;
 
@@ -849,27 +1024,27 @@ float TR909DrumSynthVoice::processHat() {
   if (hatPhaseB >= 1.0f)
     hatPhaseB -= 1.0f;
   float tone =
-    (sinf(2.0f * 3.14159265f * hatPhaseA) + sinf(2.0f * 3.14159265f * hatPhaseB)) *
+    (dspSin2Pi(hatPhaseA) + dspSin2Pi(hatPhaseB)) *
     0.5f * hatToneEnv * hatBrightness;
 
   float out = hatHp * 0.6f + tone * 0.85f;
   out *= hatEnvAmp * 0.55f * hatAccentGain;
-  return applyAccentDistortion(out, hatAccentDistortion);
+  return applyAccentDistortion(out, hatAccentDistortion, hatAccentInput);
 }
 
 float TR909DrumSynthVoice::processOpenHat() {
   if (!openHatActive)
     return 0.0f;
 
-  openHatEnvAmp *= 0.99955f;
-  openHatToneEnv *= 0.93f;
+  openHatEnvAmp *= decay(Decay::OpenHatAmp);
+  openHatToneEnv *= decay(Decay::OpenHatTone);
   if (openHatEnvAmp < 0.00035f) {
     openHatActive = false;
     return 0.0f;
   }
 
   float n = frand();
-  float alpha = 0.955f;
+  float alpha = decay(Decay::OpenHatHp);
   openHatHp = alpha * (openHatHp + n - openHatPrev);
   openHatPrev = n;
 
@@ -880,19 +1055,19 @@ float TR909DrumSynthVoice::processOpenHat() {
   if (openHatPhaseB >= 1.0f)
     openHatPhaseB -= 1.0f;
   float tone =
-    (sinf(2.0f * 3.14159265f * openHatPhaseA) + sinf(2.0f * 3.14159265f * openHatPhaseB)) *
+    (dspSin2Pi(openHatPhaseA) + dspSin2Pi(openHatPhaseB)) *
     0.5f * openHatToneEnv * openHatBrightness;
 
   float out = openHatHp * 0.5f + tone * 1.05f;
   out *= openHatEnvAmp * 0.65f * openHatAccentGain;
-  return applyAccentDistortion(out, openHatAccentDistortion);
+  return applyAccentDistortion(out, openHatAccentDistortion, openHatAccentInput);
 }
 
 float TR909DrumSynthVoice::processMidTom() {
   if (!midTomActive)
     return 0.0f;
 
-  midTomEnv *= 0.9989f;
+  midTomEnv *= decay(Decay::MidTom);
   if (midTomEnv < 0.0003f) {
     midTomActive = false;
     return 0.0f;
@@ -903,17 +1078,17 @@ float TR909DrumSynthVoice::processMidTom() {
   if (midTomPhase >= 1.0f)
     midTomPhase -= 1.0f;
 
-  float tone = sinf(2.0f * 3.14159265f * midTomPhase);
+  float tone = dspSin2Pi(midTomPhase);
   float slightNoise = frand() * 0.03f;
   float out = (tone * 0.92f + slightNoise) * midTomEnv * 0.8f * midTomAccentGain;
-  return applyAccentDistortion(out, midTomAccentDistortion);
+  return applyAccentDistortion(out, midTomAccentDistortion, midTomAccentInput);
 }
 
 float TR909DrumSynthVoice::processHighTom() {
   if (!highTomActive)
     return 0.0f;
 
-  highTomEnv *= 0.9988f;
+  highTomEnv *= decay(Decay::HighTom);
   if (highTomEnv < 0.0003f) {
     highTomActive = false;
     return 0.0f;
@@ -924,17 +1099,17 @@ float TR909DrumSynthVoice::processHighTom() {
   if (highTomPhase >= 1.0f)
     highTomPhase -= 1.0f;
 
-  float tone = sinf(2.0f * 3.14159265f * highTomPhase);
+  float tone = dspSin2Pi(highTomPhase);
   float slightNoise = frand() * 0.025f;
   float out = (tone * 0.9f + slightNoise) * highTomEnv * 0.78f * highTomAccentGain;
-  return applyAccentDistortion(out, highTomAccentDistortion);
+  return applyAccentDistortion(out, highTomAccentDistortion, highTomAccentInput);
 }
 
 float TR909DrumSynthVoice::processRim() {
   if (!rimActive)
     return 0.0f;
 
-  rimEnv *= 0.9975f;
+  rimEnv *= decay(Decay::Rim);
   if (rimEnv < 0.00035f) {
     rimActive = false;
     return 0.0f;
@@ -943,17 +1118,17 @@ float TR909DrumSynthVoice::processRim() {
   rimPhase += 1200.0f * invSampleRate;
   if (rimPhase >= 1.0f)
     rimPhase -= 1.0f;
-  float tone = sinf(2.0f * 3.14159265f * rimPhase);
+  float tone = dspSin2Pi(rimPhase);
   float click = (frand() * 0.5f + 0.5f) * rimEnv;
   float out = (tone * 0.6f + click) * rimEnv * 0.85f * rimAccentGain;
-  return applyAccentDistortion(out, rimAccentDistortion);
+  return applyAccentDistortion(out, rimAccentDistortion, rimAccentInput);
 }
 
 float TR909DrumSynthVoice::processClap() {
   if (!clapActive)
     return 0.0f;
 
-  clapEnv *= 0.9988f;
+  clapEnv *= decay(Decay::Clap);
   clapDelay += invSampleRate;
   clapTime += invSampleRate;
   if (clapEnv < 0.0002f) {
@@ -975,28 +1150,28 @@ float TR909DrumSynthVoice::processClap() {
   float tail = 0.0f;
   if (clapTime >= 0.02f) {
     float t = clapTime - 0.02f;
-    float env = expf(-t * 18.0f);
+    float env = dspExp(-t * 18.0f);
     tail = frand() * env;
   }
 
   float out = clapBandpass.process(bursts + tail);
   out *= clapEnv * clapAccentGain;
-  return applyAccentDistortion(out, clapAccentDistortion);
+  return applyAccentDistortion(out, clapAccentDistortion, clapAccentInput);
 }
 
 float TR909DrumSynthVoice::processCymbal() {
   if (!cymbalActive)
     return 0.0f;
 
-  cymbalEnv *= 0.99935f;
-  cymbalToneEnv *= 0.97f;
+  cymbalEnv *= decay(Decay::Cymbal);
+  cymbalToneEnv *= decay(Decay::CymbalTone);
   if (cymbalEnv < 0.00025f) {
     cymbalActive = false;
     return 0.0f;
   }
 
   float n = frand();
-  float alpha = 0.955f;
+  float alpha = decay(Decay::CymbalHp);
   cymbalHp = alpha * (cymbalHp + n - cymbalPrev);
   cymbalPrev = n;
 
@@ -1007,12 +1182,65 @@ float TR909DrumSynthVoice::processCymbal() {
   if (cymbalPhaseB >= 1.0f)
     cymbalPhaseB -= 1.0f;
   float tone =
-    (sinf(2.0f * 3.14159265f * cymbalPhaseA) + sinf(2.0f * 3.14159265f * cymbalPhaseB)) *
+    (dspSin2Pi(cymbalPhaseA) + dspSin2Pi(cymbalPhaseB)) *
     0.5f * cymbalToneEnv * cymbalBrightness;
 
   float out = cymbalHp * 0.55f + tone * 1.05f;
   out *= cymbalEnv * cymbalAccentGain;
-  return applyAccentDistortion(out, cymbalAccentDistortion);
+  return applyAccentDistortion(out, cymbalAccentDistortion, cymbalAccentInput);
+}
+
+void TR909DrumSynthVoice::process(float* out, size_t numSamples, uint16_t voiceMask) {
+  for (size_t i = 0; i < numSamples; ++i)
+    out[i] = 0.0f;
+
+  // The voices share no per-sample state, so each one renders the whole block
+  // on its own and idle voices are skipped outright.
+  if ((voiceMask & drumVoiceBit(DrumVoiceId::Kick)) && kickActive) {
+    for (size_t i = 0; i < numSamples; ++i)
+      out[i] += processKick();
+  }
+  if ((voiceMask & drumVoiceBit(DrumVoiceId::Snare)) && snareActive) {
+    for (size_t i = 0; i < numSamples; ++i)
+      out[i] += processSnare();
+  }
+  if ((voiceMask & drumVoiceBit(DrumVoiceId::Hat)) && hatActive) {
+    for (size_t i = 0; i < numSamples; ++i)
+      out[i] += processHat();
+  }
+  if ((voiceMask & drumVoiceBit(DrumVoiceId::OpenHat)) && openHatActive) {
+    for (size_t i = 0; i < numSamples; ++i)
+      out[i] += processOpenHat();
+  }
+  if ((voiceMask & drumVoiceBit(DrumVoiceId::MidTom)) && midTomActive) {
+    for (size_t i = 0; i < numSamples; ++i)
+      out[i] += processMidTom();
+  }
+  if ((voiceMask & drumVoiceBit(DrumVoiceId::HighTom)) && highTomActive) {
+    for (size_t i = 0; i < numSamples; ++i)
+      out[i] += processHighTom();
+  }
+  if ((voiceMask & drumVoiceBit(DrumVoiceId::Rim)) && rimActive) {
+    for (size_t i = 0; i < numSamples; ++i)
+      out[i] += processRim();
+  }
+  if ((voiceMask & drumVoiceBit(DrumVoiceId::Clap)) && clapActive) {
+    for (size_t i = 0; i < numSamples; ++i)
+      out[i] += processClap();
+  }
+}
+
+uint16_t TR909DrumSynthVoice::activeVoiceMask() const {
+  uint16_t mask = 0;
+  if (kickActive) mask |= drumVoiceBit(DrumVoiceId::Kick);
+  if (snareActive) mask |= drumVoiceBit(DrumVoiceId::Snare);
+  if (hatActive) mask |= drumVoiceBit(DrumVoiceId::Hat);
+  if (openHatActive) mask |= drumVoiceBit(DrumVoiceId::OpenHat);
+  if (midTomActive) mask |= drumVoiceBit(DrumVoiceId::MidTom);
+  if (highTomActive) mask |= drumVoiceBit(DrumVoiceId::HighTom);
+  if (rimActive) mask |= drumVoiceBit(DrumVoiceId::Rim);
+  if (clapActive) mask |= drumVoiceBit(DrumVoiceId::Clap);
+  return mask;
 }
 
 const Parameter& TR909DrumSynthVoice::parameter(DrumParamId id) const {
@@ -1021,6 +1249,7 @@ const Parameter& TR909DrumSynthVoice::parameter(DrumParamId id) const {
 
 void TR909DrumSynthVoice::setParameter(DrumParamId id, float value) {
   params[static_cast<int>(id)].setValue(value);
+  ++parameterVersion_;
 }
 
 TR606DrumSynthVoice::TR606DrumSynthVoice(float sampleRate)
@@ -1035,16 +1264,16 @@ void TR606DrumSynthVoice::reset() {
   kickAmpEnv = 0.0f;
   kickFmEnv = 0.0f;
   kickActive = false;
-  kickAmpDecay = decayCoeff(0.180f);
-  kickFmDecay = decayCoeff(0.012f);
+  kickAmpDecay = decay(Decay::KickAmp);
+  kickFmDecay = decay(Decay::KickFm);
 
   snareTonePhaseA = 0.0f;
   snareTonePhaseB = 0.0f;
   snareToneEnv = 0.0f;
   snareNoiseEnv = 0.0f;
   snareActive = false;
-  snareToneDecay = decayCoeff(0.075f);
-  snareNoiseDecay = decayCoeff(0.115f);
+  snareToneDecay = decay(Decay::SnareTone);
+  snareNoiseDecay = decay(Decay::SnareNoise);
   snareNoiseLp.reset();
   snareNoiseLpCoeff = onePoleCoeff(2200.0f);
 
@@ -1052,22 +1281,22 @@ void TR606DrumSynthVoice::reset() {
   midTomAmpEnv = 0.0f;
   midTomFmEnv = 0.0f;
   midTomActive = false;
-  midTomAmpDecay = decayCoeff(0.120f);
-  midTomFmDecay = decayCoeff(0.010f);
+  midTomAmpDecay = decay(Decay::MidTomAmp);
+  midTomFmDecay = decay(Decay::MidTomFm);
 
   highTomPhase = 0.0f;
   highTomAmpEnv = 0.0f;
   highTomFmEnv = 0.0f;
   highTomActive = false;
-  highTomAmpDecay = decayCoeff(0.095f);
-  highTomFmDecay = decayCoeff(0.009f);
+  highTomAmpDecay = decay(Decay::HighTomAmp);
+  highTomFmDecay = decay(Decay::HighTomFm);
 
   hatEnv = 0.0f;
   openHatEnv = 0.0f;
   hatActive = false;
   openHatActive = false;
-  hatDecay = decayCoeff(0.040f);
-  openHatDecay = decayCoeff(0.280f);
+  hatDecay = decay(Decay::Hat);
+  openHatDecay = decay(Decay::OpenHat);
   hatNoiseLp.reset();
   hatMetalLp.reset();
   hatNoiseLpCoeff = onePoleCoeff(8000.0f);
@@ -1075,14 +1304,18 @@ void TR606DrumSynthVoice::reset() {
 
   cymbalEnv = 0.0f;
   cymbalActive = false;
-  cymbalDecay = decayCoeff(0.600f);
+  cymbalDecay = decay(Decay::Cymbal);
   cymbalBandpass.reset();
 
   accentEnv = 0.35f;
-  accentDecay = decayCoeff(0.110f);
-
-  for (int i = 0; i < 6; ++i) {
-    metalPhases[i] = 0.0f;
+  accentDecay = decay(Decay::Accent);
+
+  // Six detuned square partials, evenly mixed, as in the 606 metal circuit.
+  static const float kMetalFreqs[kMetalOscCount] = {330.0f, 558.0f, 880.0f, 1320.0f, 1760.0f, 2640.0f};
+  metalBank.clear();
+  for (int i = 0; i < kMetalOscCount; ++i) {
+    metalBank.ratio[i] = kMetalFreqs[i];
+    metalBank.weight[i] = 1.0f / kMetalOscCount;
   }
   metalSignal = 0.0f;
 
@@ -1097,21 +1330,24 @@ void TR606DrumSynthVoice::setSampleRate(float sampleRateHz) {
   if (sampleRateHz <= 0.0f) sampleRateHz = 44100.0f;
   sampleRate = sampleRateHz;
   invSampleRate = 1.0f / sampleRate;
-  kickAmpDecay = decayCoeff(0.180f);
-  kickFmDecay = decayCoeff(0.012f);
-  snareToneDecay = decayCoeff(0.075f);
-  snareNoiseDecay = decayCoeff(0.115f);
+  static_assert(sizeof(kTr606DecayTimes) / sizeof(double) == static_cast<size_t>(Decay::Count),
+                "one time per 606 time constant");
+  loadDecays(kTr606Decays, sampleRate, decays);
+  kickAmpDecay = decay(Decay::KickAmp);
+  kickFmDecay = decay(Decay::KickFm);
+  snareToneDecay = decay(Decay::SnareTone);
+  snareNoiseDecay = decay(Decay::SnareNoise);
   snareNoiseLpCoeff = onePoleCoeff(2200.0f);
-  midTomAmpDecay = decayCoeff(0.120f);
-  midTomFmDecay = decayCoeff(0.010f);
-  highTomAmpDecay = decayCoeff(0.095f);
-  highTomFmDecay = decayCoeff(0.009f);
-  hatDecay = decayCoeff(0.040f);
-  openHatDecay = decayCoeff(0.280f);
+  midTomAmpDecay = decay(Decay::MidTomAmp);
+  midTomFmDecay = decay(Decay::MidTomFm);
+  highTomAmpDecay = decay(Decay::HighTomAmp);
+  highTomFmDecay = decay(Decay::HighTomFm);
+  hatDecay = decay(Decay::Hat);
+  openHatDecay = decay(Decay::OpenHat);
   hatNoiseLpCoeff = onePoleCoeff(8000.0f);
   hatMetalLpCoeff = onePoleCoeff(6000.0f);
-  cymbalDecay = decayCoeff(0.600f);
-  accentDecay = decayCoeff(0.110f);
+  cymbalDecay = decay(Decay::Cymbal);
+  accentDecay = decay(Decay::Accent);
   updateHatFilters(accentEnv);
   updateCymbalFilter(accentEnv, cymbalBandpass);
 }
@@ -1172,7 +1408,7 @@ void TR606DrumSynthVoice::triggerCymbal(bool accent) {
   setAccent(accent);
   cymbalActive = true;
   cymbalEnv = 1.0f + accentEnv * 0.5f;
-  cymbalDecay = decayCoeff(0.600f * (1.0f + accentEnv * 0.5f));
+  cymbalDecay = decay(accent ? Decay::CymbalAccent : Decay::Cymbal);
   updateCymbalFilter(accentEnv, cymbalBandpass);
 }
 
@@ -1183,7 +1419,10 @@ void TR606DrumSynthVoice::triggerClap(bool accent) {
 float TR606DrumSynthVoice::processKick() {
   accentEnv *= accentDecay;
   updateMetalBank();
+  return renderKick();
+}
 
+float TR606DrumSynthVoice::renderKick() {
   if (!kickActive)
     return 0.0f;
 
@@ -1199,7 +1438,7 @@ float TR606DrumSynthVoice::processKick() {
   kickPhase += (baseFreq + fmHz) * invSampleRate;
   if (kickPhase >= 1.0f) kickPhase -= 1.0f;
 
-  float out = sinf(2.0f * 3.14159265f * kickPhase) * kickAmpEnv;
+  float out = dspSin2Pi(kickPhase) * kickAmpEnv;
   return out;
 }
 
@@ -1220,8 +1459,8 @@ float TR606DrumSynthVoice::processSnare() {
   if (snareTonePhaseB >= 1.0f) snareTonePhaseB -= 1.0f;
 
   float tone =
-    (sinf(2.0f * 3.14159265f * snareTonePhaseA) +
-     sinf(2.0f * 3.14159265f * snareTonePhaseB)) * 0.5f * snareToneEnv;
+    (dspSin2Pi(snareTonePhaseA) +
+     dspSin2Pi(snareTonePhaseB)) * 0.5f * snareToneEnv;
 
   float noise = frand();
   snareNoiseLp.a = snareNoiseLpCoeff;
@@ -1287,7 +1526,7 @@ float TR606DrumSynthVoice::processMidTom() {
   midTomPhase += (baseFreq + fmHz) * invSampleRate;
   if (midTomPhase >= 1.0f) midTomPhase -= 1.0f;
 
-  return sinf(2.0f * 3.14159265f * midTomPhase) * midTomAmpEnv;
+  return dspSin2Pi(midTomPhase) * midTomAmpEnv;
 }
 
 float TR606DrumSynthVoice::processHighTom() {
@@ -1306,7 +1545,7 @@ float TR606DrumSynthVoice::processHighTom() {
   highTomPhase += (baseFreq + fmHz) * invSampleRate;
   if (highTomPhase >= 1.0f) highTomPhase -= 1.0f;
 
-  return sinf(2.0f * 3.14159265f * highTomPhase) * highTomAmpEnv;
+  return dspSin2Pi(highTomPhase) * highTomAmpEnv;
 }
 
 float TR606DrumSynthVoice::processRim() {
@@ -1323,7 +1562,7 @@ float TR606DrumSynthVoice::processCymbal() {
     return 0.0f;
   }
 
-  float clipped = tanhf(metalSignal * 2.2f);
+  float clipped = dspTanh(metalSignal * 2.2f);
   float out = cymbalBandpass.process(clipped) * cymbalEnv;
   return out;
 }
@@ -1332,20 +1571,73 @@ float TR606DrumSynthVoice::processClap() {
   return 0.0f;
 }
 
+void TR606DrumSynthVoice::process(float* out, size_t numSamples, uint16_t voiceMask) {
+  // Voices cannot start mid-block, so anything idle now stays silent.
+  uint16_t live = voiceMask & activeVoiceMask();
+  bool kick = (live & drumVoiceBit(DrumVoiceId::Kick)) != 0;
+  bool snare = (live & drumVoiceBit(DrumVoiceId::Snare)) != 0;
+  bool hat = (live & drumVoiceBit(DrumVoiceId::Hat)) != 0;
+  bool openHat = (live & drumVoiceBit(DrumVoiceId::OpenHat)) != 0;
+  bool midTom = (live & drumVoiceBit(DrumVoiceId::MidTom)) != 0;
+  bool highTom = (live & drumVoiceBit(DrumVoiceId::HighTom)) != 0;
+  bool rim = (live & drumVoiceBit(DrumVoiceId::Rim)) != 0;
+
+  // The 606 voices share the accent envelope, the metal bank and the hat
+  // filters, so they have to be interleaved sample by sample. The metal bank
+  // is free-running, so it is rendered ahead a chunk at a time.
+  constexpr size_t kMetalChunk = 32;
+  float metal[kMetalChunk];
+  for (size_t start = 0; start < numSamples; start += kMetalChunk) {
+    size_t n = numSamples - start;
+    if (n > kMetalChunk) n = kMetalChunk;
+    oscBankSquare(metalBank, invSampleRate, metal, n);
+    for (size_t i = 0; i < n; ++i) {
+      accentEnv *= accentDecay;
+      metalSignal = metal[i];
+      float sample = 0.0f;
+      if (kick)
+        sample += renderKick();
+      if (snare)
+        sample += processSnare();
+      if (hat)
+        sample += processHat();
+      if (openHat)
+        sample += processOpenHat();
+      if (midTom)
+        sample += processMidTom();
+      if (highTom)
+        sample += processHighTom();
+      if (rim)
+        sample += processRim();
+      out[start + i] = sample;
+    }
+  }
+}
+
+uint16_t TR606DrumSynthVoice::activeVoiceMask() const {
+  uint16_t mask = 0;
+  if (kickActive) mask |= drumVoiceBit(DrumVoiceId::Kick);
+  if (snareActive) mask |= drumVoiceBit(DrumVoiceId::Snare);
+  if (hatActive) mask |= drumVoiceBit(DrumVoiceId::Hat);
+  if (openHatActive) mask |= drumVoiceBit(DrumVoiceId::OpenHat);
+  if (midTomActive) mask |= drumVoiceBit(DrumVoiceId::MidTom);
+  if (highTomActive) mask |= drumVoiceBit(DrumVoiceId::HighTom);
+  if (cymbalActive) mask |= drumVoiceBit(DrumVoiceId::Rim);
+  // The 606 has no clap.
+  return mask;
+}
+
 const Parameter& TR606DrumSynthVoice::parameter(DrumParamId id) const {
   return params[static_cast<int>(id)];
 }
 
 void TR606DrumSynthVoice::setParameter(DrumParamId id, float value) {
   params[static_cast<int>(id)].setValue(value);
+  ++parameterVersion_;
 }
 
 float TR606DrumSynthVoice::frand() {
-  return (float)rand() / (float)RAND_MAX * 2.0f - 1.0f;
-}
-
-float TR606DrumSynthVoice::decayCoeff(float timeSeconds) const {
-  return expf(-1.0f / (timeSeconds * sampleRate));
+  return noise.bipolar();
 }
 
 float TR606DrumSynthVoice::onePoleCoeff(float cutoffHz) const {
@@ -1353,23 +1645,12 @@ float TR606DrumSynthVoice::onePoleCoeff(float cutoffHz) const {
   return 1.0f - expf(-omega);
 }
 
-float TR606DrumSynthVoice::square(float phase) const {
-  return phase < 0.5f ? 1.0f : -1.0f;
-}
-
 void TR606DrumSynthVoice::setAccent(bool accent) {
   accentEnv = accent ? 1.0f : 0.35f;
 }
 
 void TR606DrumSynthVoice::updateMetalBank() {
-  float sum = 0.0f;
-  for (int i = 0; i < 6; ++i) {
-    metalPhases[i] += metalFreqs[i] * invSampleRate;
-    if (metalPhases[i] >= 1.0f)
-      metalPhases[i] -= 1.0f;
-    sum += square(metalPhases[i]);
-  }
-  metalSignal = sum / 6.0f;
+  oscBankSquare(metalBank, invSampleRate, &metalSignal, 1);
 }
 
 void TR606DrumSynthVoice::updateHatFilters(float accent) {
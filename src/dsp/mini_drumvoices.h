@@ -1,8 +1,11 @@
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include "mini_dsp_params.h"
+#include "osc_bank.h"
+#include "random_generator.h"
 #include "tube_distortion.h"
 
 enum class DrumParamId : uint8_t {
@@ -10,6 +13,24 @@ enum class DrumParamId : uint8_t {
   Count
 };
 
+// Kit voices in DrumPatternSet lane order, used to build the voice masks
+// passed to DrumSynthVoice::process().
+enum class DrumVoiceId : uint8_t {
+  Kick = 0,
+  Snare,
+  Hat,
+  OpenHat,
+  MidTom,
+  HighTom,
+  Rim,
+  Clap,
+  Count
+};
+
+constexpr uint16_t drumVoiceBit(DrumVoiceId id) {
+  return static_cast<uint16_t>(1u << static_cast<int>(id));
+}
+
 class DrumSynthVoice {
 public:
   virtual ~DrumSynthVoice() = default;
@@ -36,11 +57,28 @@ public:
   virtual float processClap() = 0;
   virtual float processCymbal() = 0;
 
+  // Renders numSamples of the summed kit into out, overwriting its contents.
+  // Only voices whose drumVoiceBit() is set in voiceMask are mixed.
+  virtual void process(float* out, size_t numSamples, uint16_t voiceMask) = 0;
+  // drumVoiceBit()s of the voices that are still sounding. A kit whose mask
+  // does not overlap the voices being played renders silence and can be
+  // skipped until the next trigger.
+  virtual uint16_t activeVoiceMask() const = 0;
+
   virtual const Parameter& parameter(DrumParamId id) const = 0;
   virtual void setParameter(DrumParamId id, float value) = 0;
+
+  // Dispatches to the trigger*() call for id.
+  void trigger(DrumVoiceId id, bool accent);
+  // Changes whenever setParameter() is called, so anything derived from the
+  // kit's sound (such as DrumHitCache) can tell it is out of date.
+  uint32_t parameterVersion() const { return parameterVersion_; }
+
+protected:
+  uint32_t parameterVersion_ = 0;
 };
 
-class TR808DrumSynthVoice : public DrumSynthVoice {
+class TR808DrumSynthVoice final : public DrumSynthVoice {
 public:
   explicit TR808DrumSynthVoice(float sampleRate);
 
@@ -66,6 +104,9 @@ public:
   float processClap() override;
   float processCymbal() override;
 
+  void process(float* out, size_t numSamples, uint16_t voiceMask) override;
+  uint16_t activeVoiceMask() const override;
+
   const Parameter& parameter(DrumParamId id) const override;
   void setParameter(DrumParamId id, float value) override;
 
@@ -93,9 +134,37 @@ private:
   };
 
   float frand();
-  float applyAccentDistortion(float input, bool accent);
+  // lastInput is the voice's antialiasing state in the shared shaper.
+  float applyAccentDistortion(float input, bool accent, float& lastInput);
   void updateClapFilters(float accentAmount);
 
+  // Envelopes and noise-filter poles with a fixed time constant.
+  // setSampleRate() loads their per-sample multipliers from the lookup
+  // tables.
+  enum class Decay : uint8_t {
+    KickAmp = 0,
+    KickAmpAccent,
+    KickPitch,
+    SnareAmp,
+    SnareTone,
+    HatAmp,
+    HatTone,
+    OpenHatAmp,
+    OpenHatTone,
+    MidTom,
+    HighTom,
+    Rim,
+    Clap,
+    ClapTrans,
+    Cymbal,
+    CymbalTone,
+    HatHp,
+    OpenHatHp,
+    CymbalHp,
+    Count
+  };
+  float decay(Decay id) const { return decays[static_cast<int>(id)]; }
+
   float kickPhase;
   float kickFreq;
   float kickEnvAmp;
@@ -103,6 +172,7 @@ private:
   bool kickActive;
   float kickAccentGain;
   bool kickAccentDistortion;
+  float kickAccentInput;
   float kickAmpDecay;
   float kickBaseFreq;
 
@@ -111,11 +181,13 @@ private:
   bool snareActive;
   float snareBp;
   float snareLp;
+  float snareBpCoeff; // tuning of the snareBp/snareLp noise filter
   float snareTonePhase;
   float snareTonePhase2;
   float snareAccentGain;
   float snareToneGain;
   bool snareAccentDistortion;
+  float snareAccentInput;
 
   float hatEnvAmp;
   float hatToneEnv;
@@ -127,6 +199,7 @@ private:
   float hatAccentGain;
   float hatBrightness;
   bool hatAccentDistortion;
+  float hatAccentInput;
 
   float openHatEnvAmp;
   float openHatToneEnv;
@@ -138,24 +211,28 @@ private:
   float openHatAccentGain;
   float openHatBrightness;
   bool openHatAccentDistortion;
+  float openHatAccentInput;
 
   float midTomPhase;
   float midTomEnv;
   bool midTomActive;
   float midTomAccentGain;
   bool midTomAccentDistortion;
+  float midTomAccentInput;
 
   float highTomPhase;
   float highTomEnv;
   bool highTomActive;
   float highTomAccentGain;
   bool highTomAccentDistortion;
+  float highTomAccentInput;
 
   float rimPhase;
   float rimEnv;
   bool rimActive;
   float rimAccentGain;
   bool rimAccentDistortion;
+  float rimAccentInput;
 
   float clapEnv;
   float clapTrans;
@@ -166,6 +243,7 @@ private:
   float clapAccentAmount;
   float clapAccentGain;
   bool clapAccentDistortion;
+  float clapAccentInput;
   Biquad clapBandpass;
   Biquad clapLowpass;
 
@@ -179,16 +257,19 @@ private:
   float cymbalAccentGain;
   float cymbalBrightness;
   bool cymbalAccentDistortion;
+  float cymbalAccentInput;
 
   float sampleRate;
   float invSampleRate;
+  float decays[static_cast<int>(Decay::Count)];
 
   TubeDistortion accentDistortion;
+  RandomGenerator noise; // frand()'s source, private to this kit
 
   Parameter params[static_cast<int>(DrumParamId::Count)];
 };
 
-class TR909DrumSynthVoice : public DrumSynthVoice {
+class TR909DrumSynthVoice final : public DrumSynthVoice {
 public:
   explicit TR909DrumSynthVoice(float sampleRate);
 
@@ -214,6 +295,9 @@ public:
   float processClap() override;
   float processCymbal() override;
 
+  void process(float* out, size_t numSamples, uint16_t voiceMask) override;
+  uint16_t activeVoiceMask() const override;
+
   const Parameter& parameter(DrumParamId id) const override;
   void setParameter(DrumParamId id, float value) override;
 
@@ -241,9 +325,38 @@ private:
   };
 
   float frand();
-  float applyAccentDistortion(float input, bool accent);
+  // lastInput is the voice's antialiasing state in the shared shaper.
+  float applyAccentDistortion(float input, bool accent, float& lastInput);
   void updateClapFilter();
 
+  // Envelopes and noise-filter poles with a fixed time constant.
+  // setSampleRate() loads their per-sample multipliers from the lookup
+  // tables.
+  enum class Decay : uint8_t {
+    KickAmp = 0,
+    KickAmpAccent,
+    KickPitch,
+    KickClick,
+    SnareAmp,
+    SnareTone,
+    HatAmp,
+    HatTone,
+    OpenHatAmp,
+    OpenHatTone,
+    MidTom,
+    HighTom,
+    Rim,
+    Clap,
+    Cymbal,
+    CymbalTone,
+    SnareColor,
+    HatHp,
+    OpenHatHp,
+    CymbalHp,
+    Count
+  };
+  float decay(Decay id) const { return decays[static_cast<int>(id)]; }
+
   float kickPhase;
   float kickFreq;
   float kickEnvAmp;
@@ -251,6 +364,7 @@ private:
   bool kickActive;
   float kickAccentGain;
   bool kickAccentDistortion;
+  float kickAccentInput;
   float kickAmpDecay;
   float kickBaseFreq;
   float kickClickEnv;
@@ -260,11 +374,13 @@ private:
   bool snareActive;
   float snareBp;
   float snareLp;
+  float snareBpCoeff; // tuning of the snareBp/snareLp noise filter
   float snareTonePhase;
   float snareTonePhase2;
   float snareAccentGain;
   float snareToneGain;
   bool snareAccentDistortion;
+  float snareAccentInput;
   float snareNoiseColor;
 
   float hatEnvAmp;
@@ -277,6 +393,7 @@ private:
   float hatAccentGain;
   float hatBrightness;
   bool hatAccentDistortion;
+  float hatAccentInput;
 
   float openHatEnvAmp;
   float openHatToneEnv;
@@ -288,24 +405,28 @@ private:
   float openHatAccentGain;
   float openHatBrightness;
   bool openHatAccentDistortion;
+  float openHatAccentInput;
 
   float midTomPhase;
   float midTomEnv;
   bool midTomActive;
   float midTomAccentGain;
   bool midTomAccentDistortion;
+  float midTomAccentInput;
 
   float highTomPhase;
   float highTomEnv;
   bool highTomActive;
   float highTomAccentGain;
   bool highTomAccentDistortion;
+  float highTomAccentInput;
 
   float rimPhase;
   float rimEnv;
   bool rimActive;
   float rimAccentGain;
   bool rimAccentDistortion;
+  float rimAccentInput;
 
   float clapEnv;
   float clapTrans;
@@ -315,6 +436,7 @@ private:
   float clapTime;
   float clapAccentGain;
   bool clapAccentDistortion;
+  float clapAccentInput;
   Biquad clapBandpass;
 
   float cymbalEnv;
@@ -327,16 +449,19 @@ private:
   float cymbalAccentGain;
   float cymbalBrightness;
   bool cymbalAccentDistortion;
+  float cymbalAccentInput;
 
   float sampleRate;
   float invSampleRate;
+  float decays[static_cast<int>(Decay::Count)];
 
   TubeDistortion accentDistortion;
+  RandomGenerator noise; // frand()'s source, private to this kit
 
   Parameter params[static_cast<int>(DrumParamId::Count)];
 };
 
-class TR606DrumSynthVoice : public DrumSynthVoice {
+class TR606DrumSynthVoice final : public DrumSynthVoice {
 public:
   explicit TR606DrumSynthVoice(float sampleRate);
 
@@ -362,6 +487,9 @@ public:
   float processClap() override;
   float processCymbal() override;
 
+  void process(float* out, size_t numSamples, uint16_t voiceMask) override;
+  uint16_t activeVoiceMask() const override;
+
   const Parameter& parameter(DrumParamId id) const override;
   void setParameter(DrumParamId id, float value) override;
 
@@ -396,14 +524,34 @@ private:
   };
 
   float frand();
-  float decayCoeff(float timeSeconds) const;
   float onePoleCoeff(float cutoffHz) const;
-  float square(float phase) const;
+  float renderKick();
   void setAccent(bool accent);
   void updateMetalBank();
   void updateHatFilters(float accent);
   void updateCymbalFilter(float accent, Biquad& filter);
 
+  // Envelopes and noise-filter poles with a fixed time constant.
+  // setSampleRate() loads their per-sample multipliers from the lookup
+  // tables.
+  enum class Decay : uint8_t {
+    KickAmp = 0,
+    KickFm,
+    SnareTone,
+    SnareNoise,
+    MidTomAmp,
+    MidTomFm,
+    HighTomAmp,
+    HighTomFm,
+    Hat,
+    OpenHat,
+    Cymbal,
+    CymbalAccent,
+    Accent,
+    Count
+  };
+  float decay(Decay id) const { return decays[static_cast<int>(id)]; }
+
   float kickPhase;
   float kickAmpEnv;
   float kickFmEnv;
@@ -456,10 +604,12 @@ private:
 
   float sampleRate;
   float invSampleRate;
+  float decays[static_cast<int>(Decay::Count)];
 
-  float metalPhases[6];
+  static constexpr int kMetalOscCount = 6;
+  OscBank metalBank; // lane ratios are the partial frequencies in Hz
   float metalSignal;
-  const float metalFreqs[6] = {330.0f, 558.0f, 880.0f, 1320.0f, 1760.0f, 2640.0f};
+  RandomGenerator noise; // frand()'s source, private to this kit
 
   Parameter params[static_cast<int>(DrumParamId::Count)];
 };
@@ -3,38 +3,69 @@
 #include <math.h>
 #include <stdlib.h>
 
+#include "fixed_point.h"
+#include "lookup_tables.h"
+#include "poly_blep.h"
+
 namespace {
 const char* const kOscillatorOptions[] = {"saw", "sqr", "super"};
-const char* const kFilterTypeOptions[] = {"lp", "bp", "hp"};
+// A slide closes 1/e of the gap to the target pitch in this time.
+constexpr double kSlideTimes[] = {45.33e-3};
+constexpr auto kSlideDecay = makeDecayTable(kSlideTimes);
+// lp/bp/hp: Chamberlin SVF; z*: zero-delay-feedback SVF; lad: 4-pole
+// zero-delay-feedback ladder. New types go on the end so saved indices keep
+// their meaning.
+const char* const kFilterTypeOptions[] = {"lp", "bp", "hp", "zlp", "zbp", "zhp", "lad"};
 } // namespace
 
+TB303Voice::TB303Voice() : TB303Voice(44100.0f) {}
+
 TB303Voice::TB303Voice(float sampleRate)
-  : sampleRate(sampleRate),
+  : decayCoeff(1.0f),
+    decayCoeffMs(-1.0f),
+    sampleRate(sampleRate),
     invSampleRate(0.0f),
     nyquist(0.0f),
-    filter(nullptr) {
+    filter(sampleRate),
+    zdfFilter(sampleRate),
+    ladderFilter(sampleRate),
+    activeModel(FilterModel::Chamberlin),
+    fadeFromModel(FilterModel::Chamberlin),
+    filterFadeSamples(static_cast<int>(kControlInterval)),
+    filterFadeRemaining(0) {
   setSampleRate(sampleRate);
-  createFilter(0); // Default to lowpass
   reset();
 }
 
 void TB303Voice::reset() {
   initParameters();
+  static const float kSuperSawDetune[kSuperSawOscCount] = {
+    -0.019f, 0.019f, -0.012f, 0.012f, -0.0065f, 0.0065f
+  };
+
   phase = 0.0f;
+  superBank.clear();
+  superBank.ratio[0] = 1.0f;
+  superBank.weight[0] = 1.0f;
   for (int i = 0; i < kSuperSawOscCount; ++i) {
     float seed = (static_cast<float>(i) + 1.0f) * 0.137f;
-    superPhases[i] = seed - floorf(seed);
+    superBank.phase[i + 1] = seed - floorf(seed);
+    superBank.ratio[i + 1] = 1.0f + kSuperSawDetune[i];
+    superBank.weight[i + 1] = 1.0f;
   }
   freq = 110.0f;
   targetFreq = 110.0f;
-  slideSpeed = 0.001f;
   env = 0.0f;
   gate = false;
   slide = false;
+  envRetriggered = false;
   amp = 0.3f;
-  if (filter) {
-    filter->reset();
-  }
+  filter.reset();
+  zdfFilter.reset();
+  ladderFilter.reset();
+  selectFilter();
+  filterFadeRemaining = 0;
+  oversampler.reset();
 }
 
 void TB303Voice::setSampleRate(float sampleRateHz) {
@@ -42,9 +73,32 @@ void TB303Voice::setSampleRate(float sampleRateHz) {
   sampleRate = sampleRateHz;
   invSampleRate = 1.0f / sampleRate;
   nyquist = sampleRate * 0.5f;
-  if (filter) {
-    filter->setSampleRate(sampleRate);
-  }
+  decayCoeffMs = -1.0f;
+  float slideDecay[1];
+  loadDecays(kSlideDecay, sampleRate, slideDecay);
+  slideSpeed = 1.0f - slideDecay[0];
+  float filterRate = sampleRate * static_cast<float>(oversampler.factor());
+  filter.setSampleRate(filterRate);
+  zdfFilter.setSampleRate(filterRate);
+  ladderFilter.setSampleRate(filterRate);
+}
+
+void TB303Voice::setOversampling(int factor) {
+  oversampler.configure(factor, kControlInterval);
+  if (oversampler.factor() > 1)
+    oversampled.assign(kControlInterval * oversampler.factor(), 0.0f);
+  else
+    std::vector<float>().swap(oversampled);
+  float filterRate = sampleRate * static_cast<float>(oversampler.factor());
+  filter.setSampleRate(filterRate);
+  zdfFilter.setSampleRate(filterRate);
+  ladderFilter.setSampleRate(filterRate);
+  filterFadeSamples = static_cast<int>(kControlInterval) * oversampler.factor();
+  filterFadeRemaining = 0;
+}
+
+int TB303Voice::oversampling() const {
+  return oversampler.factor();
 }
 
 void TB303Voice::startNote(float freqHz, bool accent, bool slideFlag) {
@@ -57,120 +111,245 @@ void TB303Voice::startNote(float freqHz, bool accent, bool slideFlag) {
 
   gate = true;
   env = accent ? 2.0f : 1.0f;
+  envRetriggered = true;
 }
 
 void TB303Voice::release() { gate = false; }
 
 float TB303Voice::oscSaw() {
-  phase += freq * invSampleRate;
+  float inc = freq * invSampleRate;
+  phase += inc;
   if (phase >= 1.0f) {
     phase -= 1.0f;
   }
-  return 2.0f * phase - 1.0f;
-}
-
-float TB303Voice::oscSquare(float saw) {
-  return saw >= 0.0f ? 1.0f : -1.0f;
+  return bandLimitedSaw(phase, inc);
 }
 
-float TB303Voice::oscSuperSaw() {
-  static const float kSuperSawDetune[kSuperSawOscCount] = {
-    -0.019f, 0.019f, -0.012f, 0.012f, -0.0065f, 0.0065f
-  };
-
-  float basePhaseInc = freq * invSampleRate;
-  phase += basePhaseInc;
+float TB303Voice::oscSquare() {
+  float inc = freq * invSampleRate;
+  phase += inc;
   if (phase >= 1.0f) {
     phase -= 1.0f;
   }
+  return bandLimitedSquare(phase, inc);
+}
 
-  float sum = 2.0f * phase - 1.0f;
+float TB303Voice::oscSuperSaw() {
+  float inc = freq * invSampleRate;
+  float out;
+  oscSuperSaw(&inc, &out, 1);
+  return out;
+}
 
-  for (int i = 0; i < kSuperSawOscCount; ++i) {
-    float detunedFreq = freq * (1.0f + kSuperSawDetune[i]);
-    float inc = detunedFreq * invSampleRate;
-    superPhases[i] += inc;
-    if (superPhases[i] >= 1.0f) {
-      superPhases[i] -= floorf(superPhases[i]);
-    } else if (superPhases[i] < 0.0f) {
-      superPhases[i] += 1.0f;
-    }
-    sum += 2.0f * superPhases[i] - 1.0f;
-  }
+void TB303Voice::oscSuperSaw(const float* inc, float* out, size_t numSamples) {
+  static_assert(kSuperSawOscCount + 1 <= OscBank::kLanes, "supersaw needs a lane per saw");
+
+  superBank.phase[0] = phase;
+  oscBankSaw(superBank, inc, out, numSamples);
+  phase = superBank.phase[0];
 
   // constexpr float kGain = 1.0f / (1.0f + TB303Voice::kSuperSawOscCount);
   constexpr float kGain = 1.0f / (TB303Voice::kSuperSawOscCount - 5);
-  return sum * kGain;
+  for (size_t k = 0; k < numSamples; ++k)
+    out[k] *= kGain;
 }
 
 float TB303Voice::oscillatorSample() {
-  int oscIdx = oscillatorIndex();
-  if (oscIdx == 1) {
-    float saw = oscSaw();
-    return oscSquare(saw);
+  switch (oscillatorIndex()) {
+    case 1:
+      return oscSquare();
+    case 2:
+      return oscSuperSaw();
+    default:
+      return oscSaw();
   }
+}
+
+void TB303Voice::oscillatorBlock(int oscIdx, const float* inc, float* out, size_t numSamples) {
   if (oscIdx == 2) {
-    return oscSuperSaw();
+    oscSuperSaw(inc, out, numSamples);
+    return;
   }
-  return oscSaw();
+#if MINIACID_FIXED_POINT
+  // 32-bit phase accumulator: the wrap is the integer overflow and the saw
+  // is the accumulator read as a signed Q31 value.
+  constexpr float kPhaseScale = 4294967296.0f;
+  uint32_t acc = static_cast<uint32_t>(phase * kPhaseScale);
+  for (size_t k = 0; k < numSamples; ++k) {
+    acc += static_cast<uint32_t>(inc[k] * kPhaseScale);
+    int32_t saw = static_cast<int32_t>(acc ^ 0x80000000u);
+    if (oscIdx == 1)
+      out[k] = saw >= 0 ? 1.0f : -1.0f;
+    else
+      out[k] = static_cast<float>(saw) * (1.0f / 2147483648.0f);
+#if MINIACID_POLYBLEP
+    // The steps are smoothed in float from the accumulator's phase.
+    float t = static_cast<float>(acc) * (1.0f / kPhaseScale);
+    if (oscIdx == 1) {
+      float half = static_cast<float>(acc + 0x80000000u) * (1.0f / kPhaseScale);
+      out[k] += polyBlep(half, inc[k]) - polyBlep(t, inc[k]);
+    } else {
+      out[k] -= polyBlep(t, inc[k]);
+    }
+#endif
+  }
+  phase = static_cast<float>(acc) * (1.0f / kPhaseScale);
+  // Rounding can land exactly on 1.0, which the float oscillators never see.
+  if (phase >= 1.0f)
+    phase = 0.0f;
+#else
+  if (oscIdx == 1) {
+    for (size_t k = 0; k < numSamples; ++k) {
+      phase += inc[k];
+      if (phase >= 1.0f)
+        phase -= 1.0f;
+      out[k] = bandLimitedSquare(phase, inc[k]);
+    }
+  } else {
+    for (size_t k = 0; k < numSamples; ++k) {
+      phase += inc[k];
+      if (phase >= 1.0f)
+        phase -= 1.0f;
+      out[k] = bandLimitedSaw(phase, inc[k]);
+    }
+  }
+#endif
 }
 
-float TB303Voice::svfProcess(float input) {
-  // Slide toward target frequency
-  freq += (targetFreq - freq) * slideSpeed;
-  if (!isfinite(freq))
-    freq = targetFreq;
-
-  // Envelope decay
-  if (gate || env > 0.0001f) {
-    float decayMs = parameterValue(TB303ParamId::EnvDecay);
+float TB303Voice::envDecayCoeff() {
+  float decayMs = parameterValue(TB303ParamId::EnvDecay);
+  if (decayMs != decayCoeffMs) {
     float decaySamples = decayMs * sampleRate * 0.001f;
     if (decaySamples < 1.0f)
       decaySamples = 1.0f;
     // 0.01 represents roughly -40 dB, a practical "off" point for the envelope.
     constexpr float kDecayTargetLog = -4.60517019f; // ln(0.01f)
-    float decayCoeff = expf(kDecayTargetLog / decaySamples);
-    env *= decayCoeff;
+    decayCoeff = expf(kDecayTargetLog / decaySamples);
+    decayCoeffMs = decayMs;
   }
+  return decayCoeff;
+}
 
+float TB303Voice::envelopeCutoff() const {
   float cutoffHz = parameterValue(TB303ParamId::Cutoff) + parameterValue(TB303ParamId::EnvAmount) * env;
   if (cutoffHz < 50.0f)
     cutoffHz = 50.0f;
-  float maxCutoff = nyquist * 0.9f;
-  if (cutoffHz > maxCutoff)
-    cutoffHz = maxCutoff;
+  // The Chamberlin SVF goes unstable as its cutoff nears Nyquist. The TPT
+  // models prewarp with dspTanPi, which already stops just short of it.
+  bool chamberlin = activeModel == FilterModel::Chamberlin ||
+                    (filterFadeRemaining > 0 && fadeFromModel == FilterModel::Chamberlin);
+  if (chamberlin) {
+    float maxCutoff = nyquist * 0.9f;
+    if (cutoffHz > maxCutoff)
+      cutoffHz = maxCutoff;
+  }
+  return cutoffHz;
+}
+
+float TB303Voice::svfProcess(float input) {
+  // Slide toward target frequency
+  freq += (targetFreq - freq) * slideSpeed;
+  if (!isfinite(freq))
+    freq = targetFreq;
+
+  // Envelope decay
+  if (gate || env > 0.0001f) {
+    env *= envDecayCoeff();
+  }
 
+  return filterSample(input, envelopeCutoff(), parameterValue(TB303ParamId::Resonance));
+}
 
-  return filter->process(input, cutoffHz, parameterValue(TB303ParamId::Resonance));
+bool TB303Voice::isActive() const {
+  return gate || env >= 0.0001f;
 }
 
 float TB303Voice::process() {
-  if (!gate && env < 0.0001f) {
+  if (!isActive()) {
     return 0.0f;
   }
+  if (oversampler.factor() > 1) {
+    // The filter runs at the oversampled rate; go through the block path.
+    float out;
+    process(&out, 1);
+    return out;
+  }
 
+  selectFilter();
   float osc = oscillatorSample();
   float out = svfProcess(osc);
 
   return out * amp;
 }
 
+void TB303Voice::process(float* out, size_t numSamples) {
+  size_t i = 0;
+  if (isActive()) {
+    // Parameters can only change between blocks, so read them once.
+    int oscIdx = oscillatorIndex();
+    float decay = envDecayCoeff();
+    float resonance = parameterValue(TB303ParamId::Resonance);
+    selectFilter();
+    while (i < numSamples) {
+      // Once the envelope has died out the voice stays silent until the
+      // next startNote(), so the rest of the block can be zero-filled.
+      if (!isActive())
+        break;
+      size_t n = numSamples - i;
+      if (n > kControlInterval) n = kControlInterval;
+      float* segment = out + i;
+      float attackCutoff = 0.0f;
+      float inc[kControlInterval];
+      for (size_t k = 0; k < n; ++k) {
+        inc[k] = freq * invSampleRate;
+        freq += (targetFreq - freq) * slideSpeed;
+        if (gate || env > 0.0001f)
+          env *= decay;
+        if (k == 0 && envRetriggered)
+          attackCutoff = envelopeCutoff();
+      }
+      if (!isfinite(freq))
+        freq = targetFreq;
+
+      oscillatorBlock(oscIdx, inc, segment, n);
+
+      // The filter glides to the cutoff the envelope reaches at the end of
+      // the segment instead of retuning every sample. A fresh note keeps the
+      // 303's instant attack by tuning its first sample exactly.
+      size_t factor = static_cast<size_t>(oversampler.factor());
+      float* filtered = segment;
+      if (factor > 1) {
+        filtered = oversampled.data();
+        oversampler.upsample(segment, filtered, n);
+      }
+      size_t ramped = 0;
+      if (envRetriggered) {
+        filterRamp(filtered, factor, attackCutoff, resonance);
+        ramped = factor;
+        envRetriggered = false;
+      }
+      filterRamp(filtered + ramped, n * factor - ramped, envelopeCutoff(), resonance);
+      if (factor > 1)
+        oversampler.downsample(filtered, segment, n);
+      for (size_t k = 0; k < n; ++k)
+        segment[k] *= amp;
+      i += n;
+    }
+  }
+  for (; i < numSamples; ++i)
+    out[i] = 0.0f;
+}
+
 const Parameter& TB303Voice::parameter(TB303ParamId id) const {
   return params[static_cast<int>(id)];
 }
 
 void TB303Voice::setParameter(TB303ParamId id, float value) {
   params[static_cast<int>(id)].setValue(value);
-  if (id == TB303ParamId::FilterType) {
-    createFilter(params[static_cast<int>(id)].optionIndex());
-  }
 }
 
 void TB303Voice::adjustParameter(TB303ParamId id, int steps) {
   params[static_cast<int>(id)].addSteps(steps);
-  if (id == TB303ParamId::FilterType) {
-    createFilter(params[static_cast<int>(id)].optionIndex());
-  }
 }
 
 float TB303Voice::parameterValue(TB303ParamId id) const {
@@ -187,23 +366,113 @@ void TB303Voice::initParameters() {
   params[static_cast<int>(TB303ParamId::EnvAmount)] = Parameter("env", "Hz", 0.0f, 2000.0f, 400.0f, (2000.0f - 0.0f) / 128);
   params[static_cast<int>(TB303ParamId::EnvDecay)] = Parameter("dec", "ms", 20.0f, 2200.0f, 420.0f, (2200.0f - 20.0f) / 128);
   params[static_cast<int>(TB303ParamId::Oscillator)] = Parameter("osc", "", kOscillatorOptions, 3, 0);
-  params[static_cast<int>(TB303ParamId::FilterType)] = Parameter("flt", "", kFilterTypeOptions, 3, 0);
+  params[static_cast<int>(TB303ParamId::FilterType)] = Parameter("flt", "", kFilterTypeOptions, 7, 0);
   params[static_cast<int>(TB303ParamId::MainVolume)] = Parameter("vol", "", 0.0f, 1.0f, 0.8f, 1.0f / 128);
 }
 
-void TB303Voice::createFilter(int filterTypeIndex) {
-  switch (filterTypeIndex) {
-    case 0: // lp
-      filter = std::make_unique<ChamberlinFilterLp>(sampleRate);
-      break;
-    case 1: // bp
-      filter = std::make_unique<ChamberlinFilterBp>(sampleRate);
+TB303Voice::FilterModel TB303Voice::filterModel() const {
+  int type = params[static_cast<int>(TB303ParamId::FilterType)].optionIndex();
+  if (type >= 6)
+    return FilterModel::Ladder;
+  return type >= 3 ? FilterModel::TptSvf : FilterModel::Chamberlin;
+}
+
+SvfTap TB303Voice::filterTap() const {
+  switch (params[static_cast<int>(TB303ParamId::FilterType)].optionIndex()) {
+    case 1:
+    case 4:
+      return SvfTap::Bandpass;
+    case 2:
+    case 5:
+      return SvfTap::Highpass;
+    default:
+      return SvfTap::Lowpass;
+  }
+}
+
+void TB303Voice::selectFilter() {
+  FilterModel model = filterModel();
+  if (model != activeModel) {
+    switch (model) {
+      case FilterModel::TptSvf:
+        zdfFilter.reset();
+        break;
+      case FilterModel::Ladder:
+        ladderFilter.reset();
+        break;
+      case FilterModel::Chamberlin:
+      default:
+        filter.reset();
+        break;
+    }
+    fadeFromModel = activeModel;
+    activeModel = model;
+    filterFadeRemaining = filterFadeSamples;
+  }
+  SvfTap tap = filterTap();
+  filter.setTap(tap);
+  zdfFilter.setTap(tap);
+}
+
+float TB303Voice::filterSample(float input, float cutoffHz, float resonance) {
+  float out = modelSample(activeModel, input, cutoffHz, resonance);
+  if (filterFadeRemaining == 0)
+    return out;
+  --filterFadeRemaining;
+  float mix = 1.0f - static_cast<float>(filterFadeRemaining) / static_cast<float>(filterFadeSamples);
+  float from = modelSample(fadeFromModel, input, cutoffHz, resonance);
+  return from + (out - from) * mix;
+}
+
+void TB303Voice::filterRamp(float* samples, size_t numSamples, float cutoffHz, float resonance) {
+  size_t fade = static_cast<size_t>(filterFadeRemaining);
+  if (fade == 0) {
+    modelRamp(activeModel, samples, numSamples, cutoffHz, resonance);
+    return;
+  }
+  // The old model runs on a copy of the call so its cutoff ramp stays in
+  // step; a call is at most one control segment, which the scratch holds.
+  size_t n = numSamples;
+  if (n > kControlInterval * Oversampler::kMaxFactor)
+    n = kControlInterval * Oversampler::kMaxFactor;
+  for (size_t i = 0; i < n; ++i)
+    filterFadeScratch[i] = samples[i];
+  modelRamp(fadeFromModel, filterFadeScratch, n, cutoffHz, resonance);
+  modelRamp(activeModel, samples, numSamples, cutoffHz, resonance);
+  if (fade > n)
+    fade = n;
+  for (size_t i = 0; i < fade; ++i) {
+    --filterFadeRemaining;
+    float mix = 1.0f - static_cast<float>(filterFadeRemaining) / static_cast<float>(filterFadeSamples);
+    float from = filterFadeScratch[i];
+    samples[i] = from + (samples[i] - from) * mix;
+  }
+}
+
+float TB303Voice::modelSample(FilterModel model, float input, float cutoffHz, float resonance) {
+  switch (model) {
+    case FilterModel::TptSvf:
+      return zdfFilter.process(input, cutoffHz, resonance);
+    case FilterModel::Ladder:
+      return ladderFilter.process(input, cutoffHz, resonance);
+    case FilterModel::Chamberlin:
+    default:
+      return filter.process(input, cutoffHz, resonance);
+  }
+}
+
+void TB303Voice::modelRamp(FilterModel model, float* samples, size_t numSamples, float cutoffHz,
+                           float resonance) {
+  switch (model) {
+    case FilterModel::TptSvf:
+      zdfFilter.processRamp(samples, numSamples, cutoffHz, resonance);
       break;
-    case 2: // hp
-      filter = std::make_unique<ChamberlinFilterHp>(sampleRate);
+    case FilterModel::Ladder:
+      ladderFilter.processRamp(samples, numSamples, cutoffHz, resonance);
       break;
+    case FilterModel::Chamberlin:
     default:
-      filter = std::make_unique<ChamberlinFilterLp>(sampleRate);
+      filter.processRamp(samples, numSamples, cutoffHz, resonance);
       break;
   }
 }
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
-#include <memory>
+#include <vector>
 
 #include "filter.h"
 #include "mini_dsp_params.h"
+#include "osc_bank.h"
+#include "oversampler.h"
 
 enum class TB303ParamId : uint8_t {
   Cutoff = 0,
@@ -19,13 +22,23 @@ enum class TB303ParamId : uint8_t {
 
 class TB303Voice {
 public:
+  TB303Voice();
   explicit TB303Voice(float sampleRate);
 
   void reset();
   void setSampleRate(float sampleRate);
+  // Runs the filter at 1x, 2x or 4x the sample rate in the block renderer,
+  // so resonant sweeps alias less. Allocates; not for the audio thread.
+  void setOversampling(int factor);
+  int oversampling() const;
   void startNote(float freqHz, bool accent, bool slideFlag);
   void release();
+  // False once the note is released and the envelope has died out; the
+  // voice then renders silence until the next startNote().
+  bool isActive() const;
   float process();
+  // Renders numSamples of the voice into out, overwriting its contents.
+  void process(float* out, size_t numSamples);
   const Parameter& parameter(TB303ParamId id) const;
   void setParameter(TB303ParamId id, float value);
   void adjustParameter(TB303ParamId id, int steps);
@@ -34,23 +47,43 @@ public:
 
 private:
   float oscSaw();
-  float oscSquare(float saw);
+  float oscSquare();
   float oscSuperSaw();
+  void oscSuperSaw(const float* inc, float* out, size_t numSamples);
   float oscillatorSample();
+  void oscillatorBlock(int oscIdx, const float* inc, float* out, size_t numSamples);
   float svfProcess(float input);
+  float envDecayCoeff();
+  float envelopeCutoff() const;
   void initParameters();
-  void createFilter(int filterTypeIndex);
+  // Filter designs the FilterType parameter chooses between.
+  enum class FilterModel : uint8_t { Chamberlin, TptSvf, Ladder };
+  FilterModel filterModel() const;
+  SvfTap filterTap() const;
+  // Applies the FilterType parameter. A newly chosen model starts from a
+  // clean state rather than whatever it held when last used, and its output
+  // crossfades in from the old model's over one control segment.
+  void selectFilter();
+  float filterSample(float input, float cutoffHz, float resonance);
+  void filterRamp(float* samples, size_t numSamples, float cutoffHz, float resonance);
+  float modelSample(FilterModel model, float input, float cutoffHz, float resonance);
+  void modelRamp(FilterModel model, float* samples, size_t numSamples, float cutoffHz, float resonance);
 
   static constexpr int kSuperSawOscCount = 6;
+  // Samples between filter coefficient updates in the block renderer.
+  static constexpr size_t kControlInterval = 16;
 
   float phase;
-  float superPhases[kSuperSawOscCount];
+  OscBank superBank; // lane 0 mirrors phase, lanes 1.. are the detuned saws
   float freq;       // current frequency (Hz)
   float targetFreq; // slide target
   float slideSpeed; // how fast we slide toward target
   float env;        // filter envelope value
   bool gate;        // note on/off
   bool slide;       // slide flag for next note
+  float decayCoeff;   // per-sample envelope multiplier
+  float decayCoeffMs; // EnvDecay value decayCoeff was computed for
+  bool envRetriggered; // filter must jump, not glide, to the new envelope
   float amp;        // amplitude
 
   float sampleRate;
@@ -58,5 +91,16 @@ private:
   float nyquist;
 
   Parameter params[static_cast<int>(TB303ParamId::Count)];
-  std::unique_ptr<AudioFilter> filter;
+  // The lp/bp/hp types of each SVF share one state; the FilterType
+  // parameter picks the model and tap at the start of each block.
+  ChamberlinFilterMulti filter;
+  TptSvfFilter zdfFilter;
+  TptLadderFilter ladderFilter;
+  FilterModel activeModel;
+  FilterModel fadeFromModel;
+  int filterFadeSamples;   // length of the model crossfade at the filter's rate
+  int filterFadeRemaining; // samples left in it
+  float filterFadeScratch[kControlInterval * Oversampler::kMaxFactor]; // the old model's output
+  Oversampler oversampler;
+  std::vector<float> oversampled; // one control segment at the filter's rate
 };
@@ -6,6 +6,9 @@
 #include <cctype>
 #include <string>
 
+#include "denormal_guard.h"
+#include "lookup_tables.h"
+
 namespace {
 constexpr int kDrumKickVoice = 0;
 constexpr int kDrumSnareVoice = 1;
@@ -16,6 +19,10 @@ constexpr int kDrumHighTomVoice = 5;
 constexpr int kDrumRimVoice = 6;
 constexpr int kDrumClapVoice = 7;
 
+// Kits in getAvailableDrumEngines() order.
+const char* const kDrumEngineNames[] = {"808", "909", "606"};
+constexpr int kDrumEngineCount = sizeof(kDrumEngineNames) / sizeof(kDrumEngineNames[0]);
+
 SynthPattern makeEmptySynthPattern() {
   SynthPattern pattern{};
   for (int i = 0; i < SynthPattern::kSteps; ++i) {
@@ -48,6 +55,19 @@ std::string toLowerCopy(std::string value) {
 }
 }
 
+TempoDelay::TempoDelay()
+  : buffer(),
+    writeIndex(0),
+    delaySamples(1),
+    sampleRate(0.0f),
+    maxDelaySamples(0),
+    beats(0.25f),
+    mix(0.35f),
+    feedback(0.45f),
+    enabled(false),
+    idle(true),
+    quietRun(0) {}
+
 TempoDelay::TempoDelay(float sampleRate)
   : buffer(),
     writeIndex(0),
@@ -57,7 +77,9 @@ TempoDelay::TempoDelay(float sampleRate)
     beats(0.25f),
     mix(0.35f),
     feedback(0.45f),
-    enabled(false) {
+    enabled(false),
+    idle(true),
+    quietRun(0) {
   setSampleRate(sampleRate);
   reset();
 }
@@ -65,8 +87,10 @@ TempoDelay::TempoDelay(float sampleRate)
 void TempoDelay::reset() {
   if (buffer.empty())
     return;
-  std::fill(buffer.begin(), buffer.end(), 0.0f);
+  std::fill(buffer.begin(), buffer.end(), Sample(0));
   writeIndex = 0;
+  idle = true;
+  quietRun = 0;
   if (delaySamples < 1)
     delaySamples = 1;
   if (delaySamples >= maxDelaySamples)
@@ -79,7 +103,9 @@ void TempoDelay::setSampleRate(float sr) {
   maxDelaySamples = static_cast<int>(sampleRate * kMaxDelaySeconds);
   if (maxDelaySamples < 1)
     maxDelaySamples = 1;
-  buffer.assign(static_cast<size_t>(maxDelaySamples), 0.0f);
+  buffer.assign(static_cast<size_t>(maxDelaySamples), Sample(0));
+  idle = true;
+  quietRun = 0;
   if (delaySamples >= maxDelaySamples)
     delaySamples = maxDelaySamples - 1;
   if (delaySamples < 1)
@@ -125,17 +151,26 @@ void TempoDelay::setEnabled(bool on) { enabled = on; }
 
 bool TempoDelay::isEnabled() const { return enabled; }
 
+bool TempoDelay::isIdle() const { return idle; }
+
 float TempoDelay::process(float input) {
   if (!enabled || buffer.empty()) {
     return input;
   }
+  idle = false;
+  quietRun = 0;
 
   int readIndex = writeIndex - delaySamples;
   if (readIndex < 0)
     readIndex += maxDelaySamples;
 
+#if MINIACID_FIXED_POINT
+  float delayed = fixedToFloat<kSampleFracBits>(buffer[readIndex]);
+  buffer[writeIndex] = saturateToInt16(floatToFixed<kSampleFracBits>(input + delayed * feedback));
+#else
   float delayed = buffer[readIndex];
   buffer[writeIndex] = input + delayed * feedback;
+#endif
 
   writeIndex++;
   if (writeIndex >= maxDelaySamples)
@@ -144,17 +179,88 @@ float TempoDelay::process(float input) {
   return input + delayed * mix;
 }
 
+void TempoDelay::process(float* samples, size_t numSamples) {
+  if (!enabled || buffer.empty()) {
+    return;
+  }
+  if (idle) {
+    // Nothing to echo; stay asleep until the input makes a sound.
+    size_t i = 0;
+    while (i < numSamples && fabsf(samples[i]) <= kSilenceThreshold)
+      ++i;
+    if (i == numSamples)
+      return;
+    idle = false;
+    quietRun = 0;
+  }
+
+  Sample* line = buffer.data();
+  int quiet = quietRun;
+#if MINIACID_FIXED_POINT
+  const int32_t feedbackQ15 = floatToQ15(feedback);
+  const float wetGain = fixedToFloat<kSampleFracBits>(1) * mix;
+#endif
+  for (size_t i = 0; i < numSamples; ++i) {
+    int readIndex = writeIndex - delaySamples;
+    if (readIndex < 0)
+      readIndex += maxDelaySamples;
+
+    float input = samples[i];
+#if MINIACID_FIXED_POINT
+    // The feedback loop stays in integers; a zero line sample is silence.
+    int32_t delayed = line[readIndex];
+    int32_t written = floatToFixed<kSampleFracBits>(input) + mulQ15(delayed, feedbackQ15);
+    line[writeIndex] = saturateToInt16(written);
+    quiet = written == 0 ? quiet + 1 : 0;
+    float wet = static_cast<float>(delayed) * wetGain;
+#else
+    float delayed = line[readIndex];
+    float written = input + delayed * feedback;
+    line[writeIndex] = written;
+    quiet = fabsf(written) <= kSilenceThreshold ? quiet + 1 : 0;
+    float wet = delayed * mix;
+#endif
+
+    writeIndex++;
+    if (writeIndex >= maxDelaySamples)
+      writeIndex = 0;
+
+    samples[i] = input + wet;
+  }
+  // Once the whole line has been rewritten with near-silence the tail is
+  // over; only the delay length is ever read, but the line may grow with bpm.
+  quietRun = quiet;
+  if (quietRun >= maxDelaySamples)
+    idle = true;
+}
+
 MiniAcid::MiniAcid(float sampleRate, SceneStorage* sceneStorage)
-  : voice303(sampleRate),
-    voice3032(sampleRate),
-    drums(std::make_unique<TR808DrumSynthVoice>(sampleRate)),
-    // drums(std::make_unique<TR909DrumSynthVoice>(sampleRate)),
+  : drums808_(sampleRate),
+    drums909_(sampleRate),
+    drums606_(sampleRate),
+    drums(&drums808_),
+    pendingDrums_(nullptr),
+    drumFades_{},
+    drumRiseRemaining_(0),
+    drumRiseStep_(0.0f),
+    drumFadeMs_(120.0f),
+    drumFadeSamples_(0),
+    drumHitScratch808_(sampleRate),
+    drumHitScratch909_(sampleRate),
+    drumHitScratch606_(sampleRate),
     sampleRateValue(sampleRate),
-    drumEngineName_("808"),
+    drumEngineIndex_(0),
     sceneStorage_(sceneStorage),
+    postedCommands_(0),
+    droppedCommands_(0),
+    appliedCommands_(0),
+    renderSplit_(nullptr),
+    renderPool_(nullptr),
+    helperSamples_(0),
+    helperDrumMask_(0),
+    helperSynthMask_(0),
     playing(false),
-    mute303(false),
-    mute303_2(false),
+    mute303_{},
     muteKick(false),
     muteSnare(false),
     muteHat(false),
@@ -163,27 +269,30 @@ MiniAcid::MiniAcid(float sampleRate, SceneStorage* sceneStorage)
     muteHighTom(false),
     muteRim(false),
     muteClap(false),
-    delay303Enabled(false),
-    delay3032Enabled(false),
-    distortion303Enabled(false),
-    distortion3032Enabled(false),
+    delay303Enabled_{},
+    distortion303Enabled_{},
     bpmValue(100.0f),
     currentStepIndex(-1),
     samplesIntoStep(0),
     samplesPerStep(0.0f),
     songMode_(false),
+    tailOnly_(false),
     drumCycleIndex_(0),
     songPlayheadPosition_(0),
     patternModeDrumPatternIndex_(0),
     patternModeDrumBankIndex_(0),
-    patternModeSynthPatternIndex_{0, 0},
-    patternModeSynthBankIndex_{0, 0},
-    delay303(sampleRate),
-    delay3032(sampleRate),
-    distortion303(),
-    distortion3032() {
-  if (sampleRateValue <= 0.0f) sampleRateValue = 44100.0f;
+    patternModeSynthPatternIndex_{},
+    patternModeSynthBankIndex_{} {
+  for (int v = 0; v < NUM_303_VOICES; ++v)
+    extraSynthPatterns_[v] = kEmptySynthPattern;
+  setSampleRate(sampleRate);
   reset();
+  // Labels and ranges never change; parameter303() fills in the values.
+  for (int v = 0; v < NUM_303_VOICES; ++v) {
+    for (int p = 0; p < static_cast<int>(TB303ParamId::Count); ++p)
+      uiParams303_[v][p] = voices303_[v].parameter(static_cast<TB303ParamId>(p));
+  }
+  publishUiState();
 }
 
 
@@ -196,19 +305,25 @@ void MiniAcid::init() {
   loadSceneFromStorage();
   reset();
   applySceneStateFromManager();
+  publishUiState();
 }
 
 void MiniAcid::reset() {
-  voice303.reset();
-  voice3032.reset();
-  // make the second voice have different params
-  voice3032.adjustParameter(TB303ParamId::Cutoff, -3);
-  voice3032.adjustParameter(TB303ParamId::Resonance, -3);
-  voice3032.adjustParameter(TB303ParamId::EnvAmount, -1);
+  for (int v = 0; v < NUM_303_VOICES; ++v) {
+    voices303_[v].reset();
+    // make the other voices have different params
+    if (v > 0) {
+      voices303_[v].adjustParameter(TB303ParamId::Cutoff, -3);
+      voices303_[v].adjustParameter(TB303ParamId::Resonance, -3);
+      voices303_[v].adjustParameter(TB303ParamId::EnvAmount, -1);
+    }
+    mute303_[v] = false;
+    delay303Enabled_[v] = false;
+    distortion303Enabled_[v] = false;
+  }
   drums->reset();
+  drumHits_.stop();
   playing = false;
-  mute303 = false;
-  mute303_2 = false;
   muteKick = false;
   muteSnare = false;
   muteHat = false;
@@ -217,39 +332,30 @@ void MiniAcid::reset() {
   muteHighTom = false;
   muteRim = false;
   muteClap = false;
-  delay303Enabled = false;
-  delay3032Enabled = false;
-  distortion303Enabled = false;
-  distortion3032Enabled = false;
   bpmValue = 100.0f;
   currentStepIndex = -1;
   samplesIntoStep = 0;
   updateSamplesPerStep();
-  delay303.reset();
-  delay303.setBeats(0.5f); // eighth note
-  delay303.setMix(0.25f);
-  delay303.setFeedback(0.35f);
-  delay303.setEnabled(delay303Enabled);
-  delay303.setBpm(bpmValue);
-  delay3032.reset();
-  delay3032.setBeats(0.5f);
-  delay3032.setMix(0.22f);
-  delay3032.setFeedback(0.32f);
-  delay3032.setEnabled(delay3032Enabled);
-  delay3032.setBpm(bpmValue);
-  distortion303.setEnabled(distortion303Enabled);
-  distortion3032.setEnabled(distortion3032Enabled);
-  lastBufferCount = 0;
-  for (int i = 0; i < AUDIO_BUFFER_SAMPLES; ++i) lastBuffer[i] = 0;
+  for (int v = 0; v < NUM_303_VOICES; ++v) {
+    TempoDelay& delay = delays303_[v];
+    delay.reset();
+    delay.setBeats(0.5f); // eighth note
+    delay.setMix(v == 0 ? 0.25f : 0.22f);
+    delay.setFeedback(v == 0 ? 0.35f : 0.32f);
+    delay.setEnabled(delay303Enabled_[v]);
+    delay.setBpm(bpmValue);
+    distortions303_[v].setEnabled(distortion303Enabled_[v]);
+  }
   songMode_ = false;
   songPlayheadPosition_ = 0;
   patternModeDrumPatternIndex_ = 0;
-  patternModeSynthPatternIndex_[0] = 0;
-  patternModeSynthPatternIndex_[1] = 0;
+  for (int v = 0; v < NUM_303_VOICES; ++v)
+    patternModeSynthPatternIndex_[v] = 0;
 }
 
 void MiniAcid::start() {
   playing = true;
+  tailOnly_ = false;
   currentStepIndex = -1;
   samplesIntoStep = static_cast<unsigned long>(samplesPerStep);
   if (songMode_) {
@@ -261,11 +367,13 @@ void MiniAcid::start() {
 
 void MiniAcid::stop() {
   playing = false;
+  tailOnly_ = false;
   currentStepIndex = -1;
   samplesIntoStep = 0;
-  voice303.release();
-  voice3032.release();
+  for (int v = 0; v < NUM_303_VOICES; ++v)
+    voices303_[v].release();
   drums->reset();
+  drumHits_.stop();
   if (songMode_) {
     sceneManager_.setSongPosition(clampSongPosition(songPlayheadPosition_));
   }
@@ -273,45 +381,70 @@ void MiniAcid::stop() {
   saveSceneToStorage();
 }
 
+void MiniAcid::releaseForTail() {
+  if (!playing) return;
+  tailOnly_ = true;
+  for (int v = 0; v < NUM_303_VOICES; ++v)
+    voices303_[v].release();
+}
+
 void MiniAcid::setBpm(float bpm) {
+  if (bpm < 40.0f)
+    bpm = 40.0f;
+  if (bpm > 200.0f)
+    bpm = 200.0f;
   bpmValue = bpm;
-  if (bpmValue < 40.0f)
-    bpmValue = 40.0f;
-  if (bpmValue > 200.0f)
-    bpmValue = 200.0f;
   updateSamplesPerStep();
-  delay303.setBpm(bpmValue);
-  delay3032.setBpm(bpmValue);
+  for (int v = 0; v < NUM_303_VOICES; ++v)
+    delays303_[v].setBpm(bpm);
 }
 
 float MiniAcid::bpm() const { return bpmValue; }
 float MiniAcid::sampleRate() const { return sampleRateValue; }
 
+void MiniAcid::setSampleRate(float sampleRate) {
+  if (sampleRate <= 0.0f) sampleRate = 44100.0f;
+  sampleRateValue = sampleRate;
+  for (int v = 0; v < NUM_303_VOICES; ++v) {
+    voices303_[v].setSampleRate(sampleRateValue);
+    delays303_[v].setSampleRate(sampleRateValue);
+    delays303_[v].setBpm(bpmValue);
+  }
+  DrumSynthVoice* kits[] = {&drums808_, &drums909_, &drums606_,
+                            &drumHitScratch808_, &drumHitScratch909_, &drumHitScratch606_};
+  for (DrumSynthVoice* kit : kits)
+    kit->setSampleRate(sampleRateValue);
+  setDrumEngineCrossfadeMs(drumFadeMs_);
+  stopDrumFades();
+  // Cached hits were rendered at the old rate; rebinding renders them again.
+  drumHits_.stop();
+  bindDrumHitCache();
+  updateSamplesPerStep();
+}
+
+bool MiniAcid::isSupportedSampleRate(int sampleRate) {
+  return tableSampleRateIndex(static_cast<float>(sampleRate)) >= 0;
+}
+
 bool MiniAcid::isPlaying() const { return playing; }
 
 int MiniAcid::currentStep() const { return currentStepIndex; }
 
-int MiniAcid::currentDrumPatternIndex() const {
-  return sceneManager_.getCurrentDrumPatternIndex();
-}
+int MiniAcid::currentDrumPatternIndex() const { return uiState().drumPatternIndex; }
 
 int MiniAcid::current303PatternIndex(int voiceIndex) const {
-  int idx = clamp303Voice(voiceIndex);
-  return sceneManager_.getCurrentSynthPatternIndex(idx);
+  return uiState().synthPatternIndex[clamp303Voice(voiceIndex)];
 }
 
-int MiniAcid::currentDrumBankIndex() const {
-  return sceneManager_.getCurrentBankIndex(0);
-}
+int MiniAcid::currentDrumBankIndex() const { return uiState().drumBankIndex; }
 
 int MiniAcid::current303BankIndex(int voiceIndex) const {
-  int idx = clamp303Voice(voiceIndex);
-  return sceneManager_.getCurrentBankIndex(idx + 1);
+  return uiState().synthBankIndex[clamp303Voice(voiceIndex)];
 }
 
 bool MiniAcid::is303Muted(int voiceIndex) const {
   int idx = clamp303Voice(voiceIndex);
-  return idx == 0 ? mute303 : mute303_2;
+  return mute303_[idx];
 }
 bool MiniAcid::isKickMuted() const { return muteKick; }
 bool MiniAcid::isSnareMuted() const { return muteSnare; }
@@ -323,113 +456,103 @@ bool MiniAcid::isRimMuted() const { return muteRim; }
 bool MiniAcid::isClapMuted() const { return muteClap; }
 bool MiniAcid::is303DelayEnabled(int voiceIndex) const {
   int idx = clamp303Voice(voiceIndex);
-  return idx == 0 ? delay303Enabled : delay3032Enabled;
+  return delay303Enabled_[idx];
 }
 bool MiniAcid::is303DistortionEnabled(int voiceIndex) const {
   int idx = clamp303Voice(voiceIndex);
-  return idx == 0 ? distortion303Enabled : distortion3032Enabled;
+  return distortion303Enabled_[idx];
 }
 const Parameter& MiniAcid::parameter303(TB303ParamId id, int voiceIndex) const {
   int idx = clamp303Voice(voiceIndex);
-  return idx == 0 ? voice303.parameter(id) : voice3032.parameter(id);
+  Parameter& param = uiParams303_[idx][static_cast<int>(id)];
+  param.setValue(uiState().params303[idx][static_cast<int>(id)]);
+  return param;
 }
 const int8_t* MiniAcid::pattern303Steps(int voiceIndex) const {
   int idx = clamp303Voice(voiceIndex);
-  refreshSynthCaches(idx);
+  std::copy_n(uiState().synthNotes[idx], SEQ_STEPS, synthNotesCache_[idx]);
   return synthNotesCache_[idx];
 }
 const bool* MiniAcid::pattern303AccentSteps(int voiceIndex) const {
   int idx = clamp303Voice(voiceIndex);
-  refreshSynthCaches(idx);
+  std::copy_n(uiState().synthAccents[idx], SEQ_STEPS, synthAccentCache_[idx]);
   return synthAccentCache_[idx];
 }
 const bool* MiniAcid::pattern303SlideSteps(int voiceIndex) const {
   int idx = clamp303Voice(voiceIndex);
-  refreshSynthCaches(idx);
+  std::copy_n(uiState().synthSlides[idx], SEQ_STEPS, synthSlideCache_[idx]);
   return synthSlideCache_[idx];
 }
 const bool* MiniAcid::patternKickSteps() const {
-  refreshDrumCache(kDrumKickVoice);
+  std::copy_n(uiState().drumHits[kDrumKickVoice], SEQ_STEPS, drumHitCache_[kDrumKickVoice]);
   return drumHitCache_[kDrumKickVoice];
 }
 const bool* MiniAcid::patternSnareSteps() const {
-  refreshDrumCache(kDrumSnareVoice);
+  std::copy_n(uiState().drumHits[kDrumSnareVoice], SEQ_STEPS, drumHitCache_[kDrumSnareVoice]);
   return drumHitCache_[kDrumSnareVoice];
 }
 const bool* MiniAcid::patternHatSteps() const {
-  refreshDrumCache(kDrumHatVoice);
+  std::copy_n(uiState().drumHits[kDrumHatVoice], SEQ_STEPS, drumHitCache_[kDrumHatVoice]);
   return drumHitCache_[kDrumHatVoice];
 }
 const bool* MiniAcid::patternOpenHatSteps() const {
-  refreshDrumCache(kDrumOpenHatVoice);
+  std::copy_n(uiState().drumHits[kDrumOpenHatVoice], SEQ_STEPS, drumHitCache_[kDrumOpenHatVoice]);
   return drumHitCache_[kDrumOpenHatVoice];
 }
 const bool* MiniAcid::patternMidTomSteps() const {
-  refreshDrumCache(kDrumMidTomVoice);
+  std::copy_n(uiState().drumHits[kDrumMidTomVoice], SEQ_STEPS, drumHitCache_[kDrumMidTomVoice]);
   return drumHitCache_[kDrumMidTomVoice];
 }
 const bool* MiniAcid::patternHighTomSteps() const {
-  refreshDrumCache(kDrumHighTomVoice);
+  std::copy_n(uiState().drumHits[kDrumHighTomVoice], SEQ_STEPS, drumHitCache_[kDrumHighTomVoice]);
   return drumHitCache_[kDrumHighTomVoice];
 }
 const bool* MiniAcid::patternRimSteps() const {
-  refreshDrumCache(kDrumRimVoice);
+  std::copy_n(uiState().drumHits[kDrumRimVoice], SEQ_STEPS, drumHitCache_[kDrumRimVoice]);
   return drumHitCache_[kDrumRimVoice];
 }
 const bool* MiniAcid::patternClapSteps() const {
-  refreshDrumCache(kDrumClapVoice);
+  std::copy_n(uiState().drumHits[kDrumClapVoice], SEQ_STEPS, drumHitCache_[kDrumClapVoice]);
   return drumHitCache_[kDrumClapVoice];
 }
 const bool* MiniAcid::patternDrumAccentSteps() const {
-  int pat = songPatternIndexForTrack(SongTrack::Drums);
-  const DrumPatternSet& set = pat >= 0 ? sceneManager_.getDrumPatternSet(pat)
-                                       : kEmptyDrumPatternSet;
-  for (int i = 0; i < SEQ_STEPS; ++i) {
-    bool accent = false;
-    for (int v = 0; v < DrumPatternSet::kVoices; ++v) {
-      if (set.voices[v].steps[i].accent) {
-        accent = true;
-        break;
-      }
-    }
-    drumStepAccentCache_[i] = accent;
-  }
+  std::copy_n(uiState().drumStepAccents, SEQ_STEPS, drumStepAccentCache_);
   return drumStepAccentCache_;
 }
 const bool* MiniAcid::patternKickAccentSteps() const {
-  refreshDrumCache(kDrumKickVoice);
+  std::copy_n(uiState().drumAccents[kDrumKickVoice], SEQ_STEPS, drumAccentCache_[kDrumKickVoice]);
   return drumAccentCache_[kDrumKickVoice];
 }
 const bool* MiniAcid::patternSnareAccentSteps() const {
-  refreshDrumCache(kDrumSnareVoice);
+  std::copy_n(uiState().drumAccents[kDrumSnareVoice], SEQ_STEPS, drumAccentCache_[kDrumSnareVoice]);
   return drumAccentCache_[kDrumSnareVoice];
 }
 const bool* MiniAcid::patternHatAccentSteps() const {
-  refreshDrumCache(kDrumHatVoice);
+  std::copy_n(uiState().drumAccents[kDrumHatVoice], SEQ_STEPS, drumAccentCache_[kDrumHatVoice]);
   return drumAccentCache_[kDrumHatVoice];
 }
 const bool* MiniAcid::patternOpenHatAccentSteps() const {
-  refreshDrumCache(kDrumOpenHatVoice);
+  std::copy_n(uiState().drumAccents[kDrumOpenHatVoice], SEQ_STEPS, drumAccentCache_[kDrumOpenHatVoice]);
   return drumAccentCache_[kDrumOpenHatVoice];
 }
 const bool* MiniAcid::patternMidTomAccentSteps() const {
-  refreshDrumCache(kDrumMidTomVoice);
+  std::copy_n(uiState().drumAccents[kDrumMidTomVoice], SEQ_STEPS, drumAccentCache_[kDrumMidTomVoice]);
   return drumAccentCache_[kDrumMidTomVoice];
 }
 const bool* MiniAcid::patternHighTomAccentSteps() const {
-  refreshDrumCache(kDrumHighTomVoice);
+  std::copy_n(uiState().drumAccents[kDrumHighTomVoice], SEQ_STEPS, drumAccentCache_[kDrumHighTomVoice]);
   return drumAccentCache_[kDrumHighTomVoice];
 }
 const bool* MiniAcid::patternRimAccentSteps() const {
-  refreshDrumCache(kDrumRimVoice);
+  std::copy_n(uiState().drumAccents[kDrumRimVoice], SEQ_STEPS, drumAccentCache_[kDrumRimVoice]);
   return drumAccentCache_[kDrumRimVoice];
 }
 const bool* MiniAcid::patternClapAccentSteps() const {
-  refreshDrumCache(kDrumClapVoice);
+  std::copy_n(uiState().drumAccents[kDrumClapVoice], SEQ_STEPS, drumAccentCache_[kDrumClapVoice]);
   return drumAccentCache_[kDrumClapVoice];
 }
 
-bool MiniAcid::songModeEnabled() const { return songMode_; }
+bool MiniAcid::songModeEnabled() const { return uiState().songMode; }
 
 void MiniAcid::setSongMode(bool enabled) {
   if (enabled == songMode_) return;
@@ -457,7 +580,7 @@ void MiniAcid::setSongMode(bool enabled) {
 
 void MiniAcid::toggleSongMode() { setSongMode(!songMode_); }
 
-bool MiniAcid::loopModeEnabled() const { return sceneManager_.loopMode(); }
+bool MiniAcid::loopModeEnabled() const { return uiState().loopMode; }
 
 void MiniAcid::setLoopMode(bool enabled) { sceneManager_.setLoopMode(enabled); }
 
@@ -465,15 +588,15 @@ void MiniAcid::setLoopRange(int startRow, int endRow) {
   sceneManager_.setLoopRange(startRow, endRow);
 }
 
-int MiniAcid::loopStartRow() const { return sceneManager_.loopStartRow(); }
+int MiniAcid::loopStartRow() const { return uiState().loopStartRow; }
 
-int MiniAcid::loopEndRow() const { return sceneManager_.loopEndRow(); }
+int MiniAcid::loopEndRow() const { return uiState().loopEndRow; }
 
-int MiniAcid::songLength() const { return sceneManager_.songLength(); }
+int MiniAcid::songLength() const { return uiState().songLength; }
 
-int MiniAcid::currentSongPosition() const { return sceneManager_.getSongPosition(); }
+int MiniAcid::currentSongPosition() const { return uiState().songPosition; }
 
-int MiniAcid::songPlayheadPosition() const { return songPlayheadPosition_; }
+int MiniAcid::songPlayheadPosition() const { return uiState().songPlayheadPosition; }
 
 void MiniAcid::setSongPosition(int position) {
   int pos = clampSongPosition(position);
@@ -484,7 +607,7 @@ void MiniAcid::setSongPosition(int position) {
 
 void MiniAcid::setSongPattern(int position, SongTrack track, int patternIndex) {
   sceneManager_.setSongPattern(position, track, patternIndex);
-  if (songMode_ && position == currentSongPosition()) {
+  if (songMode_ && position == sceneManager_.getSongPosition()) {
     applySongPositionSelection();
   }
 }
@@ -499,70 +622,140 @@ void MiniAcid::clearSongPattern(int position, SongTrack track) {
 }
 
 int MiniAcid::songPatternAt(int position, SongTrack track) const {
-  return sceneManager_.songPattern(position, track);
+  int trackIdx = static_cast<int>(track);
+  if (position < 0 || position >= Song::kMaxPositions) return -1;
+  if (trackIdx < 0 || trackIdx >= SongPosition::kTrackCount) return -1;
+  return uiState().songPatterns[position][trackIdx];
 }
 
-const Song& MiniAcid::song() const { return sceneManager_.song(); }
+const Song& MiniAcid::song() const {
+  uiSong_ = uiState().song;
+  return uiSong_;
+}
 
 int MiniAcid::display303PatternIndex(int voiceIndex) const {
-  int idx = clamp303Voice(voiceIndex);
-  if (songMode_) {
-    int combined = sceneManager_.songPattern(sceneManager_.getSongPosition(),
-                                             idx == 0 ? SongTrack::SynthA : SongTrack::SynthB);
-    if (combined < 0) return -1;
-    return songPatternIndexInBank(combined);
-  }
-  return sceneManager_.getCurrentSynthPatternIndex(idx);
+  return uiState().displaySynthPatternIndex[clamp303Voice(voiceIndex)];
 }
 
-int MiniAcid::displayDrumPatternIndex() const {
-  if (songMode_) {
-    int combined = sceneManager_.songPattern(sceneManager_.getSongPosition(), SongTrack::Drums);
-    if (combined < 0) return -1;
-    return songPatternIndexInBank(combined);
-  }
-  return sceneManager_.getCurrentDrumPatternIndex();
-}
+int MiniAcid::displayDrumPatternIndex() const { return uiState().displayDrumPatternIndex; }
 
 std::vector<std::string> MiniAcid::getAvailableDrumEngines() const {
-  return {"808", "909", "606"};
+  return std::vector<std::string>(kDrumEngineNames, kDrumEngineNames + kDrumEngineCount);
 }
 
 void MiniAcid::setDrumEngine(const std::string& engineName) {
   std::string name = toLowerCopy(engineName);
-  if (name.find("909") != std::string::npos) {
-    drums = std::make_unique<TR909DrumSynthVoice>(sampleRateValue);
-    drumEngineName_ = "909";
-  } else if (name.find("606") != std::string::npos) {
-    drums = std::make_unique<TR606DrumSynthVoice>(sampleRateValue);
-    drumEngineName_ = "606";
-  } else if (name.find("808") != std::string::npos) {
-    drums = std::make_unique<TR808DrumSynthVoice>(sampleRateValue);
-    drumEngineName_ = "808";
-  } else {
+  for (int i = 0; i < kDrumEngineCount; ++i) {
+    if (name.find(kDrumEngineNames[i]) != std::string::npos) {
+      setDrumEngineIndex(i);
+      return;
+    }
+  }
+}
+
+void MiniAcid::setDrumEngineIndex(int engineIndex) {
+  if (engineIndex < 0 || engineIndex >= kDrumEngineCount) return;
+  DrumSynthVoice* const kits[] = {&drums808_, &drums909_, &drums606_};
+  drumEngineIndex_ = engineIndex;
+  pendingDrums_.store(kits[engineIndex], std::memory_order_release);
+}
+
+void MiniAcid::setDrumEngineCrossfadeMs(float ms) {
+  if (ms < 0.0f) ms = 0.0f;
+  drumFadeMs_ = ms;
+  drumFadeSamples_ = static_cast<size_t>(ms * 0.001f * sampleRateValue);
+}
+
+void MiniAcid::applyPendingDrumEngine(bool crossfade) {
+  DrumSynthVoice* next = pendingDrums_.exchange(nullptr, std::memory_order_acquire);
+  if (!next || next == drums)
+    return;
+  if (!crossfade || drumFadeSamples_ == 0) {
+    stopDrumFades();
+    drums = next;
+    drums->reset();
+    bindDrumHitCache();
     return;
   }
-  drums->reset();
+
+  // The outgoing kit fades from wherever its own rise had got to.
+  float gain = 1.0f - static_cast<float>(drumRiseRemaining_) * drumRiseStep_;
+  DrumFade outgoing = {drums, static_cast<size_t>(gain * static_cast<float>(drumFadeSamples_)),
+                       1.0f / static_cast<float>(drumFadeSamples_)};
+  drumRiseRemaining_ = 0;
+
+  // A kit still fading keeps its tails: take it out of its slot and bring
+  // it back up at the rate it was going down, rather than resetting it.
+  bool resumed = false;
+  for (DrumFade& fade : drumFades_) {
+    if (fade.kit != next) continue;
+    drumRiseStep_ = fade.gainStep;
+    drumRiseRemaining_ = static_cast<size_t>((1.0f - static_cast<float>(fade.remaining) * fade.gainStep) /
+                                             fade.gainStep);
+    fade.kit = nullptr;
+    resumed = true;
+  }
+  // With three kits, the other slot is free or holds the kit not involved.
+  for (DrumFade& fade : drumFades_) {
+    if (fade.kit || outgoing.remaining == 0) continue;
+    fade = outgoing;
+    break;
+  }
+  drums = next;
+  if (!resumed)
+    drums->reset();
+  bindDrumHitCache();
+}
+
+void MiniAcid::stopDrumFades() {
+  for (DrumFade& fade : drumFades_) fade.kit = nullptr;
+  drumRiseRemaining_ = 0;
+}
+
+bool MiniAcid::enableDrumHitCache(size_t maxSamples, int takes) {
+  return drumHits_.configure(maxSamples, takes);
+}
+
+void MiniAcid::set303Oversampling(int factor) {
+  for (int v = 0; v < NUM_303_VOICES; ++v) {
+    voices303_[v].setOversampling(factor);
+    distortions303_[v].setOversampling(factor);
+  }
+}
+
+int MiniAcid::oversampling303() const {
+  return voices303_[0].oversampling();
+}
+
+void MiniAcid::bindDrumHitCache() {
+  DrumSynthVoice* scratch = &drumHitScratch808_;
+  if (drums == &drums909_) scratch = &drumHitScratch909_;
+  else if (drums == &drums606_) scratch = &drumHitScratch606_;
+  drumHits_.bind(drums, scratch);
+}
+
+void MiniAcid::triggerDrum(DrumVoiceId id, bool accent) {
+  // A ringing live open hat only gets choked by a live closed hat.
+  bool chokesLive = id == DrumVoiceId::Hat &&
+                    (drums->activeVoiceMask() & drumVoiceBit(DrumVoiceId::OpenHat));
+  if (!chokesLive && drumHits_.trigger(id, accent))
+    return;
+  drumHits_.cut(id);
+  drums->trigger(id, accent);
 }
 
 std::string MiniAcid::currentDrumEngineName() const {
-  return drumEngineName_;
+  return kDrumEngineNames[uiState().drumEngine];
 }
 
 size_t MiniAcid::copyLastAudio(int16_t *dst, size_t maxSamples) const {
   if (!dst || maxSamples == 0) return 0;
-  size_t n = lastBufferCount;
-  if (n > maxSamples) n = maxSamples;
-  for (size_t i = 0; i < n; ++i) dst[i] = lastBuffer[i];
-  return n;
+  return scope_.copyRecent(dst, maxSamples);
 }
 
 void MiniAcid::toggleMute303(int voiceIndex) {
   int idx = clamp303Voice(voiceIndex);
-  if (idx == 0)
-    mute303 = !mute303;
-  else
-    mute303_2 = !mute303_2;
+  mute303_[idx] = !mute303_[idx];
 }
 void MiniAcid::toggleMuteKick() { muteKick = !muteKick; }
 void MiniAcid::toggleMuteSnare() { muteSnare = !muteSnare; }
@@ -574,23 +767,23 @@ void MiniAcid::toggleMuteRim() { muteRim = !muteRim; }
 void MiniAcid::toggleMuteClap() { muteClap = !muteClap; }
 void MiniAcid::toggleDelay303(int voiceIndex) {
   int idx = clamp303Voice(voiceIndex);
-  if (idx == 0) {
-    delay303Enabled = !delay303Enabled;
-    delay303.setEnabled(delay303Enabled);
-  } else {
-    delay3032Enabled = !delay3032Enabled;
-    delay3032.setEnabled(delay3032Enabled);
-  }
+  delay303Enabled_[idx] = !delay303Enabled_[idx];
+  delays303_[idx].setEnabled(delay303Enabled_[idx]);
 }
 void MiniAcid::toggleDistortion303(int voiceIndex) {
   int idx = clamp303Voice(voiceIndex);
-  if (idx == 0) {
-    distortion303Enabled = !distortion303Enabled;
-    distortion303.setEnabled(distortion303Enabled);
-  } else {
-    distortion3032Enabled = !distortion3032Enabled;
-    distortion3032.setEnabled(distortion3032Enabled);
-  }
+  distortion303Enabled_[idx] = !distortion303Enabled_[idx];
+  distortions303_[idx].setEnabled(distortion303Enabled_[idx]);
+}
+void MiniAcid::setDelay303Enabled(int voiceIndex, bool enabled) {
+  int idx = clamp303Voice(voiceIndex);
+  delay303Enabled_[idx] = enabled;
+  delays303_[idx].setEnabled(enabled);
+}
+void MiniAcid::setDistortion303Enabled(int voiceIndex, bool enabled) {
+  int idx = clamp303Voice(voiceIndex);
+  distortion303Enabled_[idx] = enabled;
+  distortions303_[idx].setEnabled(enabled);
 }
 
 void MiniAcid::setDrumPatternIndex(int patternIndex) {
@@ -611,24 +804,20 @@ void MiniAcid::setDrumBankIndex(int bankIndex) {
 
 void MiniAcid::adjust303Parameter(TB303ParamId id, int steps, int voiceIndex) {
   int idx = clamp303Voice(voiceIndex);
-  if (idx == 0)
-    voice303.adjustParameter(id, steps);
-  else
-    voice3032.adjustParameter(id, steps);
+  voices303_[idx].adjustParameter(id, steps);
 }
 void MiniAcid::set303Parameter(TB303ParamId id, float value, int voiceIndex) {
   int idx = clamp303Voice(voiceIndex);
-  if (idx == 0)
-    voice303.setParameter(id, value);
-  else
-    voice3032.setParameter(id, value);
+  voices303_[idx].setParameter(id, value);
 }
 void MiniAcid::set303PatternIndex(int voiceIndex, int patternIndex) {
   int idx = clamp303Voice(voiceIndex);
+  if (!isScene303Voice(idx)) return;
   sceneManager_.setCurrentSynthPatternIndex(idx, patternIndex);
 }
 void MiniAcid::shift303PatternIndex(int voiceIndex, int delta) {
   int idx = clamp303Voice(voiceIndex);
+  if (!isScene303Voice(idx)) return;
   int current = sceneManager_.getCurrentSynthPatternIndex(idx);
   int next = current + delta;
   if (next < 0) next = Bank<SynthPattern>::kPatterns - 1;
@@ -638,6 +827,7 @@ void MiniAcid::shift303PatternIndex(int voiceIndex, int delta) {
 
 void MiniAcid::set303BankIndex(int voiceIndex, int bankIndex) {
   int idx = clamp303Voice(voiceIndex);
+  if (!isScene303Voice(idx)) return;
   sceneManager_.setCurrentBankIndex(idx + 1, bankIndex);
 }
 void MiniAcid::adjust303StepNote(int voiceIndex, int stepIndex, int semitoneDelta) {
@@ -666,18 +856,36 @@ void MiniAcid::clear303StepNote(int voiceIndex, int stepIndex) {
   SynthPattern& pattern = editSynthPattern(idx);
   pattern.steps[step].note = -1;
 }
+void MiniAcid::set303StepNote(int voiceIndex, int stepIndex, int note) {
+  int idx = clamp303Voice(voiceIndex);
+  int step = clamp303Step(stepIndex);
+  SynthPattern& pattern = editSynthPattern(idx);
+  pattern.steps[step].note = static_cast<int8_t>(note < 0 ? -1 : clamp303Note(note));
+}
 void MiniAcid::toggle303AccentStep(int voiceIndex, int stepIndex) {
   int idx = clamp303Voice(voiceIndex);
   int step = clamp303Step(stepIndex);
   SynthPattern& pattern = editSynthPattern(idx);
   pattern.steps[step].accent = !pattern.steps[step].accent;
 }
+void MiniAcid::set303AccentStep(int voiceIndex, int stepIndex, bool accent) {
+  int idx = clamp303Voice(voiceIndex);
+  int step = clamp303Step(stepIndex);
+  SynthPattern& pattern = editSynthPattern(idx);
+  pattern.steps[step].accent = accent;
+}
 void MiniAcid::toggle303SlideStep(int voiceIndex, int stepIndex) {
   int idx = clamp303Voice(voiceIndex);
   int step = clamp303Step(stepIndex);
   SynthPattern& pattern = editSynthPattern(idx);
   pattern.steps[step].slide = !pattern.steps[step].slide;
 }
+void MiniAcid::set303SlideStep(int voiceIndex, int stepIndex, bool slide) {
+  int idx = clamp303Voice(voiceIndex);
+  int step = clamp303Step(stepIndex);
+  SynthPattern& pattern = editSynthPattern(idx);
+  pattern.steps[step].slide = slide;
+}
 
 void MiniAcid::toggleDrumStep(int voiceIndex, int stepIndex) {
   int voice = clampDrumVoice(voiceIndex);
@@ -688,6 +896,15 @@ void MiniAcid::toggleDrumStep(int voiceIndex, int stepIndex) {
   pattern.steps[step].hit = !pattern.steps[step].hit;
 }
 
+void MiniAcid::setDrumStep(int voiceIndex, int stepIndex, bool hit) {
+  int voice = clampDrumVoice(voiceIndex);
+  int step = stepIndex;
+  if (step < 0) step = 0;
+  if (step >= DrumPattern::kSteps) step = DrumPattern::kSteps - 1;
+  DrumPattern& pattern = editDrumPattern(voice);
+  pattern.steps[step].hit = hit;
+}
+
 void MiniAcid::toggleDrumAccentStep(int stepIndex) {
   int step = stepIndex;
   if (step < 0) step = 0;
@@ -715,11 +932,189 @@ void MiniAcid::setDrumAccentStep(int voiceIndex, int stepIndex, bool accent) {
   pattern.steps[step].accent = accent;
 }
 
+bool MiniAcid::post(const EngineCommand& cmd) {
+  if (!commands_.push(cmd)) {
+    ++droppedCommands_;
+    return false;
+  }
+  ++postedCommands_;
+  return true;
+}
+
+uint32_t MiniAcid::lastPostedCommand() const { return postedCommands_; }
+
+bool MiniAcid::commandApplied(uint32_t sequence) const {
+  // Wrap-safe "applied >= sequence".
+  return static_cast<int32_t>(uiState().appliedCommands - sequence) >= 0;
+}
+
+uint32_t MiniAcid::droppedCommandCount() const { return droppedCommands_; }
+
+void MiniAcid::processCommands() {
+  drainCommands();
+  publishUiState();
+}
+
+void MiniAcid::drainCommands() {
+  EngineCommand cmd;
+  while (commands_.pop(cmd)) {
+    applyCommand(cmd);
+    ++appliedCommands_;
+  }
+}
+
+void MiniAcid::applyCommand(const EngineCommand& cmd) {
+  switch (cmd.type) {
+    case EngineCommandType::ToggleMute303:
+      toggleMute303(cmd.voice);
+      break;
+    case EngineCommandType::ToggleMuteDrum:
+      switch (static_cast<DrumVoiceId>(cmd.voice)) {
+        case DrumVoiceId::Kick: toggleMuteKick(); break;
+        case DrumVoiceId::Snare: toggleMuteSnare(); break;
+        case DrumVoiceId::Hat: toggleMuteHat(); break;
+        case DrumVoiceId::OpenHat: toggleMuteOpenHat(); break;
+        case DrumVoiceId::MidTom: toggleMuteMidTom(); break;
+        case DrumVoiceId::HighTom: toggleMuteHighTom(); break;
+        case DrumVoiceId::Rim: toggleMuteRim(); break;
+        case DrumVoiceId::Clap: toggleMuteClap(); break;
+        default: break;
+      }
+      break;
+    case EngineCommandType::ToggleDelay303:
+      toggleDelay303(cmd.voice);
+      break;
+    case EngineCommandType::ToggleDistortion303:
+      toggleDistortion303(cmd.voice);
+      break;
+    case EngineCommandType::SetDelay303Enabled:
+      setDelay303Enabled(cmd.voice, cmd.arg != 0);
+      break;
+    case EngineCommandType::SetDistortion303Enabled:
+      setDistortion303Enabled(cmd.voice, cmd.arg != 0);
+      break;
+    case EngineCommandType::SetBpm:
+      setBpm(cmd.value);
+      break;
+    case EngineCommandType::SetDrumEngineCrossfadeMs:
+      setDrumEngineCrossfadeMs(cmd.value);
+      break;
+    case EngineCommandType::SetDrumEngine:
+      setDrumEngineIndex(cmd.index);
+      break;
+    case EngineCommandType::SetParameter:
+      if (cmd.index >= 0 && cmd.index < static_cast<int>(MiniAcidParamId::Count))
+        setParameter(static_cast<MiniAcidParamId>(cmd.index), cmd.value);
+      break;
+    case EngineCommandType::AdjustParameter:
+      if (cmd.index >= 0 && cmd.index < static_cast<int>(MiniAcidParamId::Count))
+        adjustParameter(static_cast<MiniAcidParamId>(cmd.index), static_cast<int>(cmd.value));
+      break;
+    case EngineCommandType::Set303Parameter:
+      if (cmd.index >= 0 && cmd.index < static_cast<int>(TB303ParamId::Count))
+        set303Parameter(static_cast<TB303ParamId>(cmd.index), cmd.value, cmd.voice);
+      break;
+    case EngineCommandType::Adjust303Parameter:
+      if (cmd.index >= 0 && cmd.index < static_cast<int>(TB303ParamId::Count))
+        adjust303Parameter(static_cast<TB303ParamId>(cmd.index), static_cast<int>(cmd.value), cmd.voice);
+      break;
+    case EngineCommandType::SetDrumPatternIndex:
+      setDrumPatternIndex(cmd.index);
+      break;
+    case EngineCommandType::SetDrumBankIndex:
+      setDrumBankIndex(cmd.index);
+      break;
+    case EngineCommandType::Set303PatternIndex:
+      set303PatternIndex(cmd.voice, cmd.index);
+      break;
+    case EngineCommandType::Set303BankIndex:
+      set303BankIndex(cmd.voice, cmd.index);
+      break;
+    case EngineCommandType::Adjust303StepNote:
+      adjust303StepNote(cmd.voice, cmd.index, static_cast<int>(cmd.value));
+      break;
+    case EngineCommandType::Adjust303StepOctave:
+      adjust303StepOctave(cmd.voice, cmd.index, static_cast<int>(cmd.value));
+      break;
+    case EngineCommandType::Clear303StepNote:
+      clear303StepNote(cmd.voice, cmd.index);
+      break;
+    case EngineCommandType::Set303StepNote:
+      set303StepNote(cmd.voice, cmd.index, cmd.arg);
+      break;
+    case EngineCommandType::Toggle303AccentStep:
+      toggle303AccentStep(cmd.voice, cmd.index);
+      break;
+    case EngineCommandType::Set303AccentStep:
+      set303AccentStep(cmd.voice, cmd.index, cmd.arg != 0);
+      break;
+    case EngineCommandType::Toggle303SlideStep:
+      toggle303SlideStep(cmd.voice, cmd.index);
+      break;
+    case EngineCommandType::Set303SlideStep:
+      set303SlideStep(cmd.voice, cmd.index, cmd.arg != 0);
+      break;
+    case EngineCommandType::ToggleDrumStep:
+      toggleDrumStep(cmd.voice, cmd.index);
+      break;
+    case EngineCommandType::SetDrumStep:
+      setDrumStep(cmd.voice, cmd.index, cmd.arg != 0);
+      break;
+    case EngineCommandType::ToggleDrumAccentStep:
+      toggleDrumAccentStep(cmd.index);
+      break;
+    case EngineCommandType::SetDrumAccentStep:
+      setDrumAccentStep(cmd.voice, cmd.index, cmd.arg != 0);
+      break;
+    case EngineCommandType::Randomize303Pattern:
+      randomize303Pattern(cmd.voice);
+      break;
+    case EngineCommandType::RandomizeDrumPattern:
+      randomizeDrumPattern();
+      break;
+    case EngineCommandType::ToggleSongMode:
+      toggleSongMode();
+      break;
+    case EngineCommandType::SetLoopMode:
+      setLoopMode(cmd.arg != 0);
+      break;
+    case EngineCommandType::SetLoopRange:
+      setLoopRange(cmd.index, cmd.arg);
+      break;
+    case EngineCommandType::SetSongPosition:
+      setSongPosition(cmd.index);
+      break;
+    case EngineCommandType::SetSongPattern:
+      setSongPattern(cmd.index, static_cast<SongTrack>(cmd.voice), cmd.arg);
+      break;
+    case EngineCommandType::ClearSongPattern:
+      clearSongPattern(cmd.index, static_cast<SongTrack>(cmd.voice));
+      break;
+  }
+}
+
 int MiniAcid::clamp303Voice(int voiceIndex) const {
   if (voiceIndex < 0) return 0;
   if (voiceIndex >= NUM_303_VOICES) return NUM_303_VOICES - 1;
   return voiceIndex;
 }
+uint32_t MiniAcid::active303VoiceMask() const {
+  uint32_t mask = 0;
+  for (int v = 0; v < NUM_303_VOICES; ++v) {
+    bool voiceAudible = !mute303_[v] && voices303_[v].isActive();
+    bool delayRinging = delays303_[v].isEnabled() && !delays303_[v].isIdle();
+    if (voiceAudible || delayRinging)
+      mask |= 1u << v;
+  }
+  return mask;
+}
+
+bool MiniAcid::isScene303Voice(int voiceIndex) const {
+  return voiceIndex < NUM_SCENE_303_VOICES;
+}
+SongTrack MiniAcid::synthTrack(int voiceIndex) const {
+  return voiceIndex == 0 ? SongTrack::SynthA : SongTrack::SynthB;
+}
 int MiniAcid::clampDrumVoice(int voiceIndex) const {
   if (voiceIndex < 0) return 0;
   if (voiceIndex >= NUM_DRUM_VOICES) return NUM_DRUM_VOICES - 1;
@@ -738,11 +1133,13 @@ int MiniAcid::clamp303Note(int note) const {
 
 const SynthPattern& MiniAcid::synthPattern(int synthIndex) const {
   int idx = clamp303Voice(synthIndex);
+  if (!isScene303Voice(idx)) return extraSynthPatterns_[idx];
   return sceneManager_.getCurrentSynthPattern(idx);
 }
 
 SynthPattern& MiniAcid::editSynthPattern(int synthIndex) {
   int idx = clamp303Voice(synthIndex);
+  if (!isScene303Voice(idx)) return extraSynthPatterns_[idx];
   return sceneManager_.editCurrentSynthPattern(idx);
 }
 
@@ -779,8 +1176,8 @@ int MiniAcid::songPatternIndexForTrack(SongTrack track) const {
 
 const SynthPattern& MiniAcid::activeSynthPattern(int synthIndex) const {
   int idx = clamp303Voice(synthIndex);
-  SongTrack track = idx == 0 ? SongTrack::SynthA : SongTrack::SynthB;
-  int pat = songPatternIndexForTrack(track);
+  if (!isScene303Voice(idx)) return extraSynthPatterns_[idx];
+  int pat = songPatternIndexForTrack(synthTrack(idx));
   if (pat < 0) return kEmptySynthPattern;
   return sceneManager_.getSynthPattern(idx, pat);
 }
@@ -877,89 +1274,123 @@ void MiniAcid::advanceSongPlayhead() {
   applySongPositionSelection();
 }
 
-void MiniAcid::refreshSynthCaches(int synthIndex) const {
-  int idx = clamp303Voice(synthIndex);
-  const SynthPattern& pattern = activeSynthPattern(idx);
-  for (int i = 0; i < SEQ_STEPS; ++i) {
-    synthNotesCache_[idx][i] = static_cast<int8_t>(pattern.steps[i].note);
-    synthAccentCache_[idx][i] = pattern.steps[i].accent;
-    synthSlideCache_[idx][i] = pattern.steps[i].slide;
+void MiniAcid::publishUiState() {
+  EngineUiState& ui = uiState_.writeSlot();
+  ui.songMode = songMode_;
+  ui.drumEngine = drumEngineIndex_;
+  ui.loopMode = sceneManager_.loopMode();
+  ui.loopStartRow = sceneManager_.loopStartRow();
+  ui.loopEndRow = sceneManager_.loopEndRow();
+  ui.songLength = sceneManager_.songLength();
+  ui.songPosition = sceneManager_.getSongPosition();
+  ui.songPlayheadPosition = songPlayheadPosition_;
+  ui.appliedCommands = appliedCommands_;
+  ui.drumPatternIndex = sceneManager_.getCurrentDrumPatternIndex();
+  ui.drumBankIndex = sceneManager_.getCurrentBankIndex(0);
+  ui.displayDrumPatternIndex = ui.drumPatternIndex;
+  if (songMode_) {
+    int combined = sceneManager_.songPattern(ui.songPosition, SongTrack::Drums);
+    ui.displayDrumPatternIndex = combined < 0 ? -1 : songPatternIndexInBank(combined);
   }
-}
 
-void MiniAcid::refreshDrumCache(int drumVoiceIndex) const {
-  int idx = clampDrumVoice(drumVoiceIndex);
-  const DrumPattern& pattern = activeDrumPattern(idx);
-  for (int i = 0; i < SEQ_STEPS; ++i) {
-    drumHitCache_[idx][i] = pattern.steps[i].hit;
-    drumAccentCache_[idx][i] = pattern.steps[i].accent && pattern.steps[i].hit;
+  for (int v = 0; v < NUM_303_VOICES; ++v) {
+    bool scene = isScene303Voice(v);
+    ui.synthPatternIndex[v] = scene ? sceneManager_.getCurrentSynthPatternIndex(v) : 0;
+    ui.synthBankIndex[v] = scene ? sceneManager_.getCurrentBankIndex(v + 1) : 0;
+    ui.displaySynthPatternIndex[v] = ui.synthPatternIndex[v];
+    if (scene && songMode_) {
+      int combined = sceneManager_.songPattern(ui.songPosition, synthTrack(v));
+      ui.displaySynthPatternIndex[v] = combined < 0 ? -1 : songPatternIndexInBank(combined);
+    }
+    const SynthPattern& pattern = activeSynthPattern(v);
+    for (int i = 0; i < SEQ_STEPS; ++i) {
+      ui.synthNotes[v][i] = static_cast<int8_t>(pattern.steps[i].note);
+      ui.synthAccents[v][i] = pattern.steps[i].accent;
+      ui.synthSlides[v][i] = pattern.steps[i].slide;
+    }
+    for (int p = 0; p < static_cast<int>(TB303ParamId::Count); ++p)
+      ui.params303[v][p] = voices303_[v].parameter(static_cast<TB303ParamId>(p)).value();
+  }
+
+  for (int i = 0; i < SEQ_STEPS; ++i) ui.drumStepAccents[i] = false;
+  for (int d = 0; d < NUM_DRUM_VOICES; ++d) {
+    const DrumPattern& pattern = activeDrumPattern(d);
+    for (int i = 0; i < SEQ_STEPS; ++i) {
+      ui.drumHits[d][i] = pattern.steps[i].hit;
+      ui.drumAccents[d][i] = pattern.steps[i].accent && pattern.steps[i].hit;
+      if (pattern.steps[i].accent) ui.drumStepAccents[i] = true;
+    }
+  }
+
+  for (int pos = 0; pos < Song::kMaxPositions; ++pos) {
+    for (int t = 0; t < SongPosition::kTrackCount; ++t)
+      ui.songPatterns[pos][t] =
+        static_cast<int8_t>(sceneManager_.songPattern(pos, static_cast<SongTrack>(t)));
   }
+  ui.song = sceneManager_.song();
+  uiState_.publish();
+}
+
+const EngineUiState& MiniAcid::uiState() const {
+  uiState_.update();
+  return uiState_.readSlot();
 }
 
 void MiniAcid::updateSamplesPerStep() {
   samplesPerStep = sampleRateValue * 60.0f / (bpmValue * 4.0f);
 }
 
+unsigned long MiniAcid::stepLengthSamples() const {
+  unsigned long stepLength = static_cast<unsigned long>(samplesPerStep);
+  return stepLength < 1 ? 1 : stepLength;
+}
+
+unsigned long MiniAcid::samplesUntilNextStep() const {
+  unsigned long stepLength = stepLengthSamples();
+  if (samplesIntoStep >= stepLength) return 0;
+  return stepLength - samplesIntoStep;
+}
+
 float MiniAcid::noteToFreq(int note) {
-  return 440.0f * powf(2.0f, (note - 69) / 12.0f);
+  return noteFrequency(note);
 }
 
 void MiniAcid::advanceStep() {
   int prevStep = currentStepIndex;
-  currentStepIndex = (currentStepIndex + 1) % SEQ_STEPS;
+  int stepIndex = (prevStep + 1) % SEQ_STEPS;
+  currentStepIndex = stepIndex;
+  applyPendingDrumEngine(true);
 
   if (songMode_) {
     if (prevStep < 0) {
       songPlayheadPosition_ = clampSongPosition(sceneManager_.getSongPosition());
       sceneManager_.setSongPosition(songPlayheadPosition_);
       applySongPositionSelection();
-    } else if (currentStepIndex == 0) {
+    } else if (stepIndex == 0) {
       advanceSongPlayhead();
     }
   }
 
   // DEBUG: toggle drum kit every measure for testing
   /*
-  if (prevStep >= 0 && currentStepIndex == 0) {
+  if (prevStep >= 0 && stepIndex == 0) {
     drumCycleIndex_ = (drumCycleIndex_ + 1) % 3;
-    if (drumCycleIndex_ == 0) {
-      drums = std::make_unique<TR808DrumSynthVoice>(sampleRateValue);
-      // printf("Switched to TR-808 drum kit\n");
-    } else if (drumCycleIndex_ == 1) {
-      drums = std::make_unique<TR909DrumSynthVoice>(sampleRateValue);
-      // printf("Switched to TR-909 drum kit\n");
-    } else {
-      drums = std::make_unique<TR606DrumSynthVoice>(sampleRateValue);
-      // printf("Switched to TR-606 drum kit\n");
-    }
+    const char* const kCycle[] = {"808", "909", "606"};
+    setDrumEngine(kCycle[drumCycleIndex_]);
+    applyPendingDrumEngine(true);
   }
   */
-  int songPatternA = songPatternIndexForTrack(SongTrack::SynthA);
-  int songPatternB = songPatternIndexForTrack(SongTrack::SynthB);
   int songPatternDrums = songPatternIndexForTrack(SongTrack::Drums);
 
   // 303 voices
-  const SynthPattern& synthA = activeSynthPattern(0);
-  const SynthPattern& synthB = activeSynthPattern(1);
-  const SynthStep& stepA = synthA.steps[currentStepIndex];
-  const SynthStep& stepB = synthB.steps[currentStepIndex];
-  int note = stepA.note;
-  bool accent = stepA.accent;
-  bool slide = stepA.slide;
-
-  int note2 = stepB.note;
-  bool accent2 = stepB.accent;
-  bool slide2 = stepB.slide;
-
-  if (!mute303 && songPatternA >= 0 && note >= 0)
-    voice303.startNote(noteToFreq(note), accent, slide);
-  else
-    voice303.release();
-
-  if (!mute303_2 && songPatternB >= 0 && note2 >= 0)
-    voice3032.startNote(noteToFreq(note2), accent2, slide2);
-  else
-    voice3032.release();
+  for (int v = 0; v < NUM_303_VOICES; ++v) {
+    bool trackActive = !isScene303Voice(v) || songPatternIndexForTrack(synthTrack(v)) >= 0;
+    const SynthStep& step = activeSynthPattern(v).steps[stepIndex];
+    if (!mute303_[v] && trackActive && step.note >= 0)
+      voices303_[v].startNote(noteToFreq(step.note), step.accent, step.slide);
+    else
+      voices303_[v].release();
+  }
 
   // Drums
   const DrumPattern& kick = activeDrumPattern(kDrumKickVoice);
@@ -973,112 +1404,235 @@ void MiniAcid::advanceStep() {
 
   bool drumsActive = songPatternDrums >= 0;
   bool stepAccent =
-    kick.steps[currentStepIndex].accent ||
-    snare.steps[currentStepIndex].accent ||
-    hat.steps[currentStepIndex].accent ||
-    openHat.steps[currentStepIndex].accent ||
-    midTom.steps[currentStepIndex].accent ||
-    highTom.steps[currentStepIndex].accent ||
-    rim.steps[currentStepIndex].accent ||
-    clap.steps[currentStepIndex].accent;
-
-  if (kick.steps[currentStepIndex].hit && !muteKick && drumsActive)
-    drums->triggerKick(stepAccent);
-  if (snare.steps[currentStepIndex].hit && !muteSnare && drumsActive)
-    drums->triggerSnare(stepAccent);
-  if (hat.steps[currentStepIndex].hit && !muteHat && drumsActive)
-    drums->triggerHat(stepAccent);
-  if (openHat.steps[currentStepIndex].hit && !muteOpenHat && drumsActive)
-    drums->triggerOpenHat(stepAccent);
-  if (midTom.steps[currentStepIndex].hit && !muteMidTom && drumsActive)
-    drums->triggerMidTom(stepAccent);
-  if (highTom.steps[currentStepIndex].hit && !muteHighTom && drumsActive)
-    drums->triggerHighTom(stepAccent);
-  if (rim.steps[currentStepIndex].hit && !muteRim && drumsActive)
-    drums->triggerRim(stepAccent);
-  if (clap.steps[currentStepIndex].hit && !muteClap && drumsActive)
+    kick.steps[stepIndex].accent ||
+    snare.steps[stepIndex].accent ||
+    hat.steps[stepIndex].accent ||
+    openHat.steps[stepIndex].accent ||
+    midTom.steps[stepIndex].accent ||
+    highTom.steps[stepIndex].accent ||
+    rim.steps[stepIndex].accent ||
+    clap.steps[stepIndex].accent;
+
+  if (kick.steps[stepIndex].hit && !muteKick && drumsActive)
+    triggerDrum(DrumVoiceId::Kick, stepAccent);
+  if (snare.steps[stepIndex].hit && !muteSnare && drumsActive)
+    triggerDrum(DrumVoiceId::Snare, stepAccent);
+  if (hat.steps[stepIndex].hit && !muteHat && drumsActive)
+    triggerDrum(DrumVoiceId::Hat, stepAccent);
+  if (openHat.steps[stepIndex].hit && !muteOpenHat && drumsActive)
+    triggerDrum(DrumVoiceId::OpenHat, stepAccent);
+  if (midTom.steps[stepIndex].hit && !muteMidTom && drumsActive)
+    triggerDrum(DrumVoiceId::MidTom, stepAccent);
+  if (highTom.steps[stepIndex].hit && !muteHighTom && drumsActive)
+    triggerDrum(DrumVoiceId::HighTom, stepAccent);
+  if (rim.steps[stepIndex].hit && !muteRim && drumsActive)
+    triggerDrum(DrumVoiceId::Rim, stepAccent);
+  if (clap.steps[stepIndex].hit && !muteClap && drumsActive)
     //drums->triggerCymbal(stepAccent);
-    drums->triggerClap(stepAccent);
+    triggerDrum(DrumVoiceId::Clap, stepAccent);
 }
 
 void MiniAcid::generateAudioBuffer(int16_t *buffer, size_t numSamples) {
   if (!buffer || numSamples == 0) {
     return;
   }
+  DenormalGuard denormalGuard;
 
+  drainCommands();
   updateSamplesPerStep();
-  delay303.setBpm(bpmValue);
-  delay3032.setBpm(bpmValue);
-
-  for (size_t i = 0; i < numSamples; ++i) {
-    if (playing) {
-      if (samplesIntoStep >= (unsigned long)samplesPerStep) {
+  float bpm = bpmValue;
+  for (int v = 0; v < NUM_303_VOICES; ++v)
+    delays303_[v].setBpm(bpm);
+
+  if (!playing) {
+    applyPendingDrumEngine(false);
+    renderBlock(buffer, numSamples, false);
+  } else if (tailOnly_) {
+    renderBlock(buffer, numSamples, true);
+  } else {
+    // Split the buffer at step boundaries so every sub-block renders without
+    // sequencer checks; new notes fire on the exact sample they always did.
+    size_t offset = 0;
+    while (offset < numSamples) {
+      unsigned long remaining = samplesUntilNextStep();
+      if (remaining == 0) {
         samplesIntoStep = 0;
         advanceStep();
+        remaining = samplesUntilNextStep();
       }
-      samplesIntoStep++;
+      size_t n = numSamples - offset;
+      if (n > remaining) n = static_cast<size_t>(remaining);
+      renderBlock(buffer + offset, n, true);
+      samplesIntoStep += n;
+      offset += n;
+    }
+  }
+
+  scope_.write(buffer, numSamples);
+  publishUiState();
+}
+
+void MiniAcid::setRenderSplit(RenderSplit* split) {
+  renderSplit_ = split;
+}
+
+void MiniAcid::setRenderPool(RenderPool* pool) {
+  renderPool_ = pool;
+  voiceBuses_.assign(pool ? static_cast<size_t>(NUM_303_VOICES) * AUDIO_BUFFER_SAMPLES : 0, 0.0f);
+}
+
+void MiniAcid::renderBusJob(void* context, int index) {
+  MiniAcid* self = static_cast<MiniAcid*>(context);
+  DenormalGuard denormalGuard;
+  size_t n = self->helperSamples_;
+  if (index == 0) {
+    self->renderDrumBus(n, self->helperDrumMask_);
+    return;
+  }
+  int v = index - 1;
+  if (self->helperSynthMask_ & (1u << v))
+    self->render303Voice(v, &self->voiceBuses_[static_cast<size_t>(v) * AUDIO_BUFFER_SAMPLES], n);
+}
+
+void MiniAcid::renderHelperJob(void* context) {
+  MiniAcid* self = static_cast<MiniAcid*>(context);
+  // The flush-to-zero mode belongs to the thread, so the helper sets its own.
+  DenormalGuard denormalGuard;
+  size_t n = self->helperSamples_;
+  self->renderDrumBus(n, self->helperDrumMask_);
+  self->render303Voices(kFirstHelper303Voice, NUM_303_VOICES, self->helperSynthMask_,
+                        self->helperVoiceBuffer_, self->helperSynthBuffer_, n);
+}
+
+void MiniAcid::renderDrumBus(size_t n, uint16_t drumMask) {
+  if (drums->activeVoiceMask() & drumMask) {
+    drums->process(mixBuffer_, n, drumMask);
+  } else {
+    for (size_t i = 0; i < n; ++i) mixBuffer_[i] = 0.0f;
+  }
+  if (drumRiseRemaining_ > 0) {
+    size_t riseN = n < drumRiseRemaining_ ? n : drumRiseRemaining_;
+    float gain = 1.0f - static_cast<float>(drumRiseRemaining_) * drumRiseStep_;
+    for (size_t i = 0; i < riseN; ++i) {
+      mixBuffer_[i] *= gain;
+      gain += drumRiseStep_;
     }
+    drumRiseRemaining_ -= riseN;
+  }
+  for (DrumFade& fade : drumFades_) {
+    if (!fade.kit) continue;
+    // The previous kits get no new hits; fade their tails out linearly.
+    size_t fadeN = n < fade.remaining ? n : fade.remaining;
+    fade.kit->process(drumTailBuffer_, fadeN, drumMask);
+    float gain = static_cast<float>(fade.remaining) * fade.gainStep;
+    for (size_t i = 0; i < fadeN; ++i) {
+      mixBuffer_[i] += drumTailBuffer_[i] * gain;
+      gain -= fade.gainStep;
+    }
+    fade.remaining -= fadeN;
+    if (fade.remaining == 0)
+      fade.kit = nullptr;
+  }
+  drumHits_.mix(mixBuffer_, n, drumMask);
+}
+
+void MiniAcid::render303Voice(int v, float* out, size_t n) {
+  if (!mute303_[v] && voices303_[v].isActive()) {
+    voices303_[v].process(out, n);
+    for (size_t i = 0; i < n; ++i) out[i] *= 0.5f;
+    distortions303_[v].process(out, n);
+  } else {
+    // keep delay line ticking even while muted to let tails decay
+    for (size_t i = 0; i < n; ++i) out[i] = 0.0f;
+  }
+  delays303_[v].process(out, n);
+}
 
-    float sample = 0.0f;
-    if (playing) {
-      float sample303 = 0.0f;
-      if (!mute303) {
-        float v = voice303.process() * 0.5f;
-        v = distortion303.process(v);
-        sample303 += delay303.process(v);
+void MiniAcid::render303Voices(int first, int last, uint32_t activeMask, float* scratch,
+                               float* out, size_t n) {
+  for (size_t i = 0; i < n; ++i) out[i] = 0.0f;
+  for (int v = first; v < last; ++v) {
+    if (!(activeMask & (1u << v)))
+      continue;
+    render303Voice(v, scratch, n);
+    for (size_t i = 0; i < n; ++i) out[i] += scratch[i];
+  }
+}
+
+void MiniAcid::renderBlock(int16_t *buffer, size_t numSamples, bool isPlaying) {
+  while (numSamples > 0) {
+    size_t n = numSamples;
+    if (n > AUDIO_BUFFER_SAMPLES) n = AUDIO_BUFFER_SAMPLES;
+
+    if (isPlaying) {
+      uint16_t drumMask = 0;
+      if (!muteKick) drumMask |= drumVoiceBit(DrumVoiceId::Kick);
+      if (!muteSnare) drumMask |= drumVoiceBit(DrumVoiceId::Snare);
+      if (!muteHat) drumMask |= drumVoiceBit(DrumVoiceId::Hat);
+      if (!muteOpenHat) drumMask |= drumVoiceBit(DrumVoiceId::OpenHat);
+      if (!muteMidTom) drumMask |= drumVoiceBit(DrumVoiceId::MidTom);
+      if (!muteHighTom) drumMask |= drumVoiceBit(DrumVoiceId::HighTom);
+      if (!muteRim) drumMask |= drumVoiceBit(DrumVoiceId::Rim);
+      if (!muteClap) drumMask |= drumVoiceBit(DrumVoiceId::Clap);
+      uint32_t synthMask = active303VoiceMask();
+
+      helperSamples_ = n;
+      helperDrumMask_ = drumMask;
+      helperSynthMask_ = synthMask;
+      if (renderPool_) {
+        renderPool_->run(&MiniAcid::renderBusJob, this, NUM_303_VOICES + 1);
+        // Sum the buses in the same groups and order as the split below,
+        // so every mode rounds identically.
+        for (size_t i = 0; i < n; ++i) synthBuffer_[i] = 0.0f;
+        for (size_t i = 0; i < n; ++i) helperSynthBuffer_[i] = 0.0f;
+        for (int v = 0; v < NUM_303_VOICES; ++v) {
+          if (!(synthMask & (1u << v)))
+            continue;
+          float* sum = v < kFirstHelper303Voice ? synthBuffer_ : helperSynthBuffer_;
+          const float* bus = &voiceBuses_[static_cast<size_t>(v) * AUDIO_BUFFER_SAMPLES];
+          for (size_t i = 0; i < n; ++i) sum[i] += bus[i];
+        }
       } else {
-        // keep delay line ticking even while muted to let tails decay
-        delay303.process(0.0f);
+        // The two halves share no state, so the helper's half runs either
+        // on the other core or here, with the same result.
+        if (renderSplit_)
+          renderSplit_->fork(&MiniAcid::renderHelperJob, this);
+        else
+          renderHelperJob(this);
+        render303Voices(0, kFirstHelper303Voice, synthMask, voiceBuffer_, synthBuffer_, n);
+        if (renderSplit_)
+          renderSplit_->join();
       }
-      if (!mute303_2) {
-        float v = voice3032.process() * 0.5f;
-        v = distortion3032.process(v);
-        sample303 += delay3032.process(v);
-      } else {
-        delay3032.process(0.0f);
+
+      if (kFirstHelper303Voice < NUM_303_VOICES) {
+        for (size_t i = 0; i < n; ++i) synthBuffer_[i] += helperSynthBuffer_[i];
       }
-      if (!muteKick)
-        sample += drums->processKick();
-      if (!muteSnare)
-        sample += drums->processSnare();
-      if (!muteHat)
-        sample += drums->processHat();
-      if (!muteOpenHat)
-        sample += drums->processOpenHat();
-      if (!muteMidTom)
-        sample += drums->processMidTom();
-      if (!muteHighTom)
-        sample += drums->processHighTom();
-      if (!muteRim)
-        sample += drums->processRim();
-      if (!muteClap)
-        // sample += drums->processCymbal();
-        sample += drums->processClap();
-      sample += sample303;
+      for (size_t i = 0; i < n; ++i) mixBuffer_[i] += synthBuffer_[i];
+    } else {
+      stopDrumFades();
+      for (size_t i = 0; i < n; ++i) mixBuffer_[i] = 0.0f;
     }
-
-    // Soft clipping/limiting
-    sample *= 0.65f;
-    if (sample > 1.0f)
-      sample = 1.0f;
-    if (sample < -1.0f)
-      sample = -1.0f;
-
+    drumHits_.build(n);
 
     float currentVolume = params[static_cast<int>(MiniAcidParamId::MainVolume)].value();
-    buffer[i] = static_cast<int16_t>(sample * 32767.0f * currentVolume);
+    for (size_t i = 0; i < n; ++i) {
+      // Soft clipping/limiting
+      float sample = mixBuffer_[i] * 0.65f;
+      if (sample > 1.0f)
+        sample = 1.0f;
+      if (sample < -1.0f)
+        sample = -1.0f;
+      buffer[i] = static_cast<int16_t>(sample * 32767.0f * currentVolume);
+    }
 
+    buffer += n;
+    numSamples -= n;
   }
-
-  size_t copyCount = numSamples;
-  if (copyCount > AUDIO_BUFFER_SAMPLES) copyCount = AUDIO_BUFFER_SAMPLES;
-  for (size_t i = 0; i < copyCount; ++i) lastBuffer[i] = buffer[i];
-  lastBufferCount = copyCount;
 }
 
 void MiniAcid::randomize303Pattern(int voiceIndex) {
   int idx = clamp303Voice(voiceIndex);
-  PatternGenerator::generateRandom303Pattern(editSynthPattern(idx));
+  PatternGenerator::generateRandom303Pattern(editSynthPattern(idx), patternRng_);
 }
 
 void MiniAcid::setParameter(MiniAcidParamId id, float value) {
@@ -1090,7 +1644,7 @@ void MiniAcid::adjustParameter(MiniAcidParamId id, int steps) {
 }
 
 void MiniAcid::randomizeDrumPattern() {
-  PatternGenerator::generateRandomDrumPattern(sceneManager_.editCurrentDrumPattern());
+  PatternGenerator::generateRandomDrumPattern(sceneManager_.editCurrentDrumPattern(), patternRng_);
 }
 
 std::string MiniAcid::currentSceneName() const {
@@ -1125,6 +1679,9 @@ bool MiniAcid::loadSceneByName(const std::string& name) {
     return false;
   }
   applySceneStateFromManager();
+  // Under the audio guard, so the UI can have the new scene right away
+  // rather than after the next block.
+  publishUiState();
   return true;
 }
 
@@ -1140,6 +1697,7 @@ bool MiniAcid::createNewSceneWithName(const std::string& name) {
   sceneStorage_->setCurrentSceneName(name);
   sceneManager_.loadDefaultScene();
   applySceneStateFromManager();
+  publishUiState();
   saveSceneToStorage();
   return true;
 }
@@ -1168,8 +1726,8 @@ void MiniAcid::applySceneStateFromManager() {
   if (!drumEngineName.empty()) {
     setDrumEngine(drumEngineName);
   }
-  mute303 = sceneManager_.getSynthMute(0);
-  mute303_2 = sceneManager_.getSynthMute(1);
+  for (int v = 0; v < NUM_SCENE_303_VOICES; ++v)
+    mute303_[v] = sceneManager_.getSynthMute(v);
 
   muteKick = sceneManager_.getDrumMute(kDrumKickVoice);
   muteSnare = sceneManager_.getDrumMute(kDrumSnareVoice);
@@ -1179,33 +1737,25 @@ void MiniAcid::applySceneStateFromManager() {
   muteHighTom = sceneManager_.getDrumMute(kDrumHighTomVoice);
   muteRim = sceneManager_.getDrumMute(kDrumRimVoice);
   muteClap = sceneManager_.getDrumMute(kDrumClapVoice);
-  distortion303Enabled = sceneManager_.getSynthDistortionEnabled(0);
-  distortion3032Enabled = sceneManager_.getSynthDistortionEnabled(1);
-  delay303Enabled = sceneManager_.getSynthDelayEnabled(0);
-  delay3032Enabled = sceneManager_.getSynthDelayEnabled(1);
-
-  const SynthParameters& paramsA = sceneManager_.getSynthParameters(0);
-  const SynthParameters& paramsB = sceneManager_.getSynthParameters(1);
-
-  voice303.setParameter(TB303ParamId::Cutoff, paramsA.cutoff);
-  voice303.setParameter(TB303ParamId::Resonance, paramsA.resonance);
-  voice303.setParameter(TB303ParamId::EnvAmount, paramsA.envAmount);
-  voice303.setParameter(TB303ParamId::EnvDecay, paramsA.envDecay);
-  voice303.setParameter(TB303ParamId::Oscillator, static_cast<float>(paramsA.oscType));
-
-  voice3032.setParameter(TB303ParamId::Cutoff, paramsB.cutoff);
-  voice3032.setParameter(TB303ParamId::Resonance, paramsB.resonance);
-  voice3032.setParameter(TB303ParamId::EnvAmount, paramsB.envAmount);
-  voice3032.setParameter(TB303ParamId::EnvDecay, paramsB.envDecay);
-  voice3032.setParameter(TB303ParamId::Oscillator, static_cast<float>(paramsB.oscType));
-  distortion303.setEnabled(distortion303Enabled);
-  distortion3032.setEnabled(distortion3032Enabled);
-  delay303.setEnabled(delay303Enabled);
-  delay3032.setEnabled(delay3032Enabled);
+
+  for (int v = 0; v < NUM_SCENE_303_VOICES; ++v) {
+    distortion303Enabled_[v] = sceneManager_.getSynthDistortionEnabled(v);
+    delay303Enabled_[v] = sceneManager_.getSynthDelayEnabled(v);
+
+    const SynthParameters& params = sceneManager_.getSynthParameters(v);
+    TB303Voice& voice = voices303_[v];
+    voice.setParameter(TB303ParamId::Cutoff, params.cutoff);
+    voice.setParameter(TB303ParamId::Resonance, params.resonance);
+    voice.setParameter(TB303ParamId::EnvAmount, params.envAmount);
+    voice.setParameter(TB303ParamId::EnvDecay, params.envDecay);
+    voice.setParameter(TB303ParamId::Oscillator, static_cast<float>(params.oscType));
+    distortions303_[v].setEnabled(distortion303Enabled_[v]);
+    delays303_[v].setEnabled(delay303Enabled_[v]);
+  }
 
   patternModeDrumPatternIndex_ = sceneManager_.getCurrentDrumPatternIndex();
-  patternModeSynthPatternIndex_[0] = sceneManager_.getCurrentSynthPatternIndex(0);
-  patternModeSynthPatternIndex_[1] = sceneManager_.getCurrentSynthPatternIndex(1);
+  for (int v = 0; v < NUM_SCENE_303_VOICES; ++v)
+    patternModeSynthPatternIndex_[v] = sceneManager_.getCurrentSynthPatternIndex(v);
   songMode_ = sceneManager_.songMode();
   songPlayheadPosition_ = clampSongPosition(sceneManager_.getSongPosition());
   if (songMode_) {
@@ -1215,9 +1765,9 @@ void MiniAcid::applySceneStateFromManager() {
 
 void MiniAcid::syncSceneStateToManager() {
   sceneManager_.setBpm(bpmValue);
-  sceneManager_.setDrumEngineName(drumEngineName_);
-  sceneManager_.setSynthMute(0, mute303);
-  sceneManager_.setSynthMute(1, mute303_2);
+  sceneManager_.setDrumEngineName(kDrumEngineNames[drumEngineIndex_]);
+  for (int v = 0; v < NUM_SCENE_303_VOICES; ++v)
+    sceneManager_.setSynthMute(v, mute303_[v]);
 
   sceneManager_.setDrumMute(kDrumKickVoice, muteKick);
   sceneManager_.setDrumMute(kDrumSnareVoice, muteSnare);
@@ -1227,55 +1777,49 @@ void MiniAcid::syncSceneStateToManager() {
   sceneManager_.setDrumMute(kDrumHighTomVoice, muteHighTom);
   sceneManager_.setDrumMute(kDrumRimVoice, muteRim);
   sceneManager_.setDrumMute(kDrumClapVoice, muteClap);
-  sceneManager_.setSynthDistortionEnabled(0, distortion303Enabled);
-  sceneManager_.setSynthDistortionEnabled(1, distortion3032Enabled);
-  sceneManager_.setSynthDelayEnabled(0, delay303Enabled);
-  sceneManager_.setSynthDelayEnabled(1, delay3032Enabled);
   sceneManager_.setSongMode(songMode_);
   int songPosToStore = songMode_ ? songPlayheadPosition_ : sceneManager_.getSongPosition();
   sceneManager_.setSongPosition(clampSongPosition(songPosToStore));
 
-  SynthParameters paramsA;
-  paramsA.cutoff = voice303.parameterValue(TB303ParamId::Cutoff);
-  paramsA.resonance = voice303.parameterValue(TB303ParamId::Resonance);
-  paramsA.envAmount = voice303.parameterValue(TB303ParamId::EnvAmount);
-  paramsA.envDecay = voice303.parameterValue(TB303ParamId::EnvDecay);
-  paramsA.oscType = voice303.oscillatorIndex();
-  sceneManager_.setSynthParameters(0, paramsA);
-
-  SynthParameters paramsB;
-  paramsB.cutoff = voice3032.parameterValue(TB303ParamId::Cutoff);
-  paramsB.resonance = voice3032.parameterValue(TB303ParamId::Resonance);
-  paramsB.envAmount = voice3032.parameterValue(TB303ParamId::EnvAmount);
-  paramsB.envDecay = voice3032.parameterValue(TB303ParamId::EnvDecay);
-  paramsB.oscType = voice3032.oscillatorIndex();
-  sceneManager_.setSynthParameters(1, paramsB);
+  for (int v = 0; v < NUM_SCENE_303_VOICES; ++v) {
+    const TB303Voice& voice = voices303_[v];
+    sceneManager_.setSynthDistortionEnabled(v, distortion303Enabled_[v]);
+    sceneManager_.setSynthDelayEnabled(v, delay303Enabled_[v]);
+
+    SynthParameters params;
+    params.cutoff = voice.parameterValue(TB303ParamId::Cutoff);
+    params.resonance = voice.parameterValue(TB303ParamId::Resonance);
+    params.envAmount = voice.parameterValue(TB303ParamId::EnvAmount);
+    params.envDecay = voice.parameterValue(TB303ParamId::EnvDecay);
+    params.oscType = voice.oscillatorIndex();
+    sceneManager_.setSynthParameters(v, params);
+  }
 }
 
 
-int dorian_intervals[7] = {0, 2, 3, 5, 7, 9, 10};
-int phrygian_intervals[7] = {0, 1, 3, 5, 7, 8, 10};
+constexpr int PatternGenerator::kDorianIntervals[7];
+constexpr int PatternGenerator::kPhrygianIntervals[7];
 
-void PatternGenerator::generateRandom303Pattern(SynthPattern& pattern) {
+void PatternGenerator::generateRandom303Pattern(SynthPattern& pattern, RandomGenerator& rng) {
   int rootNote = 26;
 
   for (int i = 0; i < SynthPattern::kSteps; ++i) {
-    int r = rand() % 10;
+    int r = rng.below(10);
     if (r < 7) {
-      pattern.steps[i].note = rootNote + dorian_intervals[rand() % 7] + 12 * (rand() % 3);
+      pattern.steps[i].note = rootNote + kDorianIntervals[rng.below(7)] + 12 * rng.below(3);
     } else {
       pattern.steps[i].note = -1; // 30% chance of rest
     }
 
     // Random accent (30% chance)
-    pattern.steps[i].accent = (rand() % 100) < 30;
+    pattern.steps[i].accent = rng.below(100) < 30;
 
     // Random slide (20% chance)
-    pattern.steps[i].slide = (rand() % 100) < 20;
+    pattern.steps[i].slide = rng.below(100) < 20;
   }
 }
 
-void PatternGenerator::generateRandomDrumPattern(DrumPatternSet& patternSet) {
+void PatternGenerator::generateRandomDrumPattern(DrumPatternSet& patternSet, RandomGenerator& rng) {
   const int stepCount = DrumPattern::kSteps;
   const int drumVoiceCount = DrumPatternSet::kVoices;
 
@@ -1288,41 +1832,41 @@ void PatternGenerator::generateRandomDrumPattern(DrumPatternSet& patternSet) {
 
   for (int i = 0; i < stepCount; ++i) {
     if (drumVoiceCount > kDrumKickVoice) {
-      if (i % 4 == 0 || (rand() % 100) < 20) {
+      if (i % 4 == 0 || rng.below(100) < 20) {
         patternSet.voices[kDrumKickVoice].steps[i].hit = true;
       } else {
         patternSet.voices[kDrumKickVoice].steps[i].hit = false;
       }
       patternSet.voices[kDrumKickVoice].steps[i].accent =
-        patternSet.voices[kDrumKickVoice].steps[i].hit && (rand() % 100) < 35;
+        patternSet.voices[kDrumKickVoice].steps[i].hit && rng.below(100) < 35;
     }
 
     if (drumVoiceCount > kDrumSnareVoice) {
-      if (i % 4 == 2 || (rand() % 100) < 15) {
-        patternSet.voices[kDrumSnareVoice].steps[i].hit = (rand() % 100) < 80;
+      if (i % 4 == 2 || rng.below(100) < 15) {
+        patternSet.voices[kDrumSnareVoice].steps[i].hit = rng.below(100) < 80;
       } else {
         patternSet.voices[kDrumSnareVoice].steps[i].hit = false;
       }
       patternSet.voices[kDrumSnareVoice].steps[i].accent =
-        patternSet.voices[kDrumSnareVoice].steps[i].hit && (rand() % 100) < 30;
+        patternSet.voices[kDrumSnareVoice].steps[i].hit && rng.below(100) < 30;
     }
 
     bool hatVal = false;
     if (drumVoiceCount > kDrumHatVoice) {
-      if ((rand() % 100) < 90) {
-        hatVal = (rand() % 100) < 80;
+      if (rng.below(100) < 90) {
+        hatVal = rng.below(100) < 80;
       } else {
         hatVal = false;
       }
       patternSet.voices[kDrumHatVoice].steps[i].hit = hatVal;
-      patternSet.voices[kDrumHatVoice].steps[i].accent = hatVal && (rand() % 100) < 20;
+      patternSet.voices[kDrumHatVoice].steps[i].accent = hatVal && rng.below(100) < 20;
     }
 
     bool openVal = false;
     if (drumVoiceCount > kDrumOpenHatVoice) {
-      openVal = (i % 4 == 3 && (rand() % 100) < 65) || ((rand() % 100) < 20 && hatVal);
+      openVal = (i % 4 == 3 && rng.below(100) < 65) || (rng.below(100) < 20 && hatVal);
       patternSet.voices[kDrumOpenHatVoice].steps[i].hit = openVal;
-      patternSet.voices[kDrumOpenHatVoice].steps[i].accent = openVal && (rand() % 100) < 25;
+      patternSet.voices[kDrumOpenHatVoice].steps[i].accent = openVal && rng.below(100) < 25;
       if (openVal && drumVoiceCount > kDrumHatVoice) {
         patternSet.voices[kDrumHatVoice].steps[i].hit = false;
         patternSet.voices[kDrumHatVoice].steps[i].accent = false;
@@ -1330,32 +1874,32 @@ void PatternGenerator::generateRandomDrumPattern(DrumPatternSet& patternSet) {
     }
 
     if (drumVoiceCount > kDrumMidTomVoice) {
-      bool midTom = (i % 8 == 4 && (rand() % 100) < 75) || ((rand() % 100) < 8);
+      bool midTom = (i % 8 == 4 && rng.below(100) < 75) || (rng.below(100) < 8);
       patternSet.voices[kDrumMidTomVoice].steps[i].hit = midTom;
-      patternSet.voices[kDrumMidTomVoice].steps[i].accent = midTom && (rand() % 100) < 35;
+      patternSet.voices[kDrumMidTomVoice].steps[i].accent = midTom && rng.below(100) < 35;
     }
 
     if (drumVoiceCount > kDrumHighTomVoice) {
-      bool highTom = (i % 8 == 6 && (rand() % 100) < 70) || ((rand() % 100) < 6);
+      bool highTom = (i % 8 == 6 && rng.below(100) < 70) || (rng.below(100) < 6);
       patternSet.voices[kDrumHighTomVoice].steps[i].hit = highTom;
-      patternSet.voices[kDrumHighTomVoice].steps[i].accent = highTom && (rand() % 100) < 35;
+      patternSet.voices[kDrumHighTomVoice].steps[i].accent = highTom && rng.below(100) < 35;
     }
 
     if (drumVoiceCount > kDrumRimVoice) {
-      bool rim = (i % 4 == 1 && (rand() % 100) < 25);
+      bool rim = (i % 4 == 1 && rng.below(100) < 25);
       patternSet.voices[kDrumRimVoice].steps[i].hit = rim;
-      patternSet.voices[kDrumRimVoice].steps[i].accent = rim && (rand() % 100) < 30;
+      patternSet.voices[kDrumRimVoice].steps[i].accent = rim && rng.below(100) < 30;
     }
 
     if (drumVoiceCount > kDrumClapVoice) {
       bool clap = false;
       if (i % 4 == 2) {
-        clap = (rand() % 100) < 80;
+        clap = rng.below(100) < 80;
       } else {
-        clap = (rand() % 100) < 5;
+        clap = rng.below(100) < 5;
       }
       patternSet.voices[kDrumClapVoice].steps[i].hit = clap;
-      patternSet.voices[kDrumClapVoice].steps[i].accent = clap && (rand() % 100) < 30;
+      patternSet.voices[kDrumClapVoice].steps[i].accent = clap && rng.below(100) < 30;
     }
   }
 }
@@ -2,6 +2,7 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <atomic>
 #include <memory>
 #include <vector>
 #include <string>
@@ -10,20 +11,46 @@
 #include "scenes.h"
 #include "mini_tb303.h"
 #include "mini_drumvoices.h"
+#include "random_generator.h"
+#include "drum_hit_cache.h"
+#include "fixed_point.h"
+#include "render_pool.h"
+#include "render_split.h"
+#include "scope_ring.h"
+#include "spsc_queue.h"
+#include "triple_buffer.h"
 #include "tube_distortion.h"
 
 // ===================== Audio config =====================
 
+// Default engine rate. Front ends can switch to any rate MiniAcid::
+// isSupportedSampleRate() accepts with setSampleRate().
 static const int SAMPLE_RATE = 22050;        // Hz
 static const int AUDIO_BUFFER_SAMPLES = 256; // per buffer, mono
 static const int SEQ_STEPS = 16;             // 16-step sequencer
-static const int NUM_303_VOICES = 2;
+// Size of the 303 voice pool. Scenes and the UI cover the first
+// NUM_SCENE_303_VOICES; any further voices play engine-held patterns that
+// are set through the same per-voice API.
+#ifndef MINIACID_303_VOICES
+#define MINIACID_303_VOICES 2
+#endif
+static const int NUM_303_VOICES = MINIACID_303_VOICES;
+static const int NUM_SCENE_303_VOICES = 2;
+static_assert(NUM_303_VOICES >= NUM_SCENE_303_VOICES, "the pool must cover the scene's synth tracks");
+static_assert(NUM_303_VOICES <= 32, "active 303 voices are tracked in a 32-bit mask");
 static const int NUM_DRUM_VOICES = DrumPatternSet::kVoices;
+// Output history kept for the scope; 8192 samples is 370 ms at 22050 Hz.
+#ifndef MINIACID_SCOPE_SAMPLES
+#define MINIACID_SCOPE_SAMPLES 8192
+#endif
+static const size_t SCOPE_SAMPLES = MINIACID_SCOPE_SAMPLES;
 
 // ===================== Parameters =====================
 
 class TempoDelay {
 public:
+  // The default constructor allocates nothing; call setSampleRate() first.
+  TempoDelay();
   explicit TempoDelay(float sampleRate);
 
   void reset();
@@ -34,14 +61,29 @@ public:
   void setFeedback(float fb);
   void setEnabled(bool on);
   bool isEnabled() const;
+  // True while the line holds only silence, so silent input can pass
+  // through without touching it.
+  bool isIdle() const;
 
   float process(float input);
+  // Processes numSamples of samples in place.
+  void process(float* samples, size_t numSamples);
 
 private:
   // for 2 voices at 22050 Hz, this is the max that the cardputer can handle.
   static const int kMaxDelaySeconds = 1;
+  // Anything quieter than this is below one 16-bit LSB at full volume.
+  static constexpr float kSilenceThreshold = 1e-5f;
+#if MINIACID_FIXED_POINT
+  // Q12 in 16 bits: +-8 of headroom for feedback build-up at half the
+  // memory of a float line.
+  typedef int16_t Sample;
+  static constexpr int kSampleFracBits = 12;
+#else
+  typedef float Sample;
+#endif
 
-  std::vector<float> buffer;
+  std::vector<Sample> buffer;
   int writeIndex;
   int delaySamples;
   float sampleRate;
@@ -50,12 +92,225 @@ private:
   float mix;      // wet mix 0..1
   float feedback; // feedback 0..1
   bool enabled;
+  bool idle;      // every sample in the line is below kSilenceThreshold
+  int quietRun;   // consecutive quiet samples written to the line
 };
 
 enum class MiniAcidParamId : uint8_t {
   MainVolume = 0,
   Count
 };
+
+enum class EngineCommandType : uint8_t {
+  ToggleMute303 = 0,
+  ToggleMuteDrum,
+  ToggleDelay303,
+  ToggleDistortion303,
+  SetDelay303Enabled,
+  SetDistortion303Enabled,
+  SetBpm,
+  SetParameter,
+  AdjustParameter,
+  Set303Parameter,
+  Adjust303Parameter,
+  SetDrumPatternIndex,
+  SetDrumBankIndex,
+  Set303PatternIndex,
+  Set303BankIndex,
+  Adjust303StepNote,
+  Adjust303StepOctave,
+  Clear303StepNote,
+  Set303StepNote,
+  Toggle303AccentStep,
+  Set303AccentStep,
+  Toggle303SlideStep,
+  Set303SlideStep,
+  ToggleDrumStep,
+  SetDrumStep,
+  ToggleDrumAccentStep,
+  SetDrumAccentStep,
+  Randomize303Pattern,
+  RandomizeDrumPattern,
+  ToggleSongMode,
+  SetLoopMode,
+  SetLoopRange,
+  SetSongPosition,
+  SetSongPattern,
+  ClearSongPattern,
+  SetDrumEngineCrossfadeMs,
+  SetDrumEngine,
+};
+
+// An edit the UI hands to the audio thread with MiniAcid::post(). Each
+// factory mirrors the MiniAcid method of the same name.
+struct EngineCommand {
+  EngineCommandType type;
+  int8_t voice;  // 303 voice, drum voice or song track
+  int16_t index; // step, pattern, bank, song row or parameter id
+  int16_t arg;   // song pattern, loop end row, note or on/off flag
+  float value;   // parameter value, step count or note delta
+
+  static EngineCommand toggleMute303(int voiceIndex) {
+    return make(EngineCommandType::ToggleMute303, voiceIndex);
+  }
+  static EngineCommand toggleMuteDrum(DrumVoiceId id) {
+    return make(EngineCommandType::ToggleMuteDrum, static_cast<int>(id));
+  }
+  static EngineCommand toggleDelay303(int voiceIndex) {
+    return make(EngineCommandType::ToggleDelay303, voiceIndex);
+  }
+  static EngineCommand toggleDistortion303(int voiceIndex) {
+    return make(EngineCommandType::ToggleDistortion303, voiceIndex);
+  }
+  static EngineCommand setDelay303Enabled(int voiceIndex, bool enabled) {
+    return make(EngineCommandType::SetDelay303Enabled, voiceIndex, 0, enabled ? 1 : 0);
+  }
+  static EngineCommand setDistortion303Enabled(int voiceIndex, bool enabled) {
+    return make(EngineCommandType::SetDistortion303Enabled, voiceIndex, 0, enabled ? 1 : 0);
+  }
+  static EngineCommand setBpm(float bpm) {
+    return make(EngineCommandType::SetBpm, 0, 0, 0, bpm);
+  }
+  static EngineCommand setParameter(MiniAcidParamId id, float value) {
+    return make(EngineCommandType::SetParameter, 0, static_cast<int>(id), 0, value);
+  }
+  static EngineCommand adjustParameter(MiniAcidParamId id, int steps) {
+    return make(EngineCommandType::AdjustParameter, 0, static_cast<int>(id), 0, static_cast<float>(steps));
+  }
+  static EngineCommand set303Parameter(TB303ParamId id, float value, int voiceIndex = 0) {
+    return make(EngineCommandType::Set303Parameter, voiceIndex, static_cast<int>(id), 0, value);
+  }
+  static EngineCommand adjust303Parameter(TB303ParamId id, int steps, int voiceIndex = 0) {
+    return make(EngineCommandType::Adjust303Parameter, voiceIndex, static_cast<int>(id), 0,
+                static_cast<float>(steps));
+  }
+  static EngineCommand setDrumPatternIndex(int patternIndex) {
+    return make(EngineCommandType::SetDrumPatternIndex, 0, patternIndex);
+  }
+  static EngineCommand setDrumBankIndex(int bankIndex) {
+    return make(EngineCommandType::SetDrumBankIndex, 0, bankIndex);
+  }
+  static EngineCommand set303PatternIndex(int voiceIndex, int patternIndex) {
+    return make(EngineCommandType::Set303PatternIndex, voiceIndex, patternIndex);
+  }
+  static EngineCommand set303BankIndex(int voiceIndex, int bankIndex) {
+    return make(EngineCommandType::Set303BankIndex, voiceIndex, bankIndex);
+  }
+  static EngineCommand adjust303StepNote(int voiceIndex, int stepIndex, int semitoneDelta) {
+    return make(EngineCommandType::Adjust303StepNote, voiceIndex, stepIndex, 0,
+                static_cast<float>(semitoneDelta));
+  }
+  static EngineCommand adjust303StepOctave(int voiceIndex, int stepIndex, int octaveDelta) {
+    return make(EngineCommandType::Adjust303StepOctave, voiceIndex, stepIndex, 0,
+                static_cast<float>(octaveDelta));
+  }
+  static EngineCommand clear303StepNote(int voiceIndex, int stepIndex) {
+    return make(EngineCommandType::Clear303StepNote, voiceIndex, stepIndex);
+  }
+  static EngineCommand set303StepNote(int voiceIndex, int stepIndex, int note) {
+    return make(EngineCommandType::Set303StepNote, voiceIndex, stepIndex, note);
+  }
+  static EngineCommand toggle303AccentStep(int voiceIndex, int stepIndex) {
+    return make(EngineCommandType::Toggle303AccentStep, voiceIndex, stepIndex);
+  }
+  static EngineCommand set303AccentStep(int voiceIndex, int stepIndex, bool accent) {
+    return make(EngineCommandType::Set303AccentStep, voiceIndex, stepIndex, accent ? 1 : 0);
+  }
+  static EngineCommand toggle303SlideStep(int voiceIndex, int stepIndex) {
+    return make(EngineCommandType::Toggle303SlideStep, voiceIndex, stepIndex);
+  }
+  static EngineCommand set303SlideStep(int voiceIndex, int stepIndex, bool slide) {
+    return make(EngineCommandType::Set303SlideStep, voiceIndex, stepIndex, slide ? 1 : 0);
+  }
+  static EngineCommand toggleDrumStep(int voiceIndex, int stepIndex) {
+    return make(EngineCommandType::ToggleDrumStep, voiceIndex, stepIndex);
+  }
+  static EngineCommand setDrumStep(int voiceIndex, int stepIndex, bool hit) {
+    return make(EngineCommandType::SetDrumStep, voiceIndex, stepIndex, hit ? 1 : 0);
+  }
+  static EngineCommand toggleDrumAccentStep(int stepIndex) {
+    return make(EngineCommandType::ToggleDrumAccentStep, 0, stepIndex);
+  }
+  static EngineCommand setDrumAccentStep(int voiceIndex, int stepIndex, bool accent) {
+    return make(EngineCommandType::SetDrumAccentStep, voiceIndex, stepIndex, accent ? 1 : 0);
+  }
+  static EngineCommand randomize303Pattern(int voiceIndex = 0) {
+    return make(EngineCommandType::Randomize303Pattern, voiceIndex);
+  }
+  static EngineCommand randomizeDrumPattern() {
+    return make(EngineCommandType::RandomizeDrumPattern);
+  }
+  static EngineCommand toggleSongMode() {
+    return make(EngineCommandType::ToggleSongMode);
+  }
+  static EngineCommand setLoopMode(bool enabled) {
+    return make(EngineCommandType::SetLoopMode, 0, 0, enabled ? 1 : 0);
+  }
+  static EngineCommand setLoopRange(int startRow, int endRow) {
+    return make(EngineCommandType::SetLoopRange, 0, startRow, endRow);
+  }
+  static EngineCommand setSongPosition(int position) {
+    return make(EngineCommandType::SetSongPosition, 0, position);
+  }
+  static EngineCommand setSongPattern(int position, SongTrack track, int patternIndex) {
+    return make(EngineCommandType::SetSongPattern, static_cast<int>(track), position, patternIndex);
+  }
+  static EngineCommand clearSongPattern(int position, SongTrack track) {
+    return make(EngineCommandType::ClearSongPattern, static_cast<int>(track), position);
+  }
+  static EngineCommand setDrumEngineCrossfadeMs(float ms) {
+    return make(EngineCommandType::SetDrumEngineCrossfadeMs, 0, 0, 0, ms);
+  }
+  // engineIndex counts into MiniAcid::getAvailableDrumEngines().
+  static EngineCommand setDrumEngine(int engineIndex) {
+    return make(EngineCommandType::SetDrumEngine, 0, engineIndex);
+  }
+
+private:
+  static EngineCommand make(EngineCommandType type, int voice = 0, int index = 0, int arg = 0,
+                            float value = 0.0f) {
+    EngineCommand cmd;
+    cmd.type = type;
+    cmd.voice = static_cast<int8_t>(voice);
+    cmd.index = static_cast<int16_t>(index);
+    cmd.arg = static_cast<int16_t>(arg);
+    cmd.value = value;
+    return cmd;
+  }
+};
+
+// The sequencer and 303 state the UI shows. The audio thread applies every
+// edit, so it publishes a copy of this after each block and the UI getters
+// read the copy instead of state the audio thread may be changing.
+struct EngineUiState {
+  bool songMode = false;
+  bool loopMode = false;
+  int loopStartRow = 0;
+  int loopEndRow = 0;
+  int songLength = 1;
+  int songPosition = 0;
+  int songPlayheadPosition = 0;
+  uint32_t appliedCommands = 0; // commands applied before this was taken
+  int drumEngine = 0;           // index into getAvailableDrumEngines()
+  int drumPatternIndex = 0;
+  int drumBankIndex = 0;
+  int displayDrumPatternIndex = 0;
+  int synthPatternIndex[NUM_303_VOICES] = {};
+  int synthBankIndex[NUM_303_VOICES] = {};
+  int displaySynthPatternIndex[NUM_303_VOICES] = {};
+  // Steps of the patterns playing (or selected, outside song mode).
+  int8_t synthNotes[NUM_303_VOICES][SEQ_STEPS] = {};
+  bool synthAccents[NUM_303_VOICES][SEQ_STEPS] = {};
+  bool synthSlides[NUM_303_VOICES][SEQ_STEPS] = {};
+  bool drumHits[NUM_DRUM_VOICES][SEQ_STEPS] = {};
+  bool drumAccents[NUM_DRUM_VOICES][SEQ_STEPS] = {};
+  bool drumStepAccents[SEQ_STEPS] = {};
+  float params303[NUM_303_VOICES][static_cast<int>(TB303ParamId::Count)] = {};
+  // songPattern() of every cell, and the raw song for song().
+  int8_t songPatterns[Song::kMaxPositions][SongPosition::kTrackCount] = {};
+  Song song;
+};
+
 class MiniAcid {
 public:
   static constexpr int kMin303Note = 24; // C1
@@ -65,11 +320,27 @@ public:
 
   void init();
   void reset();
+  // start(), stop() and the scene loads and saves below change state the
+  // audio thread uses, and stop() saves the scene, so they cannot be
+  // posted; call them under the audio guard.
   void start();
   void stop();
+  // For offline bounces: stops triggering steps but keeps the voices,
+  // delays and drum tails running, so generateAudioBuffer() renders the
+  // song's ring-out instead of the silence stop() leaves. Held 303 notes
+  // are released. start() or stop() ends it.
+  void releaseForTail();
   void setBpm(float bpm);
   float bpm() const;
+  // Samples per sequencer step at the current tempo and rate.
+  unsigned long stepLengthSamples() const;
   float sampleRate() const;
+  // Changes the engine rate, re-deriving every voice's coefficients, the
+  // delay lines and the cached drum hits. Allocates, so call it before
+  // audio starts or under the audio guard.
+  void setSampleRate(float sampleRate);
+  // Rates with precomputed tables: 22050, 32000, 44100 and 48000 Hz.
+  static bool isSupportedSampleRate(int sampleRate);
   bool isPlaying() const;
   int currentStep() const;
   int currentDrumPatternIndex() const;
@@ -87,7 +358,14 @@ public:
   bool isClapMuted() const;
   bool is303DelayEnabled(int voiceIndex = 0) const;
   bool is303DistortionEnabled(int voiceIndex = 0) const;
+  // The getters from here to displayDrumPatternIndex() are for the UI
+  // thread. They show the state as of the last rendered block (or init()),
+  // so an edit posted a moment ago may not show yet. Pointers and
+  // references they return stay valid until the next call to the same
+  // getter.
   const Parameter& parameter303(TB303ParamId id, int voiceIndex = 0) const;
+  // Copies the latest output, up to maxSamples of it and oldest first, and
+  // returns the count. Lock-free and safe from any thread.
   size_t copyLastAudio(int16_t *dst, size_t maxSamples) const;
   const int8_t* pattern303Steps(int voiceIndex = 0) const;
   const bool* pattern303AccentSteps(int voiceIndex = 0) const;
@@ -128,8 +406,24 @@ public:
   int display303PatternIndex(int voiceIndex) const;
   int displayDrumPatternIndex() const;
   std::vector<std::string> getAvailableDrumEngines() const;
+  // Queues a kit change; the audio thread switches at the next step.
+  // Audio thread or audio guard only: the UI posts
+  // EngineCommand::setDrumEngine.
   void setDrumEngine(const std::string& engineName);
+  // How long the previous kit keeps ringing after a switch; 0 cuts it off.
+  // Audio thread only: the UI posts EngineCommand::setDrumEngineCrossfadeMs.
+  // A fade already running keeps the length it started with.
+  void setDrumEngineCrossfadeMs(float ms);
   std::string currentDrumEngineName() const;
+  // Plays drum hits from pre-rendered buffers of up to maxSamples in total,
+  // keeping `takes` renders of each hit. Returns false if the memory is not
+  // available, in which case every hit keeps being synthesized. Call
+  // before audio starts.
+  bool enableDrumHitCache(size_t maxSamples, int takes = 1);
+  // Runs every 303 voice's filter and distortion at 1x, 2x or 4x the
+  // sample rate. Allocates, so call it under the audio guard.
+  void set303Oversampling(int factor);
+  int oversampling303() const;
   std::string currentSceneName() const;
   std::vector<std::string> availableSceneNames() const;
   bool loadSceneByName(const std::string& name);
@@ -147,6 +441,8 @@ public:
   void toggleMuteClap();
   void toggleDelay303(int voiceIndex = 0);
   void toggleDistortion303(int voiceIndex = 0);
+  void setDelay303Enabled(int voiceIndex, bool enabled);
+  void setDistortion303Enabled(int voiceIndex, bool enabled);
   void setDrumPatternIndex(int patternIndex);
   void shiftDrumPatternIndex(int delta);
   void setDrumBankIndex(int bankIndex);
@@ -158,9 +454,15 @@ public:
   void adjust303StepNote(int voiceIndex, int stepIndex, int semitoneDelta);
   void adjust303StepOctave(int voiceIndex, int stepIndex, int octaveDelta);
   void clear303StepNote(int voiceIndex, int stepIndex);
+  // Sets the step to `note`, clamped to the 303 range; a negative note
+  // makes it a rest.
+  void set303StepNote(int voiceIndex, int stepIndex, int note);
   void toggle303AccentStep(int voiceIndex, int stepIndex);
+  void set303AccentStep(int voiceIndex, int stepIndex, bool accent);
   void toggle303SlideStep(int voiceIndex, int stepIndex);
+  void set303SlideStep(int voiceIndex, int stepIndex, bool slide);
   void toggleDrumStep(int voiceIndex, int stepIndex);
+  void setDrumStep(int voiceIndex, int stepIndex, bool hit);
   void toggleDrumAccentStep(int stepIndex);
   void setDrumAccentStep(int voiceIndex, int stepIndex, bool accent);
 
@@ -171,13 +473,71 @@ public:
   void setParameter(MiniAcidParamId id, float value);
   void adjustParameter(MiniAcidParamId id, int steps);
 
+  // Queues an edit for the audio thread, which applies queued commands in
+  // order at the start of its next block. Lock-free, for one UI thread;
+  // returns false, dropping the edit, if kCommandQueueSize are pending.
+  bool post(const EngineCommand& cmd);
+  // Sequence number of the last command post() accepted. Pass it to
+  // commandApplied() to learn when the getters reflect that edit.
+  uint32_t lastPostedCommand() const;
+  bool commandApplied(uint32_t sequence) const;
+  // Commands post() has dropped so far, for the UI to report.
+  uint32_t droppedCommandCount() const;
+  // Applies every posted command and publishes the result to the UI
+  // getters. generateAudioBuffer() does this itself; a host that stops
+  // rendering while the transport is stopped calls it from the audio thread
+  // instead.
+  void processCommands();
+  // Renders the drum bus, and the 303 voices from kFirstHelper303Voice up,
+  // on split's helper while the calling thread renders the other 303
+  // voices. The output is the same as with nullptr, which renders
+  // everything on the calling thread. Call before audio starts.
+  void setRenderSplit(RenderSplit* split);
+  // Renders the drum bus and each 303 voice as separate jobs on pool,
+  // then mixes them on the calling thread; takes over from any split.
+  // The output is again the same as rendering inline. Allocates the
+  // per-voice buses, so call before audio starts.
+  void setRenderPool(RenderPool* pool);
+
   void generateAudioBuffer(int16_t *buffer, size_t numSamples);
 
 private:
+  // Covers a full song-area paste: three tracks of every song position.
+  static constexpr size_t kCommandQueueSize = 512;
+  // The helper side of a split render gets the drums and just under half
+  // of the 303 pool; with the two scene voices that is no 303 at all.
+  static constexpr int kFirstHelper303Voice = NUM_303_VOICES - (NUM_303_VOICES - 1) / 2;
+
+  void drainCommands();
+  void applyCommand(const EngineCommand& cmd);
+  // Copies the UI-visible state into uiState_ for the UI thread.
+  void publishUiState();
+  const EngineUiState& uiState() const;
   void updateSamplesPerStep();
+  unsigned long samplesUntilNextStep() const;
   void advanceStep();
+  void renderBlock(int16_t *buffer, size_t numSamples, bool isPlaying);
+  // Drum kit, fading kits and cached hits into mixBuffer_.
+  void renderDrumBus(size_t numSamples, uint16_t drumMask);
+  // Sum of 303 voices [first, last) into out, using scratch per voice.
+  void render303Voices(int first, int last, uint32_t activeMask, float* scratch, float* out,
+                       size_t numSamples);
+  static void renderHelperJob(void* context);
+  // Voice v alone, in place in out.
+  void render303Voice(int v, float* out, size_t numSamples);
+  // Job 0 is the drum bus, job v + 1 the 303 voice v.
+  static void renderBusJob(void* context, int index);
+  void setDrumEngineIndex(int engineIndex);
+  void applyPendingDrumEngine(bool crossfade);
+  void stopDrumFades();
+  void bindDrumHitCache();
+  void triggerDrum(DrumVoiceId id, bool accent);
   float noteToFreq(int note);
   int clamp303Voice(int voiceIndex) const;
+  bool isScene303Voice(int voiceIndex) const;
+  // Bit v is set while voice v or its delay tail can still make a sound.
+  uint32_t active303VoiceMask() const;
+  SongTrack synthTrack(int voiceIndex) const;
   int clamp303Step(int stepIndex) const;
   int clamp303Note(int note) const;
   const SynthPattern& synthPattern(int synthIndex) const;
@@ -185,8 +545,6 @@ private:
   const DrumPattern& drumPattern(int drumVoiceIndex) const;
   DrumPattern& editDrumPattern(int drumVoiceIndex);
   int clampDrumVoice(int voiceIndex) const;
-  void refreshSynthCaches(int synthIndex) const;
-  void refreshDrumCache(int drumVoiceIndex) const;
   const SynthPattern& activeSynthPattern(int synthIndex) const;
   const DrumPattern& activeDrumPattern(int drumVoiceIndex) const;
   int songPatternIndexForTrack(SongTrack track) const;
@@ -194,11 +552,37 @@ private:
   void advanceSongPlayhead();
   int clampSongPosition(int position) const;
 
-  TB303Voice voice303;
-  TB303Voice voice3032;
-  std::unique_ptr<DrumSynthVoice> drums;
+  TB303Voice voices303_[NUM_303_VOICES];
+  // Every kit is built once with the engine, so switching kits only flips
+  // pointers and the audio thread never waits on the heap.
+  TR808DrumSynthVoice drums808_;
+  TR909DrumSynthVoice drums909_;
+  TR606DrumSynthVoice drums606_;
+  DrumSynthVoice* drums;                       // owned by the audio thread
+  std::atomic<DrumSynthVoice*> pendingDrums_;  // next kit, or nullptr
+  // A kit ringing out after a switch. The gain falls by gainStep a sample,
+  // fixed when the fade started, and the kit is dropped at zero.
+  struct DrumFade {
+    DrumSynthVoice* kit;
+    size_t remaining;
+    float gainStep;
+  };
+  // Two slots hold both kits that are not playing, so a quick switch never
+  // cuts a tail short.
+  DrumFade drumFades_[2];
+  // Gain still to make up on the current kit when it was picked again
+  // before its own fade had finished.
+  size_t drumRiseRemaining_;
+  float drumRiseStep_;
+  float drumFadeMs_;
+  size_t drumFadeSamples_;
+  // Spare kits the hit cache renders on, one per kit type.
+  TR808DrumSynthVoice drumHitScratch808_;
+  TR909DrumSynthVoice drumHitScratch909_;
+  TR606DrumSynthVoice drumHitScratch606_;
+  DrumHitCache drumHits_;
   float sampleRateValue;
-  std::string drumEngineName_;
+  int drumEngineIndex_; // into getAvailableDrumEngines()
 
   SceneManager sceneManager_;
   SceneStorage* sceneStorage_;
@@ -208,27 +592,42 @@ private:
   mutable bool drumHitCache_[NUM_DRUM_VOICES][SEQ_STEPS];
   mutable bool drumAccentCache_[NUM_DRUM_VOICES][SEQ_STEPS];
   mutable bool drumStepAccentCache_[SEQ_STEPS];
+  // Audio thread to UI; see publishUiState(). The UI keeps its own copies
+  // of the 303 parameters, with their values taken from the snapshot.
+  mutable TripleBuffer<EngineUiState> uiState_;
+  mutable Parameter uiParams303_[NUM_303_VOICES][static_cast<int>(TB303ParamId::Count)];
+  mutable Song uiSong_;
 
-  volatile bool playing;
-  volatile bool mute303;
-  volatile bool mute303_2;
-  volatile bool muteKick;
-  volatile bool muteSnare;
-  volatile bool muteHat;
-  volatile bool muteOpenHat;
-  volatile bool muteMidTom;
-  volatile bool muteHighTom;
-  volatile bool muteRim;
-  volatile bool muteClap;
-  volatile bool delay303Enabled;
-  volatile bool delay3032Enabled;
-  volatile bool distortion303Enabled;
-  volatile bool distortion3032Enabled;
-  volatile float bpmValue;
-  volatile int currentStepIndex;
+  SpscQueue<EngineCommand, kCommandQueueSize> commands_;
+  uint32_t postedCommands_;   // posting thread only
+  uint32_t droppedCommands_;  // posting thread only
+  uint32_t appliedCommands_;  // audio thread only
+  RenderSplit* renderSplit_;
+  RenderPool* renderPool_;
+  std::vector<float> voiceBuses_; // AUDIO_BUFFER_SAMPLES per 303 voice
+  // What the helper or the pool jobs render for the current sub-block.
+  size_t helperSamples_;
+  uint16_t helperDrumMask_;
+  uint32_t helperSynthMask_;
+  // Written by the audio thread (or before it starts), read by the UI.
+  std::atomic<bool> playing;
+  std::atomic<bool> mute303_[NUM_303_VOICES];
+  std::atomic<bool> muteKick;
+  std::atomic<bool> muteSnare;
+  std::atomic<bool> muteHat;
+  std::atomic<bool> muteOpenHat;
+  std::atomic<bool> muteMidTom;
+  std::atomic<bool> muteHighTom;
+  std::atomic<bool> muteRim;
+  std::atomic<bool> muteClap;
+  std::atomic<bool> delay303Enabled_[NUM_303_VOICES];
+  std::atomic<bool> distortion303Enabled_[NUM_303_VOICES];
+  std::atomic<float> bpmValue;
+  std::atomic<int> currentStepIndex;
   unsigned long samplesIntoStep;
   float samplesPerStep;
   bool songMode_;
+  bool tailOnly_; // see releaseForTail()
   int drumCycleIndex_;
   int songPlayheadPosition_;
   int patternModeDrumPatternIndex_;
@@ -236,12 +635,21 @@ private:
   int patternModeSynthPatternIndex_[NUM_303_VOICES];
   int patternModeSynthBankIndex_[NUM_303_VOICES];
 
-  TempoDelay delay303;
-  TempoDelay delay3032;
-  TubeDistortion distortion303;
-  TubeDistortion distortion3032;
-  int16_t lastBuffer[AUDIO_BUFFER_SAMPLES];
-  size_t lastBufferCount;
+  TempoDelay delays303_[NUM_303_VOICES];
+  TubeDistortion distortions303_[NUM_303_VOICES];
+  // Patterns for the pool voices past the scene's synth tracks; the first
+  // NUM_SCENE_303_VOICES entries are unused.
+  SynthPattern extraSynthPatterns_[NUM_303_VOICES];
+  // Scratch buses for renderBlock(), kept off the audio task's small stack.
+  float mixBuffer_[AUDIO_BUFFER_SAMPLES];
+  float synthBuffer_[AUDIO_BUFFER_SAMPLES];
+  float voiceBuffer_[AUDIO_BUFFER_SAMPLES];
+  float drumTailBuffer_[AUDIO_BUFFER_SAMPLES];
+  // The helper's 303 voices sum here, apart from the caller's synthBuffer_.
+  float helperSynthBuffer_[AUDIO_BUFFER_SAMPLES];
+  float helperVoiceBuffer_[AUDIO_BUFFER_SAMPLES];
+  ScopeRing<SCOPE_SAMPLES> scope_;
+  RandomGenerator patternRng_; // for randomize303Pattern() and randomizeDrumPattern()
 
   void loadSceneFromStorage();
   void saveSceneToStorage();
@@ -253,8 +661,11 @@ private:
 
 class PatternGenerator {
 public:
-  static void generateRandom303Pattern(SynthPattern& pattern);
-  static void generateRandomDrumPattern(DrumPatternSet& patternSet);
+  static constexpr int kDorianIntervals[7] = {0, 2, 3, 5, 7, 9, 10};
+  static constexpr int kPhrygianIntervals[7] = {0, 1, 3, 5, 7, 8, 10};
+
+  static void generateRandom303Pattern(SynthPattern& pattern, RandomGenerator& rng);
+  static void generateRandomDrumPattern(DrumPatternSet& patternSet, RandomGenerator& rng);
 };
 
 inline Parameter& MiniAcid::miniParameter(MiniAcidParamId id) {
@@ -0,0 +1,309 @@
+#include "osc_bank.h"
+
+#include "poly_blep.h"
+
+#if defined(MINIACID_NO_SIMD)
+#define OSC_BANK_SCALAR 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OSC_BANK_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define OSC_BANK_NEON 1
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define OSC_BANK_WASM 1
+#else
+#define OSC_BANK_SCALAR 1
+#endif
+
+void OscBank::clear() {
+  for (int i = 0; i < kLanes; ++i) {
+    phase[i] = 0.0f;
+    ratio[i] = 0.0f;
+    weight[i] = 0.0f;
+  }
+}
+
+namespace {
+// 1 / ratio per lane, 0 for unused lanes so their PolyBLEP windows are
+// empty.
+struct alignas(16) LaneReciprocals {
+  float value[OscBank::kLanes];
+};
+
+inline LaneReciprocals inverseRatios(const OscBank& bank) {
+  LaneReciprocals inv;
+  for (int i = 0; i < OscBank::kLanes; ++i)
+    inv.value[i] = bank.ratio[i] > 0.0f ? 1.0f / bank.ratio[i] : 0.0f;
+  return inv;
+}
+} // namespace
+
+#if defined(OSC_BANK_SSE)
+
+namespace {
+inline __m128 wrapPhase(__m128 p, __m128 one) {
+  return _mm_sub_ps(p, _mm_and_ps(_mm_cmpge_ps(p, one), one));
+}
+
+inline float horizontalSum(__m128 v) {
+  v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+  v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+  return _mm_cvtss_f32(v);
+}
+
+// Lane-wise polyBlep(), with invDt = 1 / dt.
+inline __m128 polyBlepLanes(__m128 t, __m128 dt, __m128 invDt, __m128 one) {
+  __m128 a = _mm_sub_ps(_mm_mul_ps(t, invDt), one);
+  __m128 b = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(t, one), invDt), one);
+  __m128 low = _mm_and_ps(_mm_cmplt_ps(t, dt), _mm_mul_ps(a, a));
+  __m128 high = _mm_and_ps(_mm_cmpgt_ps(t, _mm_sub_ps(one, dt)), _mm_mul_ps(b, b));
+  return _mm_sub_ps(high, low);
+}
+} // namespace
+
+void oscBankSaw(OscBank& bank, const float* inc, float* out, size_t numSamples) {
+  const __m128 one = _mm_set1_ps(1.0f);
+  __m128 p0 = _mm_load_ps(bank.phase);
+  __m128 p1 = _mm_load_ps(bank.phase + 4);
+  const __m128 r0 = _mm_load_ps(bank.ratio);
+  const __m128 r1 = _mm_load_ps(bank.ratio + 4);
+  const __m128 w0 = _mm_load_ps(bank.weight);
+  const __m128 w1 = _mm_load_ps(bank.weight + 4);
+#if MINIACID_POLYBLEP
+  const LaneReciprocals inv = inverseRatios(bank);
+  const __m128 v0 = _mm_load_ps(inv.value);
+  const __m128 v1 = _mm_load_ps(inv.value + 4);
+#endif
+  for (size_t k = 0; k < numSamples; ++k) {
+    __m128 step = _mm_set1_ps(inc[k]);
+    __m128 d0 = _mm_mul_ps(step, r0);
+    __m128 d1 = _mm_mul_ps(step, r1);
+    p0 = wrapPhase(_mm_add_ps(p0, d0), one);
+    p1 = wrapPhase(_mm_add_ps(p1, d1), one);
+    __m128 saw0 = _mm_sub_ps(_mm_add_ps(p0, p0), one);
+    __m128 saw1 = _mm_sub_ps(_mm_add_ps(p1, p1), one);
+#if MINIACID_POLYBLEP
+    __m128 invStep = _mm_set1_ps(1.0f / inc[k]);
+    saw0 = _mm_sub_ps(saw0, polyBlepLanes(p0, d0, _mm_mul_ps(invStep, v0), one));
+    saw1 = _mm_sub_ps(saw1, polyBlepLanes(p1, d1, _mm_mul_ps(invStep, v1), one));
+#endif
+    out[k] = horizontalSum(_mm_add_ps(_mm_mul_ps(saw0, w0), _mm_mul_ps(saw1, w1)));
+  }
+  _mm_store_ps(bank.phase, p0);
+  _mm_store_ps(bank.phase + 4, p1);
+}
+
+void oscBankSquare(OscBank& bank, float inc, float* out, size_t numSamples) {
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 half = _mm_set1_ps(0.5f);
+  const __m128 signBit = _mm_set1_ps(-0.0f);
+  const __m128 step = _mm_set1_ps(inc);
+  __m128 p0 = _mm_load_ps(bank.phase);
+  __m128 p1 = _mm_load_ps(bank.phase + 4);
+  const __m128 i0 = _mm_mul_ps(step, _mm_load_ps(bank.ratio));
+  const __m128 i1 = _mm_mul_ps(step, _mm_load_ps(bank.ratio + 4));
+  const __m128 w0 = _mm_load_ps(bank.weight);
+  const __m128 w1 = _mm_load_ps(bank.weight + 4);
+  for (size_t k = 0; k < numSamples; ++k) {
+    p0 = wrapPhase(_mm_add_ps(p0, i0), one);
+    p1 = wrapPhase(_mm_add_ps(p1, i1), one);
+    // Flip the weight's sign for the second half of each cycle.
+    __m128 s0 = _mm_xor_ps(w0, _mm_and_ps(_mm_cmpge_ps(p0, half), signBit));
+    __m128 s1 = _mm_xor_ps(w1, _mm_and_ps(_mm_cmpge_ps(p1, half), signBit));
+    out[k] = horizontalSum(_mm_add_ps(s0, s1));
+  }
+  _mm_store_ps(bank.phase, p0);
+  _mm_store_ps(bank.phase + 4, p1);
+}
+
+#elif defined(OSC_BANK_NEON)
+
+namespace {
+inline float32x4_t wrapPhase(float32x4_t p, float32x4_t one) {
+  uint32x4_t wrapped = vandq_u32(vcgeq_f32(p, one), vreinterpretq_u32_f32(one));
+  return vsubq_f32(p, vreinterpretq_f32_u32(wrapped));
+}
+
+inline float horizontalSum(float32x4_t v) {
+#if defined(__aarch64__)
+  return vaddvq_f32(v);
+#else
+  float32x2_t pair = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+  return vget_lane_f32(vpadd_f32(pair, pair), 0);
+#endif
+}
+
+// Lane-wise polyBlep(), with invDt = 1 / dt.
+inline float32x4_t polyBlepLanes(float32x4_t t, float32x4_t dt, float32x4_t invDt, float32x4_t one) {
+  float32x4_t a = vsubq_f32(vmulq_f32(t, invDt), one);
+  float32x4_t b = vaddq_f32(vmulq_f32(vsubq_f32(t, one), invDt), one);
+  uint32x4_t low = vandq_u32(vcltq_f32(t, dt), vreinterpretq_u32_f32(vmulq_f32(a, a)));
+  uint32x4_t high = vandq_u32(vcgtq_f32(t, vsubq_f32(one, dt)), vreinterpretq_u32_f32(vmulq_f32(b, b)));
+  return vsubq_f32(vreinterpretq_f32_u32(high), vreinterpretq_f32_u32(low));
+}
+} // namespace
+
+void oscBankSaw(OscBank& bank, const float* inc, float* out, size_t numSamples) {
+  const float32x4_t one = vdupq_n_f32(1.0f);
+  float32x4_t p0 = vld1q_f32(bank.phase);
+  float32x4_t p1 = vld1q_f32(bank.phase + 4);
+  const float32x4_t r0 = vld1q_f32(bank.ratio);
+  const float32x4_t r1 = vld1q_f32(bank.ratio + 4);
+  const float32x4_t w0 = vld1q_f32(bank.weight);
+  const float32x4_t w1 = vld1q_f32(bank.weight + 4);
+#if MINIACID_POLYBLEP
+  const LaneReciprocals inv = inverseRatios(bank);
+  const float32x4_t v0 = vld1q_f32(inv.value);
+  const float32x4_t v1 = vld1q_f32(inv.value + 4);
+#endif
+  for (size_t k = 0; k < numSamples; ++k) {
+    float32x4_t d0 = vmulq_n_f32(r0, inc[k]);
+    float32x4_t d1 = vmulq_n_f32(r1, inc[k]);
+    p0 = wrapPhase(vaddq_f32(p0, d0), one);
+    p1 = wrapPhase(vaddq_f32(p1, d1), one);
+    float32x4_t saw0 = vsubq_f32(vaddq_f32(p0, p0), one);
+    float32x4_t saw1 = vsubq_f32(vaddq_f32(p1, p1), one);
+#if MINIACID_POLYBLEP
+    float invStep = 1.0f / inc[k];
+    saw0 = vsubq_f32(saw0, polyBlepLanes(p0, d0, vmulq_n_f32(v0, invStep), one));
+    saw1 = vsubq_f32(saw1, polyBlepLanes(p1, d1, vmulq_n_f32(v1, invStep), one));
+#endif
+    out[k] = horizontalSum(vaddq_f32(vmulq_f32(saw0, w0), vmulq_f32(saw1, w1)));
+  }
+  vst1q_f32(bank.phase, p0);
+  vst1q_f32(bank.phase + 4, p1);
+}
+
+void oscBankSquare(OscBank& bank, float inc, float* out, size_t numSamples) {
+  const float32x4_t one = vdupq_n_f32(1.0f);
+  const float32x4_t half = vdupq_n_f32(0.5f);
+  const uint32x4_t signBit = vdupq_n_u32(0x80000000u);
+  float32x4_t p0 = vld1q_f32(bank.phase);
+  float32x4_t p1 = vld1q_f32(bank.phase + 4);
+  const float32x4_t i0 = vmulq_n_f32(vld1q_f32(bank.ratio), inc);
+  const float32x4_t i1 = vmulq_n_f32(vld1q_f32(bank.ratio + 4), inc);
+  const uint32x4_t w0 = vreinterpretq_u32_f32(vld1q_f32(bank.weight));
+  const uint32x4_t w1 = vreinterpretq_u32_f32(vld1q_f32(bank.weight + 4));
+  for (size_t k = 0; k < numSamples; ++k) {
+    p0 = wrapPhase(vaddq_f32(p0, i0), one);
+    p1 = wrapPhase(vaddq_f32(p1, i1), one);
+    // Flip the weight's sign for the second half of each cycle.
+    uint32x4_t s0 = veorq_u32(w0, vandq_u32(vcgeq_f32(p0, half), signBit));
+    uint32x4_t s1 = veorq_u32(w1, vandq_u32(vcgeq_f32(p1, half), signBit));
+    out[k] = horizontalSum(vaddq_f32(vreinterpretq_f32_u32(s0), vreinterpretq_f32_u32(s1)));
+  }
+  vst1q_f32(bank.phase, p0);
+  vst1q_f32(bank.phase + 4, p1);
+}
+
+#elif defined(OSC_BANK_WASM)
+
+namespace {
+inline v128_t wrapPhase(v128_t p, v128_t one) {
+  return wasm_f32x4_sub(p, wasm_v128_and(wasm_f32x4_ge(p, one), one));
+}
+
+inline float horizontalSum(v128_t v) {
+  return (wasm_f32x4_extract_lane(v, 0) + wasm_f32x4_extract_lane(v, 1)) +
+         (wasm_f32x4_extract_lane(v, 2) + wasm_f32x4_extract_lane(v, 3));
+}
+
+// Lane-wise polyBlep(), with invDt = 1 / dt.
+inline v128_t polyBlepLanes(v128_t t, v128_t dt, v128_t invDt, v128_t one) {
+  v128_t a = wasm_f32x4_sub(wasm_f32x4_mul(t, invDt), one);
+  v128_t b = wasm_f32x4_add(wasm_f32x4_mul(wasm_f32x4_sub(t, one), invDt), one);
+  v128_t low = wasm_v128_and(wasm_f32x4_lt(t, dt), wasm_f32x4_mul(a, a));
+  v128_t high = wasm_v128_and(wasm_f32x4_gt(t, wasm_f32x4_sub(one, dt)), wasm_f32x4_mul(b, b));
+  return wasm_f32x4_sub(high, low);
+}
+} // namespace
+
+void oscBankSaw(OscBank& bank, const float* inc, float* out, size_t numSamples) {
+  const v128_t one = wasm_f32x4_splat(1.0f);
+  v128_t p0 = wasm_v128_load(bank.phase);
+  v128_t p1 = wasm_v128_load(bank.phase + 4);
+  const v128_t r0 = wasm_v128_load(bank.ratio);
+  const v128_t r1 = wasm_v128_load(bank.ratio + 4);
+  const v128_t w0 = wasm_v128_load(bank.weight);
+  const v128_t w1 = wasm_v128_load(bank.weight + 4);
+#if MINIACID_POLYBLEP
+  const LaneReciprocals inv = inverseRatios(bank);
+  const v128_t v0 = wasm_v128_load(inv.value);
+  const v128_t v1 = wasm_v128_load(inv.value + 4);
+#endif
+  for (size_t k = 0; k < numSamples; ++k) {
+    v128_t step = wasm_f32x4_splat(inc[k]);
+    v128_t d0 = wasm_f32x4_mul(step, r0);
+    v128_t d1 = wasm_f32x4_mul(step, r1);
+    p0 = wrapPhase(wasm_f32x4_add(p0, d0), one);
+    p1 = wrapPhase(wasm_f32x4_add(p1, d1), one);
+    v128_t saw0 = wasm_f32x4_sub(wasm_f32x4_add(p0, p0), one);
+    v128_t saw1 = wasm_f32x4_sub(wasm_f32x4_add(p1, p1), one);
+#if MINIACID_POLYBLEP
+    v128_t invStep = wasm_f32x4_splat(1.0f / inc[k]);
+    saw0 = wasm_f32x4_sub(saw0, polyBlepLanes(p0, d0, wasm_f32x4_mul(invStep, v0), one));
+    saw1 = wasm_f32x4_sub(saw1, polyBlepLanes(p1, d1, wasm_f32x4_mul(invStep, v1), one));
+#endif
+    out[k] = horizontalSum(wasm_f32x4_add(wasm_f32x4_mul(saw0, w0), wasm_f32x4_mul(saw1, w1)));
+  }
+  wasm_v128_store(bank.phase, p0);
+  wasm_v128_store(bank.phase + 4, p1);
+}
+
+void oscBankSquare(OscBank& bank, float inc, float* out, size_t numSamples) {
+  const v128_t one = wasm_f32x4_splat(1.0f);
+  const v128_t half = wasm_f32x4_splat(0.5f);
+  const v128_t signBit = wasm_f32x4_splat(-0.0f);
+  const v128_t step = wasm_f32x4_splat(inc);
+  v128_t p0 = wasm_v128_load(bank.phase);
+  v128_t p1 = wasm_v128_load(bank.phase + 4);
+  const v128_t i0 = wasm_f32x4_mul(step, wasm_v128_load(bank.ratio));
+  const v128_t i1 = wasm_f32x4_mul(step, wasm_v128_load(bank.ratio + 4));
+  const v128_t w0 = wasm_v128_load(bank.weight);
+  const v128_t w1 = wasm_v128_load(bank.weight + 4);
+  for (size_t k = 0; k < numSamples; ++k) {
+    p0 = wrapPhase(wasm_f32x4_add(p0, i0), one);
+    p1 = wrapPhase(wasm_f32x4_add(p1, i1), one);
+    // Flip the weight's sign for the second half of each cycle.
+    v128_t s0 = wasm_v128_xor(w0, wasm_v128_and(wasm_f32x4_ge(p0, half), signBit));
+    v128_t s1 = wasm_v128_xor(w1, wasm_v128_and(wasm_f32x4_ge(p1, half), signBit));
+    out[k] = horizontalSum(wasm_f32x4_add(s0, s1));
+  }
+  wasm_v128_store(bank.phase, p0);
+  wasm_v128_store(bank.phase + 4, p1);
+}
+
+#else
+
+void oscBankSaw(OscBank& bank, const float* inc, float* out, size_t numSamples) {
+  for (size_t k = 0; k < numSamples; ++k) {
+    float sum = 0.0f;
+    for (int i = 0; i < OscBank::kLanes; ++i) {
+      float dt = inc[k] * bank.ratio[i];
+      float p = bank.phase[i] + dt;
+      if (p >= 1.0f) p -= 1.0f;
+      bank.phase[i] = p;
+      sum += bandLimitedSaw(p, dt) * bank.weight[i];
+    }
+    out[k] = sum;
+  }
+}
+
+void oscBankSquare(OscBank& bank, float inc, float* out, size_t numSamples) {
+  float laneInc[OscBank::kLanes];
+  for (int i = 0; i < OscBank::kLanes; ++i) laneInc[i] = inc * bank.ratio[i];
+  for (size_t k = 0; k < numSamples; ++k) {
+    float sum = 0.0f;
+    for (int i = 0; i < OscBank::kLanes; ++i) {
+      float p = bank.phase[i] + laneInc[i];
+      if (p >= 1.0f) p -= 1.0f;
+      bank.phase[i] = p;
+      sum += p < 0.5f ? bank.weight[i] : -bank.weight[i];
+    }
+    out[k] = sum;
+  }
+}
+
+#endif
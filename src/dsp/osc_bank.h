@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stddef.h>
+
+// A bank of free-running phase accumulators laid out as two 4-wide vectors,
+// so the supersaw and the metallic drum oscillators advance all partials in
+// SIMD lanes (SSE2, NEON or WASM SIMD, with a scalar fallback elsewhere,
+// including the ESP32). Unused lanes get a zero ratio and weight.
+struct alignas(16) OscBank {
+  static constexpr int kLanes = 8;
+
+  float phase[kLanes];  // 0..1
+  float ratio[kLanes];  // lane increment = base increment * ratio
+  float weight[kLanes]; // lane gain in the summed output
+
+  void clear();
+};
+
+// Advances each lane by inc[k] * ratio and writes the weighted sum of the
+// bipolar saws (2 * phase - 1) to out[k], PolyBLEP-corrected per lane
+// unless MINIACID_POLYBLEP is 0. inc[k] must be positive.
+void oscBankSaw(OscBank& bank, const float* inc, float* out, size_t numSamples);
+
+// Advances each lane by inc * ratio and writes the weighted sum of the
+// bipolar squares (+1 for the first half of the cycle) to out[k].
+void oscBankSquare(OscBank& bank, float inc, float* out, size_t numSamples);
@@ -0,0 +1,118 @@
+#include "oversampler.h"
+
+#include <algorithm>
+
+namespace {
+// Blackman-windowed half-band taps at offsets 1, 3, 5, ... from the centre
+// (whose tap is 0.5), normalised to unity gain at DC.
+const float kHalfbandTaps[HalfbandStage::kHalfTaps] = {
+  3.093908185e-01f,
+  -8.205419077e-02f,
+  3.055753345e-02f,
+  -1.006078051e-02f,
+  2.349427474e-03f,
+  -1.828081641e-04f,
+};
+} // namespace
+
+void HalfbandStage::configure(size_t maxInput, bool extraDelay) {
+  work_.assign(kDownHistory + 2 * maxInput, 0.0f);
+  downCentre_ = extraDelay ? 2 * kHalfTaps - 1 : 2 * kHalfTaps;
+}
+
+void HalfbandStage::reset() {
+  std::fill(work_.begin(), work_.end(), 0.0f);
+}
+
+void HalfbandStage::upsample(const float* in, float* out, size_t n) {
+  // work_ holds the last kUpHistory inputs, then this block. Output pair m
+  // is centred kHalfTaps samples behind input m.
+  float* w = work_.data();
+  std::copy(in, in + n, w + kUpHistory);
+  for (size_t m = 0; m < n; ++m) {
+    const float* x = w + kHalfTaps - 1 + m;
+    float odd = 0.0f;
+    for (int i = 0; i < kHalfTaps; ++i)
+      odd += kHalfbandTaps[i] * (x[-i] + x[i + 1]);
+    out[2 * m] = x[0];
+    out[2 * m + 1] = 2.0f * odd;
+  }
+  std::copy(w + n, w + n + kUpHistory, w);
+}
+
+void HalfbandStage::downsample(const float* in, float* out, size_t n) {
+  // work_ holds the last kDownHistory inputs, then this block; only the
+  // even taps around each kept sample need multiplying.
+  float* w = work_.data();
+  std::copy(in, in + 2 * n, w + kDownHistory);
+  for (size_t m = 0; m < n; ++m) {
+    const float* x = w + downCentre_ + 2 * m;
+    float sum = 0.5f * x[0];
+    for (int i = 0; i < kHalfTaps; ++i)
+      sum += kHalfbandTaps[i] * (x[-2 * i - 1] + x[2 * i + 1]);
+    out[m] = sum;
+  }
+  std::copy(w + 2 * n, w + 2 * n + kDownHistory, w);
+}
+
+Oversampler::Oversampler() : factor_(1) {}
+
+void Oversampler::configure(int factor, size_t maxBlock) {
+  if (factor >= 4) factor = 4;
+  else if (factor >= 2) factor = 2;
+  else factor = 1;
+  factor_ = factor;
+  // Factor 1 never touches the stages, so drop their memory.
+  for (int s = 0; s < 2; ++s) {
+    up_[s] = HalfbandStage();
+    down_[s] = HalfbandStage();
+  }
+  mid_.clear();
+  mid_.shrink_to_fit();
+  if (factor_ >= 2) {
+    up_[0].configure(maxBlock);
+    down_[0].configure(maxBlock, factor_ == 4);
+  }
+  if (factor_ == 4) {
+    up_[1].configure(2 * maxBlock);
+    down_[1].configure(2 * maxBlock);
+    mid_.assign(2 * maxBlock, 0.0f);
+  }
+}
+
+void Oversampler::reset() {
+  for (int s = 0; s < 2; ++s) {
+    up_[s].reset();
+    down_[s].reset();
+  }
+}
+
+void Oversampler::upsample(const float* in, float* out, size_t n) {
+  switch (factor_) {
+    case 4:
+      up_[0].upsample(in, mid_.data(), n);
+      up_[1].upsample(mid_.data(), out, 2 * n);
+      break;
+    case 2:
+      up_[0].upsample(in, out, n);
+      break;
+    default:
+      std::copy(in, in + n, out);
+      break;
+  }
+}
+
+void Oversampler::downsample(const float* in, float* out, size_t n) {
+  switch (factor_) {
+    case 4:
+      down_[1].downsample(in, mid_.data(), 2 * n);
+      down_[0].downsample(mid_.data(), out, n);
+      break;
+    case 2:
+      down_[0].downsample(in, out, n);
+      break;
+    default:
+      std::copy(in, in + n, out);
+      break;
+  }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+// One 2x step of an oversampler: a 23-tap half-band lowpass run in
+// polyphase form, so every other tap (all zero but the centre) is skipped.
+// Flat to 0.15 of the high rate, -54 dB from 0.35 on.
+class HalfbandStage {
+public:
+  static constexpr int kHalfTaps = 6; // nonzero taps on each side of centre
+
+  // extraDelay makes downsample() keep the high-rate sample one step
+  // older, so that a 4x cascade delays by a whole number of base-rate
+  // samples.
+  void configure(size_t maxInput, bool extraDelay = false);
+  void reset();
+  // n samples in, 2n out.
+  void upsample(const float* in, float* out, size_t n);
+  // 2n samples in, n out.
+  void downsample(const float* in, float* out, size_t n);
+
+private:
+  static constexpr int kUpHistory = 2 * kHalfTaps - 1;
+  static constexpr int kDownHistory = 4 * kHalfTaps - 2;
+
+  std::vector<float> work_; // history followed by the current block
+  int downCentre_ = 2 * kHalfTaps; // work_ index of the first decimated sample
+};
+
+// Runs a nonlinear stage at 2x or 4x the base rate: upsample() a block,
+// process the factor() times longer result, then downsample() it back.
+// A round trip delays the signal by 2 * kHalfTaps - 1 base-rate samples at
+// 2x and 3 * kHalfTaps - 1 at 4x. Factor 1 passes samples straight through
+// and holds no buffers.
+class Oversampler {
+public:
+  static constexpr int kMaxFactor = 4;
+
+  Oversampler();
+  // Allocates for blocks of up to maxBlock base-rate samples; factor is
+  // 1, 2 or 4. Not for the audio thread.
+  void configure(int factor, size_t maxBlock);
+  int factor() const { return factor_; }
+  void reset();
+  // n base-rate samples in, n * factor() out.
+  void upsample(const float* in, float* out, size_t n);
+  // n * factor() samples in, n base-rate samples out.
+  void downsample(const float* in, float* out, size_t n);
+
+private:
+  int factor_;
+  HalfbandStage up_[2];
+  HalfbandStage down_[2];
+  std::vector<float> mid_; // the 2x signal between the two 4x stages
+};
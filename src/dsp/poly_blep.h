@@ -0,0 +1,49 @@
+#pragma once
+
+// Band-limited steps for the saw and square oscillators. A naive saw or
+// square jumps within one sample, and at 22.05 kHz the harmonics above
+// Nyquist fold back as loud inharmonic aliases. PolyBLEP replaces the
+// sample on each side of a jump with a 2-sample polynomial step, which
+// removes most of that energy for a few multiplies per discontinuity.
+//
+// Building with MINIACID_POLYBLEP=0 brings back the naive waveforms, e.g.
+// to A/B the two.
+#ifndef MINIACID_POLYBLEP
+#define MINIACID_POLYBLEP 1
+#endif
+
+// Correction around phase 0 for a 0..1 phase t advancing dt per sample.
+// Subtract it from a waveform that drops by 2 there, such as 2 * t - 1.
+inline float polyBlep(float t, float dt) {
+  if (t < dt) {
+    float x = t / dt - 1.0f;
+    return -x * x;
+  }
+  if (t > 1.0f - dt) {
+    float x = (t - 1.0f) / dt + 1.0f;
+    return x * x;
+  }
+  return 0.0f;
+}
+
+inline float bandLimitedSaw(float t, float dt) {
+#if MINIACID_POLYBLEP
+  return 2.0f * t - 1.0f - polyBlep(t, dt);
+#else
+  (void)dt;
+  return 2.0f * t - 1.0f;
+#endif
+}
+
+// -1 for the first half of the cycle, +1 for the second.
+inline float bandLimitedSquare(float t, float dt) {
+  float naive = t >= 0.5f ? 1.0f : -1.0f;
+#if MINIACID_POLYBLEP
+  float half = t + 0.5f;
+  if (half >= 1.0f) half -= 1.0f;
+  return naive - polyBlep(t, dt) + polyBlep(half, dt);
+#else
+  (void)dt;
+  return naive;
+#endif
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+
+// Small xorshift generator, standing in for rand() wherever the engine needs
+// noise or random patterns. Each owner keeps its own, so engines on
+// different threads never share (or race on) a sequence, and a fresh
+// engine always produces the same output. Values match rand()'s range on
+// glibc: 0 to kMax.
+class RandomGenerator {
+public:
+  static constexpr uint32_t kMax = 0x7fffffffu;
+
+  explicit RandomGenerator(uint32_t seed = 1) { setSeed(seed); }
+
+  void setSeed(uint32_t seed) { state_ = seed ? seed : 0x9e3779b9u; }
+
+  uint32_t next() {
+    uint32_t x = state_;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    state_ = x;
+    return x >> 1;
+  }
+  // 0 to n - 1, like rand() % n.
+  int below(int n) { return static_cast<int>(next() % static_cast<uint32_t>(n)); }
+  // -1 to 1.
+  float bipolar() { return static_cast<float>(next()) / static_cast<float>(kMax) * 2.0f - 1.0f; }
+
+private:
+  uint32_t state_;
+};
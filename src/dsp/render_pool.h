@@ -0,0 +1,14 @@
+#pragma once
+
+// Runs a batch of independent render jobs, such as one per bus, across a
+// set of threads. run() is a fork-join: it returns once every job has
+// finished, and the calling thread takes jobs too instead of idling.
+class RenderPool {
+public:
+  using Job = void (*)(void* context, int index);
+
+  virtual ~RenderPool() = default;
+  // Calls job(context, i) once for every i in [0, count). Jobs are handed
+  // out in index order, so put the longest ones first.
+  virtual void run(Job job, void* context, int count) = 0;
+};
@@ -0,0 +1,17 @@
+#pragma once
+
+// Runs part of each audio block on a second core. The audio thread calls
+// fork() with a job, renders its own share, then join()s before mixing the
+// two. One job is outstanding at a time and both calls come from the audio
+// thread, so an implementation is a pair of one-shot signals: a start for
+// the helper and a done for the caller.
+class RenderSplit {
+public:
+  using Job = void (*)(void* context);
+
+  virtual ~RenderSplit() = default;
+  // Hands job to the helper and returns without waiting for it.
+  virtual void fork(Job job, void* context) = 0;
+  // Returns once the job from the last fork() has finished.
+  virtual void join() = 0;
+};
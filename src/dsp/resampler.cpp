@@ -0,0 +1,143 @@
+#include "resampler.h"
+
+#include <math.h>
+#include <algorithm>
+
+namespace {
+constexpr double kPi = 3.14159265358979323846;
+
+struct QualitySettings {
+  size_t taps;
+  int phases;
+  double kaiserBeta;
+  double rolloff; // passband edge as a fraction of the lower Nyquist
+};
+
+const QualitySettings kQualitySettings[] = {
+  {8, 32, 5.0, 0.80},
+  {16, 64, 7.0, 0.88},
+  {32, 128, 9.0, 0.93},
+};
+
+// Zeroth-order modified Bessel function of the first kind, for the Kaiser
+// window; the series converges long before 32 terms for beta <= 9.
+double besselI0(double x) {
+  double term = 1.0;
+  double sum = 1.0;
+  double q = x * x * 0.25;
+  for (int k = 1; k < 32; ++k) {
+    term *= q / (static_cast<double>(k) * k);
+    sum += term;
+  }
+  return sum;
+}
+} // namespace
+
+PolyphaseResampler::PolyphaseResampler()
+  : taps_(0), phases_(0), bypass_(true), step_(1.0), pos_(0.0), size_(0) {}
+
+void PolyphaseResampler::configure(float inputRate, float outputRate, Quality quality,
+                                   size_t maxInputBlock) {
+  bypass_ = inputRate <= 0.0f || outputRate <= 0.0f || inputRate == outputRate;
+  step_ = bypass_ ? 1.0 : static_cast<double>(inputRate) / outputRate;
+  const QualitySettings& q = kQualitySettings[static_cast<int>(quality)];
+  // Going down in rate narrows the cutoff, so widen the filter to match
+  // and keep the same transition band relative to the output.
+  taps_ = bypass_ ? 0 : q.taps * static_cast<size_t>(step_ > 1.0 ? ceil(step_) : 1.0);
+  phases_ = bypass_ ? 0 : q.phases;
+  buffer_.assign(taps_ + maxInputBlock, 0.0f);
+  coeffs_.clear();
+  if (!bypass_) {
+    // Cutoff in cycles per input sample, below whichever Nyquist is lower.
+    double cutoff = 0.5 * q.rolloff * (step_ > 1.0 ? 1.0 / step_ : 1.0);
+    double half = static_cast<double>(taps_) * 0.5;
+    double norm = besselI0(q.kaiserBeta);
+    coeffs_.assign((static_cast<size_t>(phases_) + 1) * taps_, 0.0f);
+    std::vector<double> taps(taps_);
+    for (int p = 0; p <= phases_; ++p) {
+      float* row = &coeffs_[static_cast<size_t>(p) * taps_];
+      double frac = static_cast<double>(p) / phases_;
+      double sum = 0.0;
+      for (size_t k = 0; k < taps_; ++k) {
+        // Distance from tap k to the output's position, which sits frac
+        // past the centre of the taps.
+        double t = static_cast<double>(k) - (half - 1.0) - frac;
+        double x = 2.0 * cutoff * t;
+        double sinc = t == 0.0 ? 1.0 : sin(kPi * x) / (kPi * x);
+        double r = t / half;
+        double window = r * r < 1.0 ? besselI0(q.kaiserBeta * sqrt(1.0 - r * r)) / norm : 0.0;
+        taps[k] = sinc * window;
+        sum += taps[k];
+      }
+      // Unity gain at DC for every phase, so slow signals carry no ripple
+      // at the phase rate.
+      for (size_t k = 0; k < taps_; ++k)
+        row[k] = static_cast<float>(taps[k] / sum);
+    }
+  }
+  reset();
+}
+
+void PolyphaseResampler::reset() {
+  std::fill(buffer_.begin(), buffer_.end(), 0.0f);
+  // Start with the taps before the first input sample zeroed, so output 0
+  // lines up with input 0.
+  size_ = taps_ > 0 ? taps_ / 2 - 1 : 0;
+  pos_ = 0.0;
+}
+
+void PolyphaseResampler::write(const float* in, size_t n) {
+  size_t consumed = static_cast<size_t>(pos_);
+  if (consumed > size_) consumed = size_;
+  std::copy(buffer_.begin() + consumed, buffer_.begin() + size_, buffer_.begin());
+  size_ -= consumed;
+  pos_ -= static_cast<double>(consumed);
+  if (n > buffer_.size() - size_) n = buffer_.size() - size_;
+  std::copy(in, in + n, buffer_.begin() + size_);
+  size_ += n;
+}
+
+int PolyphaseResampler::phaseRow(double frac, int phases, float& blend) {
+  double phase = frac * phases;
+  int p = static_cast<int>(phase);
+  // A fraction a hair under 1 can still land on the last row's far edge;
+  // blend all the way to the extra row rather than start one past it.
+  if (p >= phases) {
+    blend = 1.0f;
+    return phases - 1;
+  }
+  blend = static_cast<float>(phase - p);
+  return p;
+}
+
+size_t PolyphaseResampler::read(float* out, size_t n) {
+  if (bypass_) {
+    size_t start = static_cast<size_t>(pos_);
+    size_t count = std::min(n, size_ - start);
+    std::copy(buffer_.begin() + start, buffer_.begin() + start + count, out);
+    pos_ += static_cast<double>(count);
+    return count;
+  }
+  const float* coeffs = coeffs_.data();
+  const float* buffer = buffer_.data();
+  size_t produced = 0;
+  while (produced < n) {
+    size_t i = static_cast<size_t>(pos_);
+    if (i + taps_ > size_)
+      break;
+    float blend;
+    int p = phaseRow(pos_ - static_cast<double>(i), phases_, blend);
+    const float* a = coeffs + static_cast<size_t>(p) * taps_;
+    const float* b = a + taps_;
+    const float* x = buffer + i;
+    float sumA = 0.0f;
+    float sumB = 0.0f;
+    for (size_t k = 0; k < taps_; ++k) {
+      sumA += a[k] * x[k];
+      sumB += b[k] * x[k];
+    }
+    out[produced++] = sumA + (sumB - sumA) * blend;
+    pos_ += step_;
+  }
+  return produced;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Streaming sample-rate converter for running the engine at one rate and
+// an audio device at another. The host pushes engine blocks with write()
+// and pulls device samples with read(), which stops short once the
+// buffered input runs out; alternating the two keeps the delay fixed at
+// latency() input samples plus at most one block.
+//
+// The filter is a Kaiser-windowed sinc stored as a bank of fractional-delay
+// phases. Each output blends the two phases either side of its position, so
+// any pair of rates works without a table per rate ratio.
+class PolyphaseResampler {
+public:
+  // Taps per output sample: 8, 16 or 32, times the rate ratio (rounded
+  // up) when converting down.
+  enum class Quality : uint8_t {
+    Low = 0,
+    Medium,
+    High,
+  };
+
+  PolyphaseResampler();
+  // Converts inputRate to outputRate, taking write() blocks of up to
+  // maxInputBlock samples. Equal rates pass samples straight through.
+  // Allocates; not for the audio thread.
+  void configure(float inputRate, float outputRate, Quality quality, size_t maxInputBlock);
+  void reset();
+  bool isBypassed() const { return bypass_; }
+  // Input samples the filter looks ahead of the sample it is producing.
+  size_t latency() const { return bypass_ ? 0 : taps_ / 2; }
+  // Appends n <= maxInputBlock samples. Only call once read() has come up
+  // short, so the buffer never holds more than one unread block.
+  void write(const float* in, size_t n);
+  // Writes up to n output samples and returns how many it could produce.
+  size_t read(float* out, size_t n);
+
+  // Splits frac, the read position past a whole input sample (0 <= frac
+  // <= 1), into the coefficient row below it and the blend towards the
+  // next row. The row is always below phases, so the pair read stays
+  // inside the table.
+  static int phaseRow(double frac, int phases, float& blend);
+
+private:
+  size_t taps_;
+  int phases_;
+  bool bypass_;
+  double step_; // input samples per output sample
+  double pos_;  // buffer_ index of the next output's first tap
+  size_t size_; // samples held in buffer_
+  std::vector<float> buffer_;
+  // (phases_ + 1) rows of taps_ coefficients; the extra row lets the last
+  // phase blend towards a whole-sample step.
+  std::vector<float> coeffs_;
+};
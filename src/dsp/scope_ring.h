@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// History of the most recent output samples for scopes and meters. The
+// audio thread appends every block with write(); any other thread copies
+// out the latest samples with copyRecent() without locking.
+//
+// This is a seqlock over a ring. The writer claims the positions it is
+// about to overwrite in reserved_ before touching them, and publishes them
+// in written_ afterwards. A reader copies up to the published end, then
+// checks reserved_: if the writer may have lapped the oldest sample it
+// copied, it tries again. The samples are relaxed atomics so the overlap
+// is well defined; on the targets we build for they cost the same as
+// plain loads and stores. Capacity must be a power of two.
+template <size_t Capacity>
+class ScopeRing {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                "ScopeRing capacity must be a power of two");
+
+public:
+  static constexpr size_t kCapacity = Capacity;
+
+  ScopeRing() : reserved_(0), written_(0) {
+    for (size_t i = 0; i < Capacity; ++i) samples_[i].store(0, std::memory_order_relaxed);
+  }
+
+  // Writer side: appends n samples, keeping only the last Capacity.
+  void write(const int16_t* src, size_t n) {
+    if (n > Capacity) {
+      src += n - Capacity;
+      n = Capacity;
+    }
+    size_t start = written_.load(std::memory_order_relaxed);
+    reserved_.store(start + n, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < n; ++i)
+      samples_[(start + i) & kMask].store(src[i], std::memory_order_relaxed);
+    written_.store(start + n, std::memory_order_release);
+  }
+
+  // Reader side: copies the latest min(n, samples written so far) samples,
+  // oldest first, and returns how many. Gives up and returns 0 only if the
+  // writer laps it on every attempt.
+  size_t copyRecent(int16_t* dst, size_t n) const {
+    if (n > Capacity) n = Capacity;
+    for (int attempt = 0; attempt < kMaxAttempts; ++attempt) {
+      size_t end = written_.load(std::memory_order_acquire);
+      size_t count = end < n ? end : n;
+      size_t start = end - count;
+      for (size_t i = 0; i < count; ++i)
+        dst[i] = samples_[(start + i) & kMask].load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      // Positions up to reserved_ may have been written over the ones
+      // Capacity earlier.
+      if (reserved_.load(std::memory_order_relaxed) - start <= Capacity)
+        return count;
+    }
+    return 0;
+  }
+
+  // Samples written since construction, for telling whether anything new
+  // has arrived.
+  size_t totalWritten() const { return written_.load(std::memory_order_acquire); }
+
+private:
+  static constexpr size_t kMask = Capacity - 1;
+  static constexpr int kMaxAttempts = 4;
+
+  std::atomic<int16_t> samples_[Capacity];
+  std::atomic<size_t> reserved_; // end of the block being written
+  std::atomic<size_t> written_;  // end of the last complete block
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stddef.h>
+#include <atomic>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. Neither side ever blocks: push() fails when the queue is full and
+// pop() when it is empty. Capacity must be a power of two.
+template <typename T, size_t Capacity>
+class SpscQueue {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                "SpscQueue capacity must be a power of two");
+
+public:
+  // Producer side.
+  bool push(const T& item) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) == Capacity)
+      return false;
+    items_[head & kMask] = item;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side.
+  bool pop(T& item) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire))
+      return false;
+    item = items_[tail & kMask];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+  }
+
+private:
+  static constexpr size_t kMask = Capacity - 1;
+
+  T items_[Capacity];
+  // Free-running counts; each is written by one side only and kept on its
+  // own cache line so the two threads do not contend for it.
+  alignas(64) std::atomic<size_t> head_{0}; // items pushed
+  alignas(64) std::atomic<size_t> tail_{0}; // items popped
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+
+// Hands the latest copy of a value from one thread to another without
+// locks or retries. The writer fills writeSlot() completely and calls
+// publish(); the reader calls update() and then reads readSlot(), which
+// stays untouched by the writer until the reader's next update(). A value
+// published twice before the reader looks is simply replaced.
+template <typename T>
+class TripleBuffer {
+public:
+  TripleBuffer() : write_(0), read_(1), middle_(2) {}
+
+  // Writer side. The slot holds whatever was published two rounds ago, so
+  // rewrite all of it.
+  T& writeSlot() { return slots_[write_]; }
+  void publish() {
+    int previous = middle_.exchange(write_ | kFresh, std::memory_order_acq_rel);
+    write_ = previous & kIndexMask;
+  }
+
+  // Reader side: switches to the newest published value, if there is one
+  // the reader has not seen, and returns whether it did.
+  bool update() {
+    if (!(middle_.load(std::memory_order_relaxed) & kFresh)) return false;
+    int previous = middle_.exchange(read_, std::memory_order_acq_rel);
+    read_ = previous & kIndexMask;
+    return true;
+  }
+  const T& readSlot() const { return slots_[read_]; }
+
+private:
+  static constexpr int kIndexMask = 3;
+  static constexpr int kFresh = 4;
+
+  T slots_[3];
+  int write_;               // writer only
+  int read_;                // reader only
+  std::atomic<int> middle_; // the spare slot, plus kFresh once published
+};
@@ -2,10 +2,52 @@
 
 #include <math.h>
 
+#include "fast_math.h"
+#include "fixed_point.h"
+
+// Whether ADAA starts on. Building the float profile with
+// MINIACID_TUBE_ADAA=0 makes its shaper match the fixed-point one, which
+// the fixed-point null test needs.
+#ifndef MINIACID_TUBE_ADAA
+#define MINIACID_TUBE_ADAA !MINIACID_FIXED_POINT
+#endif
+
+namespace {
+// log1p(r) / r, continued to 1 at r = 0. Near 0 the series is used, as
+// log(1 + r) would lose r's low bits to the rounding of 1 + r.
+inline float log1pRatio(float r) {
+  if (fabsf(r) < 1e-2f)
+    return 1.0f - r * (0.5f - r * (1.0f / 3.0f - r * 0.25f));
+  return dspLog(1.0f + r) / r;
+}
+
+// Mean of u / (1 + |u|) over [u0, u1], i.e. the difference of its
+// antiderivative |u| - log(1 + |u|) over u1 - u0. Written around u0 so
+// close inputs do not cancel; the naive quotient loses all precision in
+// float once u1 - u0 gets small.
+inline float softClipMean(float u0, float u1) {
+  if ((u0 >= 0.0f) == (u1 >= 0.0f)) {
+    float a0 = fabsf(u0);
+    float r = (fabsf(u1) - a0) / (1.0f + a0);
+    float mean = 1.0f - log1pRatio(r) / (1.0f + a0);
+    return u0 >= 0.0f ? mean : -mean;
+  }
+  // Crossing zero: u1 - u0 is at least as large as either input.
+  float du = u1 - u0;
+  if (fabsf(du) < 1e-4f)
+    return 0.5f * (u0 + u1);
+  float a0 = fabsf(u0);
+  float a1 = fabsf(u1);
+  return ((a1 - dspLog(1.0f + a1)) - (a0 - dspLog(1.0f + a0))) / du;
+}
+} // namespace
+
 TubeDistortion::TubeDistortion()
   : drive_(8.0f),
     mix_(1.0f),
-    enabled_(false) {}
+    enabled_(false),
+    antialiasing_(MINIACID_TUBE_ADAA),
+    lastInput_(0.0f) {}
 
 void TubeDistortion::setDrive(float drive) {
   if (drive < 0.1f)
@@ -23,17 +65,114 @@ void TubeDistortion::setMix(float mix) {
   mix_ = mix;
 }
 
-void TubeDistortion::setEnabled(bool on) { enabled_ = on; }
+void TubeDistortion::setEnabled(bool on) {
+  // Start from silence rather than whatever was left from the last time.
+  if (on && !enabled_) {
+    oversampler_.reset();
+    lastInput_ = 0.0f;
+  }
+  enabled_ = on;
+}
 
 bool TubeDistortion::isEnabled() const { return enabled_; }
 
+void TubeDistortion::setOversampling(int factor) {
+  oversampler_.configure(factor, kOversampleBlock);
+  lastInput_ = 0.0f;
+  if (oversampler_.factor() > 1)
+    oversampled_.assign(kOversampleBlock * oversampler_.factor(), 0.0f);
+  else
+    std::vector<float>().swap(oversampled_);
+}
+
+int TubeDistortion::oversampling() const { return oversampler_.factor(); }
+
+void TubeDistortion::setAntialiasing(bool on) { antialiasing_ = on; }
+
+bool TubeDistortion::antialiasing() const { return antialiasing_; }
+
 float TubeDistortion::process(float input) {
+  return process(input, lastInput_);
+}
+
+float TubeDistortion::process(float input, float& lastInput) {
   if (!enabled_) {
     return input;
   }
+  if (antialiasing_) {
+    float comp = 1.0f / (1.0f + 0.3f * drive_);
+    float shaped = softClipMean(lastInput * drive_, input * drive_) * comp;
+    // The dry path gets the same half-sample delay as the shaped one.
+    float dry = 0.5f * (lastInput + input);
+    lastInput = input;
+    return dry * (1.0f - mix_) + shaped * mix_;
+  }
   float driven = input * drive_;
   float shaped = driven / (1.0f + fabsf(driven));
   float comp = 1.0f / (1.0f + 0.3f * drive_);
   shaped *= comp;
   return input * (1.0f - mix_) + shaped * mix_;
 }
+
+void TubeDistortion::process(float* buffer, size_t numSamples) {
+  if (!enabled_) {
+    return;
+  }
+  int factor = oversampler_.factor();
+  if (factor == 1) {
+    shape(buffer, numSamples);
+    return;
+  }
+  float* hi = oversampled_.data();
+  while (numSamples > 0) {
+    size_t n = numSamples < kOversampleBlock ? numSamples : kOversampleBlock;
+    oversampler_.upsample(buffer, hi, n);
+    shape(hi, n * factor);
+    oversampler_.downsample(hi, buffer, n);
+    buffer += n;
+    numSamples -= n;
+  }
+}
+
+void TubeDistortion::shape(float* buffer, size_t numSamples) {
+  float comp = 1.0f / (1.0f + 0.3f * drive_);
+  if (antialiasing_) {
+    float last = lastInput_;
+    for (size_t i = 0; i < numSamples; ++i) {
+      float input = buffer[i];
+      float shaped = softClipMean(last * drive_, input * drive_) * comp;
+      buffer[i] = 0.5f * (last + input) * (1.0f - mix_) + shaped * mix_;
+      last = input;
+    }
+    lastInput_ = last;
+    return;
+  }
+#if MINIACID_FIXED_POINT
+  // Q12 samples, Q8 drive and Q15 gains. The shaper's division is a single
+  // integer divide, which is much cheaper than a float one on FPUs without
+  // a hardware divider.
+  constexpr int kFrac = 12;
+  constexpr int32_t kOne = 1 << kFrac;
+  constexpr int32_t kMaxInput = 8 << kFrac;
+  const int32_t drive = floatToFixed<8>(drive_);
+  const int32_t dry = floatToQ15(1.0f - mix_);
+  const int32_t wet = floatToQ15(comp * mix_);
+  for (size_t i = 0; i < numSamples; ++i) {
+    int32_t input = floatToFixed<kFrac>(buffer[i]);
+    if (input > kMaxInput) input = kMaxInput;
+    if (input < -kMaxInput) input = -kMaxInput;
+    int32_t driven = (input * drive) >> 8;
+    int32_t magnitude = driven < 0 ? -driven : driven;
+    int32_t shaped = (driven << kFrac) / (kOne + magnitude);
+    buffer[i] = fixedToFloat<kFrac>((input * dry + shaped * wet) >> 15);
+  }
+#else
+  for (size_t i = 0; i < numSamples; ++i) {
+    float input = buffer[i];
+    float driven = input * drive_;
+    float shaped = driven / (1.0f + fabsf(driven));
+    shaped *= comp;
+    buffer[i] = input * (1.0f - mix_) + shaped * mix_;
+  }
+#endif
+}
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <stddef.h>
+#include <vector>
+
+#include "oversampler.h"
+
 class TubeDistortion {
 public:
   TubeDistortion();
@@ -7,10 +12,35 @@ public:
   void setMix(float mix);
   void setEnabled(bool on);
   bool isEnabled() const;
+  // Runs the block shaper at 1x, 2x or 4x the sample rate to keep its
+  // harmonics from folding back. Allocates; not for the audio thread.
+  void setOversampling(int factor);
+  int oversampling() const;
+  // First-order antiderivative antialiasing: each output is the shaper's
+  // mean over the segment between two inputs rather than its value at one
+  // point, which removes most of the aliasing for one log per sample and
+  // half a sample of delay. On by default, except in the fixed-point
+  // build, whose integer shaper it would bypass; MINIACID_TUBE_ADAA
+  // overrides the default.
+  void setAntialiasing(bool on);
+  bool antialiasing() const;
   float process(float input);
+  // For a TubeDistortion shared by several signals: lastInput carries one
+  // signal's antialiasing state between calls.
+  float process(float input, float& lastInput);
+  // Processes numSamples of buffer in place.
+  void process(float* buffer, size_t numSamples);
 
 private:
+  static constexpr size_t kOversampleBlock = 64;
+
+  void shape(float* buffer, size_t numSamples);
+
   float drive_;
   float mix_;
   bool enabled_;
+  bool antialiasing_;
+  float lastInput_;
+  Oversampler oversampler_;
+  std::vector<float> oversampled_;
 };
@@ -43,14 +43,14 @@ MiniAcidDisplay::MiniAcidDisplay(IGfx& gfx, MiniAcid& mini_acid)
   splash_start_ms_ = nowMillis();
   gfx_.setFont(GfxFont::kFont5x7);
 
-  pages_.push_back(std::make_unique<Synth303ParamsPage>(gfx_, mini_acid_, audio_guard_, 0));
-  pages_.push_back(std::make_unique<PatternEditPage>(gfx_, mini_acid_, audio_guard_, 0));
-  pages_.push_back(std::make_unique<Synth303ParamsPage>(gfx_, mini_acid_, audio_guard_, 1));
-  pages_.push_back(std::make_unique<PatternEditPage>(gfx_, mini_acid_, audio_guard_, 1));
-  pages_.push_back(std::make_unique<DrumSequencerPage>(gfx_, mini_acid_, audio_guard_));
-  pages_.push_back(std::make_unique<SongPage>(gfx_, mini_acid_, audio_guard_));
+  pages_.push_back(std::make_unique<Synth303ParamsPage>(gfx_, mini_acid_, 0));
+  pages_.push_back(std::make_unique<PatternEditPage>(gfx_, mini_acid_, 0));
+  pages_.push_back(std::make_unique<Synth303ParamsPage>(gfx_, mini_acid_, 1));
+  pages_.push_back(std::make_unique<PatternEditPage>(gfx_, mini_acid_, 1));
+  pages_.push_back(std::make_unique<DrumSequencerPage>(gfx_, mini_acid_));
+  pages_.push_back(std::make_unique<SongPage>(gfx_, mini_acid_));
   pages_.push_back(std::make_unique<ProjectPage>(gfx_, mini_acid_, audio_guard_));
-  pages_.push_back(std::make_unique<WaveformPage>(gfx_, mini_acid_, audio_guard_));
+  pages_.push_back(std::make_unique<WaveformPage>(gfx_, mini_acid_));
   pages_.push_back(std::make_unique<HelpPage>());
 }
 
@@ -112,8 +112,18 @@ void MiniAcidDisplay::update() {
   int content_h = 110;
   if (content_h < 0) content_h = 0;
 
+  // post() drops edits when the audio thread falls a whole queue behind;
+  // say so in the title bar for a moment instead of losing them silently.
+  uint32_t dropped = mini_acid_.droppedCommandCount();
+  if (dropped != dropped_commands_seen_) {
+    dropped_commands_seen_ = dropped;
+    dropped_notice_until_ms_ = nowMillis() + 2000UL;
+  }
+  bool show_dropped = static_cast<long>(dropped_notice_until_ms_ - nowMillis()) > 0;
+
   if (pages_[page_index_]) {
-    int title_h = drawPageTitle(content_x, content_y, content_w, pages_[page_index_]->getTitle().c_str());
+    const char* title = show_dropped ? "EDIT DROPPED" : pages_[page_index_]->getTitle().c_str();
+    int title_h = drawPageTitle(content_x, content_y, content_w, title);
     // we don't need to do this each time, but for simplicity we do it here
     pages_[page_index_]->setBoundaries(Rect(content_x, content_y + title_h, content_w, content_h - title_h));
     pages_[page_index_]->draw(gfx_);
@@ -186,17 +196,20 @@ void MiniAcidDisplay::initMuteButtons(int x, int y, int w, int h) {
     int index;
   };
   
+  auto postCommand = [this](EngineCommand cmd) {
+    return std::function<void()>([this, cmd]() { mini_acid_.post(cmd); });
+  };
   std::vector<MuteButtonConfig> configs = {
-    {"S1", [this]() { return mini_acid_.is303Muted(0); }, [this]() { mini_acid_.toggleMute303(0); }, 0},
-    {"S2", [this]() { return mini_acid_.is303Muted(1); }, [this]() { mini_acid_.toggleMute303(1); }, 1},
-    {"BD", [this]() { return mini_acid_.isKickMuted(); }, [this]() { mini_acid_.toggleMuteKick(); }, 2},
-    {"SD", [this]() { return mini_acid_.isSnareMuted(); }, [this]() { mini_acid_.toggleMuteSnare(); }, 3},
-    {"CH", [this]() { return mini_acid_.isHatMuted(); }, [this]() { mini_acid_.toggleMuteHat(); }, 4},
-    {"OH", [this]() { return mini_acid_.isOpenHatMuted(); }, [this]() { mini_acid_.toggleMuteOpenHat(); }, 5},
-    {"MT", [this]() { return mini_acid_.isMidTomMuted(); }, [this]() { mini_acid_.toggleMuteMidTom(); }, 6},
-    {"HT", [this]() { return mini_acid_.isHighTomMuted(); }, [this]() { mini_acid_.toggleMuteHighTom(); }, 7},
-    {"RS", [this]() { return mini_acid_.isRimMuted(); }, [this]() { mini_acid_.toggleMuteRim(); }, 8},
-    {"CP", [this]() { return mini_acid_.isClapMuted(); }, [this]() { mini_acid_.toggleMuteClap(); }, 9},
+    {"S1", [this]() { return mini_acid_.is303Muted(0); }, postCommand(EngineCommand::toggleMute303(0)), 0},
+    {"S2", [this]() { return mini_acid_.is303Muted(1); }, postCommand(EngineCommand::toggleMute303(1)), 1},
+    {"BD", [this]() { return mini_acid_.isKickMuted(); }, postCommand(EngineCommand::toggleMuteDrum(DrumVoiceId::Kick)), 2},
+    {"SD", [this]() { return mini_acid_.isSnareMuted(); }, postCommand(EngineCommand::toggleMuteDrum(DrumVoiceId::Snare)), 3},
+    {"CH", [this]() { return mini_acid_.isHatMuted(); }, postCommand(EngineCommand::toggleMuteDrum(DrumVoiceId::Hat)), 4},
+    {"OH", [this]() { return mini_acid_.isOpenHatMuted(); }, postCommand(EngineCommand::toggleMuteDrum(DrumVoiceId::OpenHat)), 5},
+    {"MT", [this]() { return mini_acid_.isMidTomMuted(); }, postCommand(EngineCommand::toggleMuteDrum(DrumVoiceId::MidTom)), 6},
+    {"HT", [this]() { return mini_acid_.isHighTomMuted(); }, postCommand(EngineCommand::toggleMuteDrum(DrumVoiceId::HighTom)), 7},
+    {"RS", [this]() { return mini_acid_.isRimMuted(); }, postCommand(EngineCommand::toggleMuteDrum(DrumVoiceId::Rim)), 8},
+    {"CP", [this]() { return mini_acid_.isClapMuted(); }, postCommand(EngineCommand::toggleMuteDrum(DrumVoiceId::Clap)), 9},
   };
   
   for (const auto& config : configs) {
@@ -336,11 +349,18 @@ bool MiniAcidDisplay::handleEvent(UIEvent event) {
   if (event.event_type == MINIACID_APPLICATION_EVENT) {
     switch (event.app_event_type) {
       case MINIACID_APP_EVENT_TOGGLE_SONG_MODE:
-        mini_acid_.toggleSongMode();
+        mini_acid_.post(EngineCommand::toggleSongMode());
         return true;
-      case MINIACID_APP_EVENT_SAVE_SCENE:
-        mini_acid_.saveSceneAs(mini_acid_.currentSceneName());
+      case MINIACID_APP_EVENT_SAVE_SCENE: {
+        // Saving copies the audio thread's state into the scene.
+        auto save = [this]() { mini_acid_.saveSceneAs(mini_acid_.currentSceneName()); };
+        if (audio_guard_) {
+          audio_guard_(save);
+        } else {
+          save();
+        }
         return true;
+      }
       case MINIACID_APP_EVENT_START_RECORDING:
 #if defined(ARDUINO)
         Serial.println("Handling START_RECORDING event");
@@ -419,10 +439,10 @@ bool MiniAcidDisplay::handleEvent(UIEvent event) {
   switch(event.event_type) {
     case MINIACID_KEY_DOWN:
       if (event.key == '-') {
-        mini_acid_.adjustParameter(MiniAcidParamId::MainVolume, -5);
+        mini_acid_.post(EngineCommand::adjustParameter(MiniAcidParamId::MainVolume, -5));
         return true;
       } else if (event.key == '=') {
-        mini_acid_.adjustParameter(MiniAcidParamId::MainVolume, 5);
+        mini_acid_.post(EngineCommand::adjustParameter(MiniAcidParamId::MainVolume, 5));
         return true;
       }
       break;
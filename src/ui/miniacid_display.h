@@ -32,6 +32,8 @@ private:
   unsigned long splash_start_ms_ = 0;
   bool splash_active_ = true;
   bool help_dialog_visible_ = false;
+  uint32_t dropped_commands_seen_ = 0;
+  unsigned long dropped_notice_until_ms_ = 0;
   std::unique_ptr<MultiPageHelpDialog> help_dialog_;
 
   AudioGuard audio_guard_;
@@ -189,7 +189,7 @@ class DrumSequencerGridComponent : public Component {
 
 class DrumSequencerMainPage : public Container {
  public:
-  DrumSequencerMainPage(MiniAcid& mini_acid, AudioGuard& audio_guard);
+  explicit DrumSequencerMainPage(MiniAcid& mini_acid);
   void draw(IGfx& gfx) override;
   bool handleEvent(UIEvent& ui_event) override;
 
@@ -208,10 +208,8 @@ class DrumSequencerMainPage : public Container {
   int bankIndexFromKey(char key) const;
   void setBankIndex(int bankIndex);
   bool bankRowFocused() const;
-  void withAudioGuard(const std::function<void()>& fn);
 
   MiniAcid& mini_acid_;
-  AudioGuard& audio_guard_;
   int drum_step_cursor_;
   int drum_voice_cursor_;
   int drum_pattern_cursor_;
@@ -239,9 +237,8 @@ class GlobalDrumSettingsPage : public Container {
   std::shared_ptr<LabelOptionComponent> character_control_;
 };
 
-DrumSequencerMainPage::DrumSequencerMainPage(MiniAcid& mini_acid, AudioGuard& audio_guard)
+DrumSequencerMainPage::DrumSequencerMainPage(MiniAcid& mini_acid)
   : mini_acid_(mini_acid),
-    audio_guard_(audio_guard),
     drum_step_cursor_(0),
     drum_voice_cursor_(0),
     drum_pattern_cursor_(0),
@@ -262,7 +259,7 @@ DrumSequencerMainPage::DrumSequencerMainPage(MiniAcid& mini_acid, AudioGuard& au
     drum_pattern_focus_ = true;
     bank_focus_ = false;
     setDrumPatternCursor(index);
-    withAudioGuard([&]() { mini_acid_.setDrumPatternIndex(index); });
+    mini_acid_.post(EngineCommand::setDrumPatternIndex(index));
   };
   pattern_bar_->setCallbacks(std::move(pattern_callbacks));
   BankSelectionBarComponent::Callbacks bank_callbacks;
@@ -279,12 +276,12 @@ DrumSequencerMainPage::DrumSequencerMainPage(MiniAcid& mini_acid, AudioGuard& au
     focusGrid();
     drum_step_cursor_ = step;
     drum_voice_cursor_ = voice;
-    withAudioGuard([&]() { mini_acid_.toggleDrumStep(voice, step); });
+    mini_acid_.post(EngineCommand::toggleDrumStep(voice, step));
   };
   callbacks.onToggleAccent = [this](int step) {
     focusGrid();
     drum_step_cursor_ = step;
-    withAudioGuard([&]() { mini_acid_.toggleDrumAccentStep(step); });
+    mini_acid_.post(EngineCommand::toggleDrumAccentStep(step));
   };
   callbacks.cursorStep = [this]() { return activeDrumStep(); };
   callbacks.cursorVoice = [this]() { return activeDrumVoice(); };
@@ -443,15 +440,7 @@ void DrumSequencerMainPage::setBankIndex(int bankIndex) {
   if (bankIndex >= kBankCount) bankIndex = kBankCount - 1;
   if (bank_index_ == bankIndex) return;
   bank_index_ = bankIndex;
-  withAudioGuard([&]() { mini_acid_.setDrumBankIndex(bank_index_); });
-}
-
-void DrumSequencerMainPage::withAudioGuard(const std::function<void()>& fn) {
-  if (audio_guard_) {
-    audio_guard_(fn);
-    return;
-  }
-  fn();
+  mini_acid_.post(EngineCommand::setDrumBankIndex(bank_index_));
 }
 
 bool DrumSequencerMainPage::handleEvent(UIEvent& ui_event) {
@@ -493,49 +482,18 @@ bool DrumSequencerMainPage::handleEvent(UIEvent& ui_event) {
       }
       case MINIACID_APP_EVENT_PASTE: {
         if (!g_drum_pattern_clipboard.has_pattern) return false;
-        bool current_hits[NUM_DRUM_VOICES][SEQ_STEPS];
-        bool current_accents[NUM_DRUM_VOICES][SEQ_STEPS];
-        const bool* hits[NUM_DRUM_VOICES] = {
-          mini_acid_.patternKickSteps(),
-          mini_acid_.patternSnareSteps(),
-          mini_acid_.patternHatSteps(),
-          mini_acid_.patternOpenHatSteps(),
-          mini_acid_.patternMidTomSteps(),
-          mini_acid_.patternHighTomSteps(),
-          mini_acid_.patternRimSteps(),
-          mini_acid_.patternClapSteps()
-        };
-        const bool* accents[NUM_DRUM_VOICES] = {
-          mini_acid_.patternKickAccentSteps(),
-          mini_acid_.patternSnareAccentSteps(),
-          mini_acid_.patternHatAccentSteps(),
-          mini_acid_.patternOpenHatAccentSteps(),
-          mini_acid_.patternMidTomAccentSteps(),
-          mini_acid_.patternHighTomAccentSteps(),
-          mini_acid_.patternRimAccentSteps(),
-          mini_acid_.patternClapAccentSteps()
-        };
+        // Every step is set outright: the pattern the UI sees can be a block
+        // behind edits still in the queue, so comparing against it could
+        // undo them.
+        const DrumPatternSet& src = g_drum_pattern_clipboard.pattern;
         for (int v = 0; v < NUM_DRUM_VOICES; ++v) {
           for (int i = 0; i < SEQ_STEPS; ++i) {
-            current_hits[v][i] = hits[v][i];
-            current_accents[v][i] = accents[v][i];
+            bool desiredHit = src.voices[v].steps[i].hit;
+            bool desiredAccent = src.voices[v].steps[i].accent && desiredHit;
+            mini_acid_.post(EngineCommand::setDrumStep(v, i, desiredHit));
+            mini_acid_.post(EngineCommand::setDrumAccentStep(v, i, desiredAccent));
           }
         }
-        const DrumPatternSet& src = g_drum_pattern_clipboard.pattern;
-        withAudioGuard([&]() {
-          for (int v = 0; v < NUM_DRUM_VOICES; ++v) {
-            for (int i = 0; i < SEQ_STEPS; ++i) {
-              bool desiredHit = src.voices[v].steps[i].hit;
-              bool desiredAccent = src.voices[v].steps[i].accent && desiredHit;
-              if (current_hits[v][i] != desiredHit) {
-                mini_acid_.toggleDrumStep(v, i);
-              }
-              if (current_accents[v][i] != desiredAccent) {
-                mini_acid_.setDrumAccentStep(v, i, desiredAccent);
-              }
-            }
-          }
-        });
         return true;
       }
       default:
@@ -588,11 +546,11 @@ bool DrumSequencerMainPage::handleEvent(UIEvent& ui_event) {
       setBankIndex(activeBankCursor());
     } else if (patternRowFocused()) {
       int cursor = activeDrumPatternCursor();
-      withAudioGuard([&]() { mini_acid_.setDrumPatternIndex(cursor); });
+      mini_acid_.post(EngineCommand::setDrumPatternIndex(cursor));
     } else {
       int step = activeDrumStep();
       int voice = activeDrumVoice();
-      withAudioGuard([&]() { mini_acid_.toggleDrumStep(voice, step); });
+      mini_acid_.post(EngineCommand::toggleDrumStep(voice, step));
     }
     return true;
   }
@@ -606,7 +564,7 @@ bool DrumSequencerMainPage::handleEvent(UIEvent& ui_event) {
       if (mini_acid_.songModeEnabled()) return true;
       focusPatternRow();
       setDrumPatternCursor(patternIdx);
-      withAudioGuard([&]() { mini_acid_.setDrumPatternIndex(patternIdx); });
+      mini_acid_.post(EngineCommand::setDrumPatternIndex(patternIdx));
       return true;
     }
   }
@@ -616,7 +574,7 @@ bool DrumSequencerMainPage::handleEvent(UIEvent& ui_event) {
     case 'w': {
       focusGrid();
       int step = activeDrumStep();
-      withAudioGuard([&]() { mini_acid_.toggleDrumAccentStep(step); });
+      mini_acid_.post(EngineCommand::toggleDrumAccentStep(step));
       return true;
     }
     default:
@@ -732,7 +690,7 @@ void GlobalDrumSettingsPage::applyDrumEngineSelection() {
   if (!character_control_) return;
   int index = character_control_->optionIndex();
   if (index < 0 || index >= static_cast<int>(drum_engine_options_.size())) return;
-  mini_acid_.setDrumEngine(drum_engine_options_[index]);
+  mini_acid_.post(EngineCommand::setDrumEngine(index));
 }
 
 void GlobalDrumSettingsPage::syncDrumEngineSelection() {
@@ -751,9 +709,9 @@ void GlobalDrumSettingsPage::syncDrumEngineSelection() {
   character_control_->setOptionIndex(target);
 }
 
-DrumSequencerPage::DrumSequencerPage(IGfx& gfx, MiniAcid& mini_acid, AudioGuard& audio_guard) {
+DrumSequencerPage::DrumSequencerPage(IGfx& gfx, MiniAcid& mini_acid) {
   (void)gfx;
-  addPage(std::make_shared<DrumSequencerMainPage>(mini_acid, audio_guard));
+  addPage(std::make_shared<DrumSequencerMainPage>(mini_acid));
   addPage(std::make_shared<GlobalDrumSettingsPage>(mini_acid));
 }
 
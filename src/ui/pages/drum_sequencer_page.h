@@ -10,7 +10,7 @@ class PatternSelectionBarComponent;
 
 class DrumSequencerPage : public MultiPage, public IMultiHelpFramesProvider {
  public:
-  DrumSequencerPage(IGfx& gfx, MiniAcid& mini_acid, AudioGuard& audio_guard);
+  DrumSequencerPage(IGfx& gfx, MiniAcid& mini_acid);
   const std::string & getTitle() const override;
   std::unique_ptr<MultiPageHelpDialog> getHelpDialog() override;
   int getHelpFrameCount() const override;
@@ -16,10 +16,9 @@ struct PatternClipboard {
 PatternClipboard g_pattern_clipboard;
 } // namespace
 
-PatternEditPage::PatternEditPage(IGfx& gfx, MiniAcid& mini_acid, AudioGuard& audio_guard, int voice_index)
+PatternEditPage::PatternEditPage(IGfx& gfx, MiniAcid& mini_acid, int voice_index)
   : gfx_(gfx),
     mini_acid_(mini_acid),
-    audio_guard_(audio_guard),
     voice_index_(voice_index),
     pattern_edit_cursor_(0),
     pattern_row_cursor_(0),
@@ -39,7 +38,7 @@ PatternEditPage::PatternEditPage(IGfx& gfx, MiniAcid& mini_acid, AudioGuard& aud
     if (mini_acid_.songModeEnabled()) return;
     focusPatternRow();
     setPatternCursor(index);
-    withAudioGuard([&]() { mini_acid_.set303PatternIndex(voice_index_, index); });
+    mini_acid_.post(EngineCommand::set303PatternIndex(voice_index_, index));
   };
   pattern_bar_->setCallbacks(std::move(pattern_callbacks));
   BankSelectionBarComponent::Callbacks bank_callbacks;
@@ -96,21 +95,13 @@ void PatternEditPage::setBankIndex(int bankIndex) {
   if (bankIndex >= kBankCount) bankIndex = kBankCount - 1;
   if (bank_index_ == bankIndex) return;
   bank_index_ = bankIndex;
-  withAudioGuard([&]() { mini_acid_.set303BankIndex(voice_index_, bank_index_); });
+  mini_acid_.post(EngineCommand::set303BankIndex(voice_index_, bank_index_));
 }
 
 void PatternEditPage::ensureStepFocus() {
   if (patternRowFocused() || focus_ == Focus::BankRow) focus_ = Focus::Steps;
 }
 
-void PatternEditPage::withAudioGuard(const std::function<void()>& fn) {
-  if (audio_guard_) {
-    audio_guard_(fn);
-    return;
-  }
-  fn();
-}
-
 int PatternEditPage::activePatternCursor() const {
   return clampCursor(pattern_row_cursor_);
 }
@@ -239,49 +230,14 @@ bool PatternEditPage::handleEvent(UIEvent& ui_event) {
       }
       case MINIACID_APP_EVENT_PASTE: {
         if (!g_pattern_clipboard.has_pattern) return false;
-        int current_notes[SEQ_STEPS];
-        bool current_accent[SEQ_STEPS];
-        bool current_slide[SEQ_STEPS];
-        const int8_t* notes = mini_acid_.pattern303Steps(voice_index_);
-        const bool* accent = mini_acid_.pattern303AccentSteps(voice_index_);
-        const bool* slide = mini_acid_.pattern303SlideSteps(voice_index_);
+        // Absolute values, so edits still in the queue cannot turn the
+        // paste into a partial undo.
+        const SynthPattern& src = g_pattern_clipboard.pattern;
         for (int i = 0; i < SEQ_STEPS; ++i) {
-          current_notes[i] = notes[i];
-          current_accent[i] = accent[i];
-          current_slide[i] = slide[i];
+          mini_acid_.post(EngineCommand::set303StepNote(voice_index_, i, src.steps[i].note));
+          mini_acid_.post(EngineCommand::set303AccentStep(voice_index_, i, src.steps[i].accent));
+          mini_acid_.post(EngineCommand::set303SlideStep(voice_index_, i, src.steps[i].slide));
         }
-        const SynthPattern& src = g_pattern_clipboard.pattern;
-        withAudioGuard([&]() {
-          for (int i = 0; i < SEQ_STEPS; ++i) {
-            int target_note = src.steps[i].note;
-            int current_note = current_notes[i];
-            if (target_note < 0) {
-              if (current_note >= 0) {
-                mini_acid_.clear303StepNote(voice_index_, i);
-              }
-            } else if (current_note < 0) {
-              int delta = target_note - MiniAcid::kMin303Note;
-              if (delta == 0) {
-                mini_acid_.adjust303StepNote(voice_index_, i, 1);
-                mini_acid_.adjust303StepNote(voice_index_, i, -1);
-              } else {
-                mini_acid_.adjust303StepNote(voice_index_, i, delta);
-              }
-            } else {
-              int delta = target_note - current_note;
-              if (delta != 0) {
-                mini_acid_.adjust303StepNote(voice_index_, i, delta);
-              }
-            }
-
-            if (current_accent[i] != src.steps[i].accent) {
-              mini_acid_.toggle303AccentStep(voice_index_, i);
-            }
-            if (current_slide[i] != src.steps[i].slide) {
-              mini_acid_.toggle303SlideStep(voice_index_, i);
-            }
-          }
-        });
         return true;
       }
       default:
@@ -334,7 +290,7 @@ bool PatternEditPage::handleEvent(UIEvent& ui_event) {
       if (mini_acid_.songModeEnabled()) return true;
       int cursor = activePatternCursor();
       setPatternCursor(cursor);
-      withAudioGuard([&]() { mini_acid_.set303PatternIndex(voice_index_, cursor); });
+      mini_acid_.post(EngineCommand::set303PatternIndex(voice_index_, cursor));
       return true;
     }
   }
@@ -348,7 +304,7 @@ bool PatternEditPage::handleEvent(UIEvent& ui_event) {
       if (mini_acid_.songModeEnabled()) return true;
       focusPatternRow();
       setPatternCursor(patternIdx);
-      withAudioGuard([&]() { mini_acid_.set303PatternIndex(voice_index_, patternIdx); });
+      mini_acid_.post(EngineCommand::set303PatternIndex(voice_index_, patternIdx));
       return true;
     }
   }
@@ -366,37 +322,37 @@ bool PatternEditPage::handleEvent(UIEvent& ui_event) {
     case 'q': {
       ensureStepFocusAndCursor();
       int step = activePatternStep();
-      withAudioGuard([&]() { mini_acid_.toggle303SlideStep(voice_index_, step); });
+      mini_acid_.post(EngineCommand::toggle303SlideStep(voice_index_, step));
       return true;
     }
     case 'w': {
       ensureStepFocusAndCursor();
       int step = activePatternStep();
-      withAudioGuard([&]() { mini_acid_.toggle303AccentStep(voice_index_, step); });
+      mini_acid_.post(EngineCommand::toggle303AccentStep(voice_index_, step));
       return true;
     }
     case 'a': {
       ensureStepFocusAndCursor();
       int step = activePatternStep();
-      withAudioGuard([&]() { mini_acid_.adjust303StepNote(voice_index_, step, 1); });
+      mini_acid_.post(EngineCommand::adjust303StepNote(voice_index_, step, 1));
       return true;
     }
     case 'z': {
       ensureStepFocusAndCursor();
       int step = activePatternStep();
-      withAudioGuard([&]() { mini_acid_.adjust303StepNote(voice_index_, step, -1); });
+      mini_acid_.post(EngineCommand::adjust303StepNote(voice_index_, step, -1));
       return true;
     }
     case 's': {
       ensureStepFocusAndCursor();
       int step = activePatternStep();
-      withAudioGuard([&]() { mini_acid_.adjust303StepOctave(voice_index_, step, 1); });
+      mini_acid_.post(EngineCommand::adjust303StepOctave(voice_index_, step, 1));
       return true;
     }
     case 'x': {
       ensureStepFocusAndCursor();
       int step = activePatternStep();
-      withAudioGuard([&]() { mini_acid_.adjust303StepOctave(voice_index_, step, -1); });
+      mini_acid_.post(EngineCommand::adjust303StepOctave(voice_index_, step, -1));
       return true;
     }
     default:
@@ -406,7 +362,7 @@ bool PatternEditPage::handleEvent(UIEvent& ui_event) {
   if (key == '\b') {
     ensureStepFocusAndCursor();
     int step = activePatternStep();
-    withAudioGuard([&]() { mini_acid_.clear303StepNote(voice_index_, step); });
+    mini_acid_.post(EngineCommand::clear303StepNote(voice_index_, step));
     return true;
   }
 
@@ -67,10 +67,9 @@ SongAreaClipboard g_song_area_clipboard;
 UndoHistory g_undo_history;
 } // namespace
 
-SongPage::SongPage(IGfx& gfx, MiniAcid& mini_acid, AudioGuard& audio_guard)
+SongPage::SongPage(IGfx& gfx, MiniAcid& mini_acid)
   : gfx_(gfx),
     mini_acid_(mini_acid),
-    audio_guard_(audio_guard),
     cursor_row_(0),
     cursor_track_(0),
     scroll_row_(0),
@@ -121,22 +120,48 @@ void SongPage::updateSelection() {
 
 void SongPage::clearSelection() {
   has_selection_ = false;
-  if (mini_acid_.loopModeEnabled()) {
-    withAudioGuard([&]() { mini_acid_.setLoopMode(false); });
+  if (loopModeEnabled()) {
+    postLoop(false, loopStartRow(), loopEndRow());
   }
 }
 
 void SongPage::updateLoopRangeFromSelection() {
-  if (!mini_acid_.loopModeEnabled()) return;
+  if (!loopModeEnabled()) return;
   if (!has_selection_) {
-    withAudioGuard([&]() { mini_acid_.setLoopMode(false); });
+    postLoop(false, loopStartRow(), loopEndRow());
     return;
   }
   int min_row, max_row, min_track, max_track;
   getSelectionBounds(min_row, max_row, min_track, max_track);
   (void)min_track;
   (void)max_track;
-  withAudioGuard([&]() { mini_acid_.setLoopRange(min_row, max_row); });
+  postLoop(true, min_row, max_row);
+}
+
+bool SongPage::loopModeEnabled() {
+  if (loop_pending_ && mini_acid_.commandApplied(loop_command_)) loop_pending_ = false;
+  return loop_pending_ ? loop_mode_ : mini_acid_.loopModeEnabled();
+}
+
+int SongPage::loopStartRow() {
+  return loopModeEnabled() && loop_pending_ ? loop_start_row_ : mini_acid_.loopStartRow();
+}
+
+int SongPage::loopEndRow() {
+  return loopModeEnabled() && loop_pending_ ? loop_end_row_ : mini_acid_.loopEndRow();
+}
+
+// Key presses can outrun the audio thread, so decisions about the loop are
+// made on what this page has already asked for rather than on a snapshot
+// that may not include it yet.
+void SongPage::postLoop(bool enabled, int start_row, int end_row) {
+  if (enabled && !mini_acid_.post(EngineCommand::setLoopRange(start_row, end_row))) return;
+  if (!mini_acid_.post(EngineCommand::setLoopMode(enabled))) return;
+  loop_pending_ = true;
+  loop_command_ = mini_acid_.lastPostedCommand();
+  loop_mode_ = enabled;
+  loop_start_row_ = start_row;
+  loop_end_row_ = end_row;
 }
 
 void SongPage::getSelectionBounds(int& min_row, int& max_row, int& min_track, int& max_track) const {
@@ -191,16 +216,8 @@ void SongPage::moveCursorVertical(int delta, bool extend_selection) {
 
 void SongPage::syncSongPositionToCursor() {
   if (mini_acid_.songModeEnabled() && !mini_acid_.isPlaying()) {
-    withAudioGuard([&]() { mini_acid_.setSongPosition(cursorRow()); });
-  }
-}
-
-void SongPage::withAudioGuard(const std::function<void()>& fn) {
-  if (audio_guard_) {
-    audio_guard_(fn);
-    return;
+    mini_acid_.post(EngineCommand::setSongPosition(cursorRow()));
   }
-  fn();
 }
 
 SongTrack SongPage::trackForColumn(int col, bool& valid) const {
@@ -252,13 +269,11 @@ bool SongPage::adjustSongPatternAtCursor(int delta) {
   if (next > maxPattern) next = maxPattern;
   if (next < -1) next = -1;
   if (next == current) return false;
-  withAudioGuard([&]() {
-    if (next < 0) mini_acid_.clearSongPattern(row, track);
-    else mini_acid_.setSongPattern(row, track, next);
-    if (mini_acid_.songModeEnabled() && !mini_acid_.isPlaying()) {
-      mini_acid_.setSongPosition(row);
-    }
-  });
+  if (next < 0) mini_acid_.post(EngineCommand::clearSongPattern(row, track));
+  else mini_acid_.post(EngineCommand::setSongPattern(row, track, next));
+  if (mini_acid_.songModeEnabled() && !mini_acid_.isPlaying()) {
+    mini_acid_.post(EngineCommand::setSongPosition(row));
+  }
   return true;
 }
 
@@ -273,7 +288,7 @@ bool SongPage::adjustSongPlayhead(int delta) {
   if (next < 0) next = 0;
   if (next > maxPos) next = maxPos;
   if (next == current) return false;
-  withAudioGuard([&]() { mini_acid_.setSongPosition(next); });
+  mini_acid_.post(EngineCommand::setSongPosition(next));
   setScrollToPlayhead(next);
   return true;
 }
@@ -285,12 +300,10 @@ bool SongPage::assignPattern(int patternIdx) {
   int row = cursorRow();
   int bankIndex = bankIndexForTrack(track);
   int combined = songPatternFromBank(bankIndex, patternIdx);
-  withAudioGuard([&]() {
-    mini_acid_.setSongPattern(row, track, combined);
-    if (mini_acid_.songModeEnabled() && !mini_acid_.isPlaying()) {
-      mini_acid_.setSongPosition(row);
-    }
-  });
+  mini_acid_.post(EngineCommand::setSongPattern(row, track, combined));
+  if (mini_acid_.songModeEnabled() && !mini_acid_.isPlaying()) {
+    mini_acid_.post(EngineCommand::setSongPosition(row));
+  }
   return true;
 }
 
@@ -305,23 +318,21 @@ bool SongPage::clearPattern() {
   g_undo_history.action_type = UndoActionType::Delete;
   g_undo_history.saveSingleCell(row, cursorTrack(), current_pattern);
   
-  withAudioGuard([&]() {
-    mini_acid_.clearSongPattern(row, track);
-    if (mini_acid_.songModeEnabled() && !mini_acid_.isPlaying()) {
-      mini_acid_.setSongPosition(row);
-    }
-  });
+  mini_acid_.post(EngineCommand::clearSongPattern(row, track));
+  if (mini_acid_.songModeEnabled() && !mini_acid_.isPlaying()) {
+    mini_acid_.post(EngineCommand::setSongPosition(row));
+  }
   return true;
 }
 
 bool SongPage::toggleSongMode() {
-  withAudioGuard([&]() { mini_acid_.toggleSongMode(); });
+  mini_acid_.post(EngineCommand::toggleSongMode());
   return true;
 }
 
 bool SongPage::toggleLoopMode() {
-  if (mini_acid_.loopModeEnabled()) {
-    withAudioGuard([&]() { mini_acid_.setLoopMode(false); });
+  if (loopModeEnabled()) {
+    postLoop(false, loopStartRow(), loopEndRow());
     return true;
   }
   if (!has_selection_) return false;
@@ -329,10 +340,7 @@ bool SongPage::toggleLoopMode() {
   getSelectionBounds(min_row, max_row, min_track, max_track);
   (void)min_track;
   (void)max_track;
-  withAudioGuard([&]() {
-    mini_acid_.setLoopRange(min_row, max_row);
-    mini_acid_.setLoopMode(true);
-  });
+  postLoop(true, min_row, max_row);
   return true;
 }
 
@@ -429,20 +437,18 @@ bool SongPage::handleEvent(UIEvent& ui_event) {
           std::vector<int> old_patterns;
           old_patterns.reserve(rows * tracks);
           
-          withAudioGuard([&]() {
-            for (int r = min_row; r <= max_row; ++r) {
-              for (int t = min_track; t <= max_track; ++t) {
-                bool valid = false;
-                SongTrack song_track = trackForColumn(t, valid);
-                if (valid) {
-                  int pattern = mini_acid_.songPatternAt(r, song_track);
-                  g_song_area_clipboard.pattern_indices.push_back(pattern);
-                  old_patterns.push_back(pattern);
-                  mini_acid_.clearSongPattern(r, song_track);
-                }
+          for (int r = min_row; r <= max_row; ++r) {
+            for (int t = min_track; t <= max_track; ++t) {
+              bool valid = false;
+              SongTrack song_track = trackForColumn(t, valid);
+              if (valid) {
+                int pattern = mini_acid_.songPatternAt(r, song_track);
+                g_song_area_clipboard.pattern_indices.push_back(pattern);
+                old_patterns.push_back(pattern);
+                mini_acid_.post(EngineCommand::clearSongPattern(r, song_track));
               }
             }
-          });
+          }
           
           g_song_area_clipboard.has_area = true;
           g_song_pattern_clipboard.has_pattern = false; // Clear single-cell clipboard
@@ -463,9 +469,7 @@ bool SongPage::handleEvent(UIEvent& ui_event) {
           g_undo_history.action_type = UndoActionType::Cut;
           g_undo_history.saveSingleCell(row, cursorTrack(), current_pattern);
           
-          withAudioGuard([&]() {
-            mini_acid_.clearSongPattern(row, track);
-          });
+          mini_acid_.post(EngineCommand::clearSongPattern(row, track));
         }
         return true;
       }
@@ -497,33 +501,31 @@ bool SongPage::handleEvent(UIEvent& ui_event) {
             }
           }
           
-          withAudioGuard([&]() {
-            int idx = 0;
-            for (int r = 0; r < g_song_area_clipboard.rows; ++r) {
-              for (int t = 0; t < g_song_area_clipboard.tracks; ++t) {
-                int target_row = start_row + r;
-                int target_track = start_track + t;
-                if (target_row >= Song::kMaxPositions || target_track > 2) {
-                  ++idx;
-                  continue;
-                }
-                bool valid = false;
-                SongTrack song_track = trackForColumn(target_track, valid);
-                if (valid && idx < static_cast<int>(g_song_area_clipboard.pattern_indices.size())) {
-                  int pattern = g_song_area_clipboard.pattern_indices[idx];
-                  if (pattern < 0) {
-                    mini_acid_.clearSongPattern(target_row, song_track);
-                  } else {
-                    mini_acid_.setSongPattern(target_row, song_track, pattern);
-                  }
-                }
+          int idx = 0;
+          for (int r = 0; r < g_song_area_clipboard.rows; ++r) {
+            for (int t = 0; t < g_song_area_clipboard.tracks; ++t) {
+              int target_row = start_row + r;
+              int target_track = start_track + t;
+              if (target_row >= Song::kMaxPositions || target_track > 2) {
                 ++idx;
+                continue;
               }
+              bool valid = false;
+              SongTrack song_track = trackForColumn(target_track, valid);
+              if (valid && idx < static_cast<int>(g_song_area_clipboard.pattern_indices.size())) {
+                int pattern = g_song_area_clipboard.pattern_indices[idx];
+                if (pattern < 0) {
+                  mini_acid_.post(EngineCommand::clearSongPattern(target_row, song_track));
+                } else {
+                  mini_acid_.post(EngineCommand::setSongPattern(target_row, song_track, pattern));
+                }
+              }
+              ++idx;
             }
-            if (mini_acid_.songModeEnabled() && !mini_acid_.isPlaying()) {
-              mini_acid_.setSongPosition(start_row);
-            }
-          });
+          }
+          if (mini_acid_.songModeEnabled() && !mini_acid_.isPlaying()) {
+            mini_acid_.post(EngineCommand::setSongPosition(start_row));
+          }
           
           // Save undo history
           g_undo_history.action_type = UndoActionType::Paste;
@@ -539,16 +541,14 @@ bool SongPage::handleEvent(UIEvent& ui_event) {
           g_undo_history.action_type = UndoActionType::Paste;
           g_undo_history.saveSingleCell(row, track_idx, old_pattern);
           
-          withAudioGuard([&]() {
-            if (patternIndex < 0) {
-              mini_acid_.clearSongPattern(row, track);
-            } else {
-              mini_acid_.setSongPattern(row, track, patternIndex);
-            }
-            if (mini_acid_.songModeEnabled() && !mini_acid_.isPlaying()) {
-              mini_acid_.setSongPosition(row);
-            }
-          });
+          if (patternIndex < 0) {
+            mini_acid_.post(EngineCommand::clearSongPattern(row, track));
+          } else {
+            mini_acid_.post(EngineCommand::setSongPattern(row, track, patternIndex));
+          }
+          if (mini_acid_.songModeEnabled() && !mini_acid_.isPlaying()) {
+            mini_acid_.post(EngineCommand::setSongPosition(row));
+          }
         } else {
           return false;
         }
@@ -560,24 +560,22 @@ bool SongPage::handleEvent(UIEvent& ui_event) {
         }
         
         // Restore all cells from undo history
-        withAudioGuard([&]() {
-          for (const auto& cell : g_undo_history.cells) {
-            bool valid = false;
-            SongTrack song_track = trackForColumn(cell.track, valid);
-            if (valid && cell.row >= 0 && cell.row < Song::kMaxPositions) {
-              if (cell.pattern_index < 0) {
-                mini_acid_.clearSongPattern(cell.row, song_track);
-              } else {
-                mini_acid_.setSongPattern(cell.row, song_track, cell.pattern_index);
-              }
+        for (const auto& cell : g_undo_history.cells) {
+          bool valid = false;
+          SongTrack song_track = trackForColumn(cell.track, valid);
+          if (valid && cell.row >= 0 && cell.row < Song::kMaxPositions) {
+            if (cell.pattern_index < 0) {
+              mini_acid_.post(EngineCommand::clearSongPattern(cell.row, song_track));
+            } else {
+              mini_acid_.post(EngineCommand::setSongPattern(cell.row, song_track, cell.pattern_index));
             }
           }
-          if (mini_acid_.songModeEnabled() && !mini_acid_.isPlaying()) {
-            if (!g_undo_history.cells.empty()) {
-              mini_acid_.setSongPosition(g_undo_history.cells[0].row);
-            }
+        }
+        if (mini_acid_.songModeEnabled() && !mini_acid_.isPlaying()) {
+          if (!g_undo_history.cells.empty()) {
+            mini_acid_.post(EngineCommand::setSongPosition(g_undo_history.cells[0].row));
           }
-        });
+        }
         
         // Clear undo history after use
         g_undo_history.clear();
@@ -674,7 +672,7 @@ void SongPage::draw(IGfx& gfx) {
   int cursor_row = cursorRow();
   int playhead = mini_acid_.songPlayheadPosition();
   bool playingSong = mini_acid_.isPlaying() && mini_acid_.songModeEnabled();
-  bool loopMode = mini_acid_.loopModeEnabled();
+  bool loopMode = loopModeEnabled();
 
   if (playingSong) {
     int minTarget = std::min(cursor_row, playhead);
@@ -712,8 +710,8 @@ void SongPage::draw(IGfx& gfx) {
   gfx.drawText(lenX, body_y, lenBuf);
 
   if (loopMode) {
-    int loopStart = mini_acid_.loopStartRow();
-    int loopEnd = mini_acid_.loopEndRow();
+    int loopStart = loopStartRow();
+    int loopEnd = loopEndRow();
     char loopBuf[24];
     snprintf(loopBuf, sizeof(loopBuf), "LOOP %d-%d", loopStart + 1, loopEnd + 1);
     int loopX = lenX + lenW + 8;
@@ -7,7 +7,7 @@
 
 class SongPage : public IPage, public IMultiHelpFramesProvider {
  public:
-  SongPage(IGfx& gfx, MiniAcid& mini_acid, AudioGuard& audio_guard);
+  SongPage(IGfx& gfx, MiniAcid& mini_acid);
   void draw(IGfx& gfx) override;
   bool handleEvent(UIEvent& ui_event) override;
   const std::string & getTitle() const override;
@@ -26,7 +26,6 @@ class SongPage : public IPage, public IMultiHelpFramesProvider {
   void moveCursorHorizontal(int delta, bool extend_selection);
   void moveCursorVertical(int delta, bool extend_selection);
   void syncSongPositionToCursor();
-  void withAudioGuard(const std::function<void()>& fn);
   void startSelection();
   void updateSelection();
   void clearSelection();
@@ -41,16 +40,26 @@ class SongPage : public IPage, public IMultiHelpFramesProvider {
   bool clearPattern();
   bool toggleSongMode();
   bool toggleLoopMode();
+  // Loop state as this page last set it, until the engine has applied the
+  // edit; the engine's own state after that.
+  bool loopModeEnabled();
+  int loopStartRow();
+  int loopEndRow();
+  void postLoop(bool enabled, int start_row, int end_row);
 
   IGfx& gfx_;
   MiniAcid& mini_acid_;
-  AudioGuard& audio_guard_;
   int cursor_row_;
   int cursor_track_;
   int scroll_row_;
   bool has_selection_;
   int selection_start_row_;
   int selection_start_track_;
+  bool loop_pending_ = false;
+  uint32_t loop_command_ = 0;
+  bool loop_mode_ = false;
+  int loop_start_row_ = 0;
+  int loop_end_row_ = 0;
   Container mode_button_container_;
   bool mode_button_initialized_ = false;
 };
@@ -181,10 +181,9 @@ class Synth303ParamsPage::LabelValueComponent : public FocusableComponent {
   IGfxColor value_color_;
 };
 
-Synth303ParamsPage::Synth303ParamsPage(IGfx& gfx, MiniAcid& mini_acid, AudioGuard& audio_guard, int voice_index) :
+Synth303ParamsPage::Synth303ParamsPage(IGfx& gfx, MiniAcid& mini_acid, int voice_index) :
     gfx_(gfx),
     mini_acid_(mini_acid),
-    audio_guard_(audio_guard),
     voice_index_(voice_index)
 {
   title_ = voice_index_ == 0 ? "303A PARAMS" : "303B PARAMS";
@@ -207,33 +206,29 @@ void Synth303ParamsPage::initComponents() {
       pCut, COLOR_KNOB_1, COLOR_KNOB_1,
       [this](int direction) {
         int steps = 5;
-        withAudioGuard([&]() {
-          mini_acid_.adjust303Parameter(TB303ParamId::Cutoff, steps * direction, voice_index_);
-        });
+        mini_acid_.post(
+          EngineCommand::adjust303Parameter(TB303ParamId::Cutoff, steps * direction, voice_index_));
       });
   resonance_knob_ = std::make_shared<KnobComponent>(
       pRes, COLOR_KNOB_2, COLOR_KNOB_2,
       [this](int direction) {
         int steps = 5;
-        withAudioGuard([&]() {
-          mini_acid_.adjust303Parameter(TB303ParamId::Resonance, steps * direction, voice_index_);
-        });
+        mini_acid_.post(
+          EngineCommand::adjust303Parameter(TB303ParamId::Resonance, steps * direction, voice_index_));
       });
   env_amount_knob_ = std::make_shared<KnobComponent>(
       pEnv, COLOR_KNOB_3, COLOR_KNOB_3,
       [this](int direction) {
         int steps = 5;
-        withAudioGuard([&]() {
-          mini_acid_.adjust303Parameter(TB303ParamId::EnvAmount, steps * direction, voice_index_);
-        });
+        mini_acid_.post(
+          EngineCommand::adjust303Parameter(TB303ParamId::EnvAmount, steps * direction, voice_index_));
       });
   env_decay_knob_ = std::make_shared<KnobComponent>(
       pDec, COLOR_KNOB_4, COLOR_KNOB_4,
       [this](int direction) {
         int steps = 5;
-        withAudioGuard([&]() {
-          mini_acid_.adjust303Parameter(TB303ParamId::EnvDecay, steps * direction, voice_index_);
-        });
+        mini_acid_.post(
+          EngineCommand::adjust303Parameter(TB303ParamId::EnvDecay, steps * direction, voice_index_));
       });
   osc_control_ = std::make_shared<LabelValueComponent>("OSC:", COLOR_WHITE,
                                                        IGfxColor::Cyan());
@@ -297,32 +292,18 @@ void Synth303ParamsPage::adjustFocusedElement(int direction) {
     return;
   }
   if (osc_control_ && osc_control_->isFocused()) {
-    withAudioGuard([&]() {
-      mini_acid_.adjust303Parameter(TB303ParamId::Oscillator, direction, voice_index_);
-    });
+    mini_acid_.post(EngineCommand::adjust303Parameter(TB303ParamId::Oscillator, direction, voice_index_));
     return;
   }
   if (filter_control_ && filter_control_->isFocused()) {
-    withAudioGuard([&]() {
-      mini_acid_.adjust303Parameter(TB303ParamId::FilterType, direction, voice_index_);
-    });
+    mini_acid_.post(EngineCommand::adjust303Parameter(TB303ParamId::FilterType, direction, voice_index_));
     return;
   }
   if (delay_control_ && delay_control_->isFocused()) {
-    bool enabled = mini_acid_.is303DelayEnabled(voice_index_);
-    if ((direction > 0 && !enabled) || (direction < 0 && enabled)) {
-      withAudioGuard([&]() {
-        mini_acid_.toggleDelay303(voice_index_);
-      });
-    }
+    mini_acid_.post(EngineCommand::setDelay303Enabled(voice_index_, direction > 0));
   }
   if (distortion_control_ && distortion_control_->isFocused()) {
-    bool enabled = mini_acid_.is303DistortionEnabled(voice_index_);
-    if ((direction > 0 && !enabled) || (direction < 0 && enabled)) {
-      withAudioGuard([&]() {
-        mini_acid_.toggleDistortion303(voice_index_);
-      });
-    }
+    mini_acid_.post(EngineCommand::setDistortion303Enabled(voice_index_, direction > 0));
   }
 }
 
@@ -438,14 +419,6 @@ void Synth303ParamsPage::draw(IGfx& gfx) {
   Container::draw(gfx_);
 }
 
-void Synth303ParamsPage::withAudioGuard(const std::function<void()>& fn) {
-  if (audio_guard_) {
-    audio_guard_(fn);
-    return;
-  }
-  fn();
-}
-
 const std::string& Synth303ParamsPage::getTitle() const
 {
   return title_;
@@ -477,15 +450,11 @@ bool Synth303ParamsPage::handleEvent(UIEvent& ui_event)
   bool event_handled = false;
   switch(ui_event.key){
     case 't':
-      withAudioGuard([&]() {
-        mini_acid_.adjust303Parameter(TB303ParamId::Oscillator, 1, voice_index_);
-      });
+      mini_acid_.post(EngineCommand::adjust303Parameter(TB303ParamId::Oscillator, 1, voice_index_));
       event_handled = true;
       break;
     case 'g':
-      withAudioGuard([&]() {
-        mini_acid_.adjust303Parameter(TB303ParamId::Oscillator, -1, voice_index_);
-      });
+      mini_acid_.post(EngineCommand::adjust303Parameter(TB303ParamId::Oscillator, -1, voice_index_));
       event_handled = true;
       break;
     case 'a':
@@ -537,14 +506,10 @@ bool Synth303ParamsPage::handleEvent(UIEvent& ui_event)
       event_handled = true;
       break;
     case 'm':
-      withAudioGuard([&]() { 
-        mini_acid_.toggleDelay303(voice_index_);
-      });
+      mini_acid_.post(EngineCommand::toggleDelay303(voice_index_));
       break;
     case 'n':
-      withAudioGuard([&]() {
-        mini_acid_.toggleDistortion303(voice_index_);
-      });
+      mini_acid_.post(EngineCommand::toggleDistortion303(voice_index_));
       break;
     default:
       break;
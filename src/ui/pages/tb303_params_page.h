@@ -7,7 +7,7 @@
 
 class Synth303ParamsPage : public IPage, public IMultiHelpFramesProvider {
  public:
-  Synth303ParamsPage(IGfx& gfx, MiniAcid& mini_acid, AudioGuard& audio_guard, int voice_index);
+  Synth303ParamsPage(IGfx& gfx, MiniAcid& mini_acid, int voice_index);
   void draw(IGfx& gfx) override;
   bool handleEvent(UIEvent& ui_event) override;
   const std::string& getTitle() const override;
@@ -21,13 +21,11 @@ class Synth303ParamsPage : public IPage, public IMultiHelpFramesProvider {
   class KnobComponent;
   class LabelValueComponent;
 
-  void withAudioGuard(const std::function<void()>& fn);
   void adjustFocusedElement(int direction);
   void initComponents();
 
   IGfx& gfx_;
   MiniAcid& mini_acid_;
-  AudioGuard& audio_guard_;
   int voice_index_;
   bool initialized_ = false;
   std::shared_ptr<KnobComponent> cutoff_knob_;
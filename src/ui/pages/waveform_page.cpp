@@ -12,10 +12,9 @@ constexpr int kWaveFadeColorCount =
     static_cast<int>(sizeof(kWaveFadeColors) / sizeof(kWaveFadeColors[0]));
 } // namespace
 
-WaveformPage::WaveformPage(IGfx& gfx, MiniAcid& mini_acid, AudioGuard& audio_guard)
+WaveformPage::WaveformPage(IGfx& gfx, MiniAcid& mini_acid)
   : gfx_(gfx),
     mini_acid_(mini_acid),
-    audio_guard_(audio_guard),
     wave_color_index_(0)
 {
   for (int i = 0; i < kWaveHistoryLayers; ++i) {
@@ -34,8 +33,7 @@ void WaveformPage::draw(IGfx& gfx) {
   int wave_h = h - 2;
   if (w < 4 || wave_h < 4) return;
 
-  int16_t samples[AUDIO_BUFFER_SAMPLES/2];
-  size_t sampleCount = mini_acid_.copyLastAudio(samples, AUDIO_BUFFER_SAMPLES/2);
+  size_t sampleCount = mini_acid_.copyLastAudio(scope_samples_, kScopeWindowSamples);
   int mid_y = wave_y + wave_h / 2;
 
   gfx_.setTextColor(IGfxColor::Orange());
@@ -47,7 +45,7 @@ void WaveformPage::draw(IGfx& gfx) {
     int16_t new_wave[kMaxWavePoints];
     for (int px = 0; px < points; ++px) {
       size_t idx = static_cast<size_t>((uint64_t)px * (sampleCount - 1) / (points - 1));
-      new_wave[px] = samples[idx];
+      new_wave[px] = scope_samples_[idx];
     }
 
     for (int layer = kWaveHistoryLayers - 1; layer > 0; --layer) {
@@ -8,7 +8,7 @@
 
 class WaveformPage : public IPage {
  public:
-  WaveformPage(IGfx& gfx, MiniAcid& mini_acid, AudioGuard& audio_guard);
+  WaveformPage(IGfx& gfx, MiniAcid& mini_acid);
   void draw(IGfx& gfx) override;
   bool handleEvent(UIEvent& ui_event) override;
   const std::string & getTitle() const override;
@@ -16,10 +16,12 @@ class WaveformPage : public IPage {
  private:
   IGfx& gfx_;
  MiniAcid& mini_acid_;
- AudioGuard& audio_guard_;
  int wave_color_index_;
   static constexpr int kWaveHistoryLayers = 4;
   static constexpr int kMaxWavePoints = 256;
+  // About 46 ms at 22050 Hz: a few cycles of a low bassline.
+  static constexpr int kScopeWindowSamples = 1024;
+  int16_t scope_samples_[kScopeWindowSamples];
   int16_t wave_history_[kWaveHistoryLayers][kMaxWavePoints];
   int wave_lengths_[kWaveHistoryLayers];
 };